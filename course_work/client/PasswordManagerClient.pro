@@ -7,23 +7,23 @@ TARGET = password_client
 
 # Исходные файлы
 SOURCES += \
-    common_utils.cpp \
-    hashTableUrers.cpp \
-    userHashTable.cpp \
-    register.cpp \
-    log_in.cpp \
+    vaultKeyCache.cpp \
+    vaultSearchIndex.cpp \
+    offlineVaultCache.cpp \
+    vaultMerge.cpp \
     client.cpp \
     client_main.cpp
 
 # Заголовочные файлы
 HEADERS += \
-    common_utils.h \
-    hashTableUrers.h \
-    userHashTable.h \
-    register.h \
-    log_in.h \
-    client.h \
-    json.hpp
+    vaultKeyCache.h \
+    vaultSearchIndex.h \
+    offlineVaultCache.h \
+    vaultMerge.h \
+    client.h
+
+# Общее ядро: утилиты, таблицы, регистрация, шифрование хранилища
+include(../core/pm_core.pri)
 
 # Конфигурация libsodium
 # Попытка использовать pkg-config для автоматического определения путей
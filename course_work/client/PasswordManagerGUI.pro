@@ -11,23 +11,27 @@ TEMPLATE = app
 SOURCES += \
     gui_main.cpp \
     mainwindow.cpp \
-    common_utils.cpp \
-    hashTableUrers.cpp \
-    userHashTable.cpp \
-    register.cpp \
-    log_in.cpp \
+    asyncClient.cpp \
+    vaultListModel.cpp \
+    vaultKeyCache.cpp \
+    vaultSearchIndex.cpp \
+    offlineVaultCache.cpp \
+    vaultMerge.cpp \
     client.cpp
 
 # Заголовочные файлы
 HEADERS += \
     mainwindow.h \
-    common_utils.h \
-    hashTableUrers.h \
-    userHashTable.h \
-    register.h \
-    log_in.h \
-    client.h \
-    json.hpp
+    asyncClient.h \
+    vaultListModel.h \
+    vaultKeyCache.h \
+    vaultSearchIndex.h \
+    offlineVaultCache.h \
+    vaultMerge.h \
+    client.h
+
+# Общее ядро: утилиты, таблицы, регистрация, шифрование хранилища
+include(../core/pm_core.pri)
 
 # Конфигурация libsodium
 CONFIG += link_pkgconfig
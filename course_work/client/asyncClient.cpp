@@ -0,0 +1,83 @@
+#include "asyncClient.h"
+
+#include <QMetaObject>
+
+AsyncClient::AsyncClient(Client* client, QObject* parent)
+    : QObject(parent), client(client), worker(new QObject), lastJobId(0)
+{
+    worker->moveToThread(&thread);
+    connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread.setObjectName("ClientWorker");
+    thread.start();
+}
+
+AsyncClient::~AsyncClient()
+{
+    // Текущий шаг (например, Argon2id) прервать нельзя - дожидаемся его,
+    // остальные задачи в очереди завершатся сразу как отмененные
+    cancelAll();
+    thread.quit();
+    thread.wait();
+}
+
+int AsyncClient::run(const QString& description, Job job, Callback callback)
+{
+    auto state = std::make_shared<JobState>();
+    state->id = ++lastJobId;
+    jobs.insert(state->id, state);
+    emit busyChanged(true, description);
+
+    QMetaObject::invokeMethod(worker, [this, state, job, callback]() {
+        ClientJobResult result;
+        if (!state->cancelled.load()) {
+            client->setCancelFlag(&state->cancelled);
+            try {
+                result.success = job(*client, result);
+            } catch (const std::exception& e) {
+                result.error = QString::fromUtf8(e.what());
+            } catch (...) {
+                result.error = "Неизвестная ошибка";
+            }
+            client->setCancelFlag(nullptr);
+        }
+        result.cancelled = state->cancelled.load();
+
+        // Результат возвращается в поток GUI
+        QMetaObject::invokeMethod(this, [this, state, callback, result]() {
+            finishJob(state->id, callback, result);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+
+    return state->id;
+}
+
+void AsyncClient::cancel(int jobId)
+{
+    auto it = jobs.find(jobId);
+    if (it != jobs.end()) {
+        it.value()->cancelled.store(true);
+    }
+}
+
+void AsyncClient::cancelAll()
+{
+    for (auto& state : jobs) {
+        state->cancelled.store(true);
+    }
+}
+
+void AsyncClient::finishJob(int jobId, const Callback& callback, const ClientJobResult& result)
+{
+    jobs.remove(jobId);
+
+    // Снимаем состояние занятости до callback: он может показать диалог
+    // или сразу поставить следующую операцию
+    if (jobs.isEmpty()) {
+        emit busyChanged(false, QString());
+    }
+
+    if (callback) {
+        callback(result);
+    }
+    emit jobFinished(jobId, result.success && !result.cancelled);
+}
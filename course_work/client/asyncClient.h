@@ -0,0 +1,68 @@
+#ifndef ASYNC_CLIENT_H
+#define ASYNC_CLIENT_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "client.h"
+
+// Результат фоновой операции клиента
+struct ClientJobResult {
+    bool success = false;
+    bool cancelled = false;
+    QString error;                       // текст исключения, если операция упала
+    std::vector<std::string> seedWords;  // регистрация и восстановление пароля
+};
+
+// Выполняет операции Client (сокеты, Argon2id) в отдельном рабочем потоке,
+// чтобы окно не зависало. Операции выполняются строго по очереди, поэтому
+// Client не нужно делать потокобезопасным: пока есть активные операции,
+// GUI не должен обращаться к Client напрямую.
+class AsyncClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Выполняется в рабочем потоке
+    using Job = std::function<bool(Client& client, ClientJobResult& result)>;
+    // Вызывается в потоке GUI после завершения (в том числе после отмены)
+    using Callback = std::function<void(const ClientJobResult& result)>;
+
+    explicit AsyncClient(Client* client, QObject* parent = nullptr);
+    ~AsyncClient() override;
+
+    int run(const QString& description, Job job, Callback callback);
+
+    // Отмена срабатывает на ближайшей границе шагов (перед запросом к серверу
+    // или выводом ключа); callback всё равно будет вызван с cancelled = true
+    void cancel(int jobId);
+    void cancelAll();
+
+    bool isBusy() const { return !jobs.isEmpty(); }
+
+signals:
+    void busyChanged(bool busy, const QString& description);
+    void jobFinished(int jobId, bool success);
+
+private:
+    struct JobState {
+        int id;
+        std::atomic<bool> cancelled{false};
+    };
+
+    Client* client;
+    QThread thread;
+    QObject* worker;  // живет в рабочем потоке, через него ставятся задачи
+    QHash<int, std::shared_ptr<JobState>> jobs;
+    int lastJobId;
+
+    void finishJob(int jobId, const Callback& callback, const ClientJobResult& result);
+};
+
+#endif // ASYNC_CLIENT_H
@@ -2,7 +2,11 @@
 #include "hashTableUrers.h"
 #include "common_utils.h"
 #include "userHashTable.h"
+#include "vaultStream.h"
+#include "vaultMerge.h"
+#include "tlsChannel.h"
 
+#include <algorithm>
 #include <iostream>
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -15,17 +19,123 @@
 using namespace std;
 using json = nlohmann::json;
 
+namespace {
+
+void appendHex(string& out, const unsigned char* data, size_t len) {
+    const size_t oldSize = out.size();
+    out.resize(oldSize + len * 2 + 1);
+    sodium_bin2hex(&out[oldSize], len * 2 + 1, data, len);
+    out.pop_back();
+}
+
+// Декодирует очередной кусок hex-строки начиная с pos, не больше maxLen байт
+size_t hexChunkToBytes(const string& hex, size_t& pos, unsigned char* buf, size_t maxLen) {
+    const size_t hexLen = min(maxLen * 2, hex.size() - pos);
+    if (hexLen == 0) {
+        return 0;
+    }
+    size_t binLen = 0;
+    if (sodium_hex2bin(buf, maxLen, hex.data() + pos, hexLen, nullptr, &binLen, nullptr) != 0 ||
+        binLen * 2 != hexLen) {
+        throw runtime_error("Некорректные hex-данные хранилища");
+    }
+    pos += hexLen;
+    return binLen;
+}
+
+// Окно объединения правок по умолчанию и предел задержки между повторами
+const chrono::milliseconds DEFAULT_SYNC_DELAY(2000);
+const chrono::milliseconds MAX_SYNC_BACKOFF(60000);
+
+// Сколько раз подряд выгрузка сливается с более новой версией на сервере,
+// прежде чем отложить повтор
+const int MAX_MERGE_ATTEMPTS = 3;
+
+// Ответ getVault в JSON - хранилище в hex, вдвое больше самого запроса с ним
+const size_t MAX_RESPONSE_BYTES = 4 * MAX_MESSAGE_BYTES;
+// Свободные соединения TLS: по одному на поток GUI и фоновую синхронизацию
+const size_t MAX_IDLE_CHANNELS = 2;
+
+// Сервер ограничил частоту попыток или перегружен: учётные данные не проверялись,
+// повторить можно через retryAfter секунд
+bool isThrottled(const json& response) {
+    return response.contains("retryAfter");
+}
+
+uint64_t responseVaultVersion(const json& response) {
+    // Старый сервер версий не присылает - тогда всегда 0
+    return response.value("vaultVersion", uint64_t(0));
+}
+
+} // namespace
+
 Client::Client(const string& host, int port) 
-    : serverHost(host), serverPort(port), isLoggedIn(false), vault(nullptr), codeWord("") {
+    : serverHost(host), serverPort(port), wireCodec(&binaryWireCodec()), tlsContext(nullptr), isLoggedIn(false), vault(nullptr), cancelFlag(nullptr), codeWord(""),
+      vaultVersion(0), reconcilePending(false), syncDirty(false), syncStopping(false), syncFailures(0), syncDelay(DEFAULT_SYNC_DELAY) {
+    syncThread = thread(&Client::syncLoop, this);
 }
 
 Client::~Client() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        syncStopping = true;
+    }
+    syncCondition.notify_all();
+    syncThread.join();
+    
+    // Выход из программы без выгрузки не должен терять правки
+    savePendingEdits();
     if (vault) {
         delete vault;
     }
+    clearVaultKey();
+    
+    for (Channel* channel : idleChannels) {
+        delete channel;
+    }
+    delete tlsContext;
+}
+
+void Client::throwIfCancelled() const {
+    const atomic<bool>* flag = cancelFlag.load();
+    if (flag && flag->load()) {
+        throw runtime_error("Операция отменена");
+    }
 }
 
 json Client::sendRequest(const json& request) {
+    throwIfCancelled();
+    return exchange(request);
+}
+
+json Client::exchange(const json& request) {
+    const WireCodec& codec = *wireCodec.load();
+    string responseStr = roundTrip(codec.encode(request));
+    
+    // Старый сервер не знает бинарного протокола: он отвечает ошибкой в JSON,
+    // не выполняя запрос, - переходим на JSON и повторяем
+    if (&codec == &binaryWireCodec() && !BinaryWireCodec::isFrame(responseStr)) {
+        wireCodec = &defaultWireCodec();
+        responseStr = roundTrip(defaultWireCodec().encode(request));
+        return defaultWireCodec().decode(responseStr);
+    }
+    
+    // Разбираем ответ
+    return codec.decode(responseStr);
+}
+
+void Client::enableTls(const string& caPath) {
+    TlsContext* context = TlsContext::createClient(caPath);
+    lock_guard<mutex> lock(channelMutex);
+    for (Channel* channel : idleChannels) {
+        delete channel;
+    }
+    idleChannels.clear();
+    delete tlsContext;
+    tlsContext = context;
+}
+
+int Client::connectToServer() {
     // Создаем сокет
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock < 0) {
@@ -48,59 +158,204 @@ json Client::sendRequest(const json& request) {
         throw runtime_error("Не удалось подключиться к серверу");
     }
     
-    // Отправляем запрос
-    string requestStr = request.dump();
-    send(sock, requestStr.c_str(), requestStr.length(), 0);
-    
-    // Получаем ответ
-    char buffer[8192];
-    memset(buffer, 0, sizeof(buffer));
-    int bytesRead = recv(sock, buffer, sizeof(buffer) - 1, 0);
-    
-    close(sock);
-    
-    if (bytesRead <= 0) {
-        throw runtime_error("Не получен ответ от сервера");
+    return sock;
+}
+
+// Открытое соединение - на один запрос. Соединение TLS после ответа
+// возвращается в пул, а новое возобновляет сессию без полного рукопожатия
+Channel* Client::takeChannel(bool& reused) {
+    reused = false;
+    TlsContext* context = nullptr;
+    {
+        lock_guard<mutex> lock(channelMutex);
+        context = tlsContext;
+        if (context && !idleChannels.empty()) {
+            Channel* channel = idleChannels.back();
+            idleChannels.pop_back();
+            reused = true;
+            return channel;
+        }
     }
     
-    // Парсим ответ
-    json response = json::parse(buffer);
-    return response;
+    int sock = connectToServer();
+    if (!context) {
+        return new Channel(sock);
+    }
+    TlsChannel* channel = new TlsChannel(*context, sock);
+    if (!channel->connect(serverHost)) {
+        string error = channel->error();
+        delete channel;
+        throw runtime_error("Не удалось установить защищённое соединение: " + error);
+    }
+    return channel;
+}
+
+void Client::releaseChannel(Channel* channel) {
+    {
+        lock_guard<mutex> lock(channelMutex);
+        if (tlsContext && idleChannels.size() < MAX_IDLE_CHANNELS) {
+            idleChannels.push_back(channel);
+            return;
+        }
+    }
+    delete channel;
+}
+
+string Client::roundTrip(const string& requestStr) {
+    for (int attempt = 0; ; attempt++) {
+        bool reused = false;
+        Channel* channel = takeChannel(reused);
+        
+        // Отправляем запрос целиком и читаем один ответ: кадр по длине, JSON - до конца объекта
+        string response;
+        bool binary = false;
+        ReadStatus status = ReadStatus::Closed;
+        if (channel->sendAll(requestStr.data(), requestStr.size())) {
+            status = readMessage(*channel, response, binary, MAX_RESPONSE_BYTES);
+        }
+        if (status == ReadStatus::Ok) {
+            releaseChannel(channel);
+            return response;
+        }
+        delete channel;
+        
+        // Сервер закрывает простаивающие соединения TLS, не прочитав запрос, -
+        // повторяем на новом соединении
+        if (reused && status == ReadStatus::Closed && attempt == 0) {
+            continue;
+        }
+        throw runtime_error(status == ReadStatus::Closed ? "Не получен ответ от сервера"
+                                                         : "Ошибка получения ответа от сервера");
+    }
 }
 
 vector<unsigned char> Client::deriveVaultKey(const string& codeWord, const string& vaultSaltHex) {
     auto vaultSalt = hexToBytes(vaultSaltHex);
-    return hashPasswordArgon2id(codeWord, vaultSalt);
+    lock_guard<mutex> lock(keyMutex);
+    
+    // Argon2id SENSITIVE дорогой - для той же соли и кодового слова берем ключ из кэша
+    vector<unsigned char> key;
+    if (keyCache.lookup(codeWord, vaultSalt, key)) {
+        return key;
+    }
+    
+    throwIfCancelled();
+    key = hashPasswordArgon2id(codeWord, vaultSalt);
+    keyCache.store(codeWord, vaultSalt, key);
+    return key;
+}
+
+// Готовит ключ сессии один раз (для AES-GCM — с разложенным расписанием ключа),
+// исходный вектор с ключом затирается
+void Client::setVaultKey(vector<unsigned char>& key, const string& vaultSaltHex) {
+    shared_ptr<VaultCipher> cipher = make_shared<VaultCipher>(key);
+    sodium_memzero(key.data(), key.size());
+    
+    // Подмена под блокировкой: фоновая выгрузка видит либо старый ключ с его солью,
+    // либо новый. Старый ключ освобождается, когда его отпустит последняя расшифровка
+    lock_guard<mutex> lock(stateMutex);
+    vaultCipher = move(cipher);
+    sessionVaultSaltHex = vaultSaltHex;
+}
+
+shared_ptr<VaultCipher> Client::currentCipher() const {
+    lock_guard<mutex> lock(stateMutex);
+    return vaultCipher;
 }
 
-void Client::decryptAndLoadVault(const string& encryptedVaultHex) {
+void Client::clearVaultKey() {
+    lock_guard<mutex> lock(stateMutex);
+    vaultCipher.reset();
+    sessionVaultSaltHex.clear();
+}
+
+void Client::loadVaultKey(const string& codeWord, const string& vaultSaltHex) {
+    auto key = deriveVaultKey(codeWord, vaultSaltHex);
+    setVaultKey(key, vaultSaltHex);
+}
+
+UserHashTable* Client::decryptVault(const string& encryptedVaultHex) {
     if (encryptedVaultHex.empty()) {
         // Пустое хранилище - создаем новое
-        if (vault) {
-            delete vault;
-        }
-        vault = new UserHashTable();
-        return;
+        return new UserHashTable();
     }
     
-    auto encryptedVault = hexToBytes(encryptedVaultHex);
-    string decryptedJson = decrypt_aes_gcm(encryptedVault, vaultKey);
+    // Расшифровка идёт без stateMutex, поэтому ключ держится своей копией указателя
+    shared_ptr<VaultCipher> cipher = currentCipher();
+    if (!cipher) {
+        throw runtime_error("Ключ хранилища не задан");
+    }
+    return decryptVault(encryptedVaultHex, *cipher);
+}
+
+UserHashTable* Client::decryptVault(const string& encryptedVaultHex, const VaultCipher& cipher) {
+    if (encryptedVaultHex.empty()) {
+        return new UserHashTable();
+    }
     
+    json vaultJson;
+    auto prefix = hexToBytes(encryptedVaultHex.substr(0, 10));
+    if (isVaultStream(prefix.data(), prefix.size())) {
+        // Потоковый формат: hex декодируется и расшифровывается блоками прямо
+        // во время разбора JSON, целиком в памяти держится только сам hex
+        size_t hexPos = 0;
+        VaultDecryptBuf decryptBuf(cipher, [&encryptedVaultHex, &hexPos](unsigned char* buf, size_t maxLen) {
+            return hexChunkToBytes(encryptedVaultHex, hexPos, buf, maxLen);
+        });
+        istream in(&decryptBuf);
+        vaultJson = json::parse(in);
+    } else {
+        auto encryptedVault = hexToBytes(encryptedVaultHex);
+        vaultJson = json::parse(decrypt_aes_gcm(encryptedVault, cipher));
+    }
+    
+    UserHashTable* loaded = new UserHashTable();
+    loaded->fromJson(vaultJson);
+    return loaded;
+}
+
+void Client::decryptAndLoadVault(const string& encryptedVaultHex, uint64_t version) {
+    UserHashTable* loaded = decryptVault(encryptedVaultHex);
+    lock_guard<mutex> lock(stateMutex);
+    replaceVault(loaded);
+    vaultVersion = version;
+    baseVaultHex = encryptedVaultHex;
+}
+
+void Client::replaceVault(UserHashTable* table) {
     if (vault) {
         delete vault;
     }
-    vault = new UserHashTable();
-    
-    json vaultJson = json::parse(decryptedJson);
-    vault->fromJson(vaultJson);
+    vault = table;
+    if (vault) {
+        vault->addObserver(&searchIndex);
+        for (auto* observer : vaultObservers) {
+            vault->addObserver(observer);
+        }
+    } else {
+        searchIndex.clear();
+        for (auto* observer : vaultObservers) {
+            observer->entriesReset();
+        }
+    }
 }
 
 string Client::encryptVault() {
-    json vaultJson = vault->toJson();
-    string vaultStr = vaultJson.dump();
+    // JSON сериализуется сразу в шифратор, а шифротекст блоками кодируется в hex,
+    // поэтому ни открытый текст, ни бинарный шифротекст целиком не собираются
+    if (!vaultCipher) {
+        throw runtime_error("Ключ хранилища не задан");
+    }
     
-    auto encryptedVault = encrypt_aes_gcm(vaultStr, vaultKey);
-    return toHex(encryptedVault);
+    string encryptedVaultHex;
+    VaultEncryptBuf encryptBuf(*vaultCipher, [&encryptedVaultHex](const unsigned char* data, size_t len) {
+        appendHex(encryptedVaultHex, data, len);
+    });
+    ostream out(&encryptBuf);
+    out.exceptions(ios::badbit);  // ошибки шифрования не должны теряться внутри ostream
+    out << vault->toJson();
+    encryptBuf.finish();
+    return encryptedVaultHex;
 }
 
 bool Client::validateCodeWordWithVault(const string& codeWord, const string& vaultSaltHex, const string& encryptedVaultHex, string& decryptedJson) {
@@ -114,8 +369,10 @@ bool Client::validateCodeWordWithVault(const string& codeWord, const string& vau
     try {
         // Пытаемся расшифровать с предоставленным кодовым словом
         auto vaultKey = deriveVaultKey(codeWord, vaultSaltHex);
+        VaultCipher cipher(vaultKey);
+        sodium_memzero(vaultKey.data(), vaultKey.size());
         auto encryptedVault = hexToBytes(encryptedVaultHex);
-        decryptedJson = decrypt_aes_gcm(encryptedVault, vaultKey);
+        decryptedJson = decrypt_aes_gcm(encryptedVault, cipher);
         return true;
     } catch (const exception& e) {
         // Неверное кодовое слово
@@ -212,27 +469,28 @@ bool Client::registerUser(const string& user, const string& pass, const string&
                 seedWords.push_back(word);
             }
             
-            // Сохраняем кодовое слово в памяти для шифрования хранилища
-            this->codeWord = codeWord;
-            this->username = user;
-            this->password = pass;
-            
             // Получаем vaultSalt из ответа
             string vaultSaltHex = response["vaultSalt"];
             
-            // Создаем пустое хранилище
-            if (vault) {
-                delete vault;
+            {
+                lock_guard<mutex> lock(stateMutex);
+                
+                // Сохраняем кодовое слово в памяти для шифрования хранилища
+                this->codeWord = codeWord;
+                this->username = user;
+                this->password = pass;
+                
+                // Создаем пустое хранилище
+                replaceVault(new UserHashTable());
             }
-            vault = new UserHashTable();
             
             // Вычисляем ключ для шифрования хранилища с кодовым словом
-            vaultKey = deriveVaultKey(codeWord, vaultSaltHex);
+            loadVaultKey(codeWord, vaultSaltHex);
             
             // Шифруем пустое хранилище с кодовым словом
             json emptyVault = json::array();
             string vaultJson = emptyVault.dump();
-            auto encryptedVault = encrypt_aes_gcm(vaultJson, vaultKey);
+            auto encryptedVault = encrypt_aes_gcm(vaultJson, *currentCipher());
             string encryptedVaultHex = toHex(encryptedVault);
             
             // Отправляем зашифрованное хранилище на сервер
@@ -248,6 +506,12 @@ bool Client::registerUser(const string& user, const string& pass, const string&
                 return false;
             }
             
+            {
+                lock_guard<mutex> lock(stateMutex);
+                vaultVersion = responseVaultVersion(updateResponse);
+                baseVaultHex = encryptedVaultHex;
+            }
+            offlineCache.store(user, vaultSaltHex, encryptedVaultHex, responseVaultVersion(updateResponse));
             return true;
         } else {
             return false;
@@ -265,28 +529,45 @@ bool Client::login(const string& user, const string& pass, const string& codeWor
             return false;
         }
         
+        if (throttledFor().count() > 0) {
+            return false;
+        }
+        
         json request;
         request["action"] = "login";
         request["username"] = user;
         request["password"] = pass;
         
         json response = sendRequest(request);
+        if (isThrottled(response)) {
+            noteThrottled(response);
+            return false;
+        }
         
         if (response["status"] == "success") {
-            username = user;
-            password = pass;
-            this->codeWord = codeWord;
-            isLoggedIn = true;
+            {
+                lock_guard<mutex> lock(stateMutex);
+                username = user;
+                password = pass;
+                this->codeWord = codeWord;
+                isLoggedIn = true;
+            }
             
             // Получаем vaultSalt из ответа сервера
             string vaultSaltHex = response["vaultSalt"];
             
             // Вычисляем ключ для расшифровки хранилища используя кодовое слово
-            vaultKey = deriveVaultKey(codeWord, vaultSaltHex);
+            loadVaultKey(codeWord, vaultSaltHex);
             
             // Расшифровываем и загружаем хранилище
             string encryptedVaultHex = response["vaultData"];
-            decryptAndLoadVault(encryptedVaultHex);
+            decryptAndLoadVault(encryptedVaultHex, responseVaultVersion(response));
+            
+            // Следующий вход откроет эту копию без сервера (с правками, если они остались
+            // с прошлого раза, - тогда кэш уже записан)
+            if (!restorePendingEdits(user, codeWord)) {
+                offlineCache.store(user, vaultSaltHex, encryptedVaultHex, responseVaultVersion(response));
+            }
             
             return true;
         } else {
@@ -297,7 +578,214 @@ bool Client::login(const string& user, const string& pass, const string& codeWor
     }
 }
 
+bool Client::unlockCached(const string& user, const string& pass, const string& codeWord) {
+    try {
+        string errorMessage;
+        if (!validateCodeWord(codeWord, errorMessage)) {
+            return false;
+        }
+        
+        string vaultSaltHex;
+        string encryptedVaultHex;
+        string pendingVaultHex;
+        uint64_t cachedVersion = 0;
+        if (!offlineCache.load(user, vaultSaltHex, encryptedVaultHex, cachedVersion, pendingVaultHex)) {
+            return false;
+        }
+        
+        // Неверное кодовое слово не пройдёт проверку тега AEAD при расшифровке.
+        // Невыгруженные правки открываются сразу, база остаётся для слияния с сервером
+        loadVaultKey(codeWord, vaultSaltHex);
+        UserHashTable* loaded = decryptVault(pendingVaultHex.empty() ? encryptedVaultHex : pendingVaultHex);
+        
+        {
+            lock_guard<mutex> lock(stateMutex);
+            username = user;
+            password = pass;
+            this->codeWord = codeWord;
+            isLoggedIn = true;
+            replaceVault(loaded);
+            
+            // Пароль проверит сервер при сверке в фоновом потоке
+            vaultVersion = cachedVersion;
+            baseVaultHex = encryptedVaultHex;
+            reconcilePending = true;
+            syncDirty = !pendingVaultHex.empty();  // выгрузятся после сверки
+            syncFailures = 0;
+            syncDeadline = chrono::steady_clock::now();
+        }
+        syncCondition.notify_all();
+        return true;
+    } catch (const exception& e) {
+        clearVaultKey();
+        return false;
+    }
+}
+
+bool Client::isReconciled() const {
+    lock_guard<mutex> lock(stateMutex);
+    return isLoggedIn && !reconcilePending;
+}
+
+void Client::setReconcileCallback(function<void(bool accepted)> callback) {
+    lock_guard<mutex> lock(stateMutex);
+    reconcileCallback = move(callback);
+}
+
+// Сверка хранилища, открытого из кэша, с сервером. Если на сервере другая версия,
+// она сливается с локальной копией так же, как при конфликте выгрузки
+Client::ReconcileResult Client::reconcileWithServer() {
+    lock_guard<mutex> upload(uploadMutex);
+    
+    json request;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (!isLoggedIn) {
+            return ReconcileResult::Synced;
+        }
+        request["action"] = "getVault";
+        request["username"] = username;
+        request["password"] = password;
+    }
+    
+    json response;
+    try {
+        response = exchange(request);
+    } catch (const exception& e) {
+        return ReconcileResult::Offline;
+    }
+    if (isThrottled(response)) {
+        // Пароль не проверялся: лимит попыток может выбрать кто угодно, выход из-за него
+        // позволил бы завершить чужой сеанс
+        noteThrottled(response);
+        return ReconcileResult::Offline;
+    }
+    if (response["status"] != "success") {
+        return ReconcileResult::Rejected;
+    }
+    
+    try {
+        string vaultSaltHex = response["vaultSalt"];
+        string encryptedVaultHex = response["vaultData"];
+        {
+            lock_guard<mutex> lock(stateMutex);
+            if (vaultSaltHex == sessionVaultSaltHex && encryptedVaultHex == baseVaultHex) {
+                vaultVersion = responseVaultVersion(response);
+                return ReconcileResult::Synced;
+            }
+        }
+    } catch (const exception& e) {
+        return ReconcileResult::Synced;
+    }
+    
+    // Если серверную копию открыть не удалось, остаёмся на локальной
+    mergeServerVault(response);
+    return ReconcileResult::Synced;
+}
+
+// Применяет к открытому хранилищу изменения из серверной копии (vaultData, vaultSalt,
+// vaultVersion в ответе). Локальные правки сохраняются, признак syncDirty не меняется.
+// Вызывается под uploadMutex
+bool Client::mergeServerVault(const json& response) {
+    UserHashTable* base = nullptr;
+    UserHashTable* remote = nullptr;
+    try {
+        string vaultSaltHex = response["vaultSalt"];
+        string remoteVaultHex = response["vaultData"];
+        const uint64_t remoteVersion = responseVaultVersion(response);
+        
+        string localBaseHex;
+        string pendingVaultHex;
+        string currentSaltHex;
+        string userCodeWord;
+        string user;
+        {
+            lock_guard<mutex> lock(stateMutex);
+            if (!isLoggedIn) {
+                return false;
+            }
+            localBaseHex = baseVaultHex;
+            currentSaltHex = sessionVaultSaltHex;
+            userCodeWord = codeWord;
+            user = username;
+        }
+        
+        // База зашифрована текущим ключом, поэтому расшифровывается до смены соли
+        try {
+            base = decryptVault(localBaseHex);
+        } catch (const exception& e) {
+            base = new UserHashTable();  // базы нет - все локальные записи считаются своими
+        }
+        
+        // Соль сменилась (пароль меняли с другого устройства) - нужен новый ключ
+        if (vaultSaltHex != currentSaltHex) {
+            loadVaultKey(userCodeWord, vaultSaltHex);
+        }
+        remote = decryptVault(remoteVaultHex);
+        
+        {
+            lock_guard<mutex> lock(stateMutex);
+            if (!isLoggedIn || !vault) {
+                delete base;
+                delete remote;
+                return false;
+            }
+            mergeVaults(*vault, *base, *remote);
+            vaultVersion = remoteVersion;
+            baseVaultHex = remoteVaultHex;
+            
+            // Невыгруженные правки остаются в кэше поверх новой базы
+            if (syncDirty) {
+                pendingVaultHex = encryptVault();
+            }
+        }
+        delete base;
+        delete remote;
+        
+        offlineCache.store(user, vaultSaltHex, remoteVaultHex, remoteVersion, pendingVaultHex);
+        return true;
+    } catch (const exception& e) {
+        delete base;
+        delete remote;
+        return false;
+    }
+}
+
+// Версия проверяется, чтобы не затереть правки другого устройства. Конфликт
+// значит, что хранилище изменили до смены пароля и его свежая копия ещё
+// зашифрована старым ключом: она перешифровывается и выгружается заново.
+// vaultHex - выгружаемая копия, после конфликта заменяется перешифрованной
+json Client::uploadReencryptedVault(const string& user, const string& newPassword,
+                                    const string& codeWord, const string& oldVaultSaltHex,
+                                    const vector<unsigned char>& newVaultKey,
+                                    uint64_t baseVersion, string& vaultHex) {
+    for (int attempt = 1; ; attempt++) {
+        json updateRequest;
+        updateRequest["action"] = "updateVault";
+        updateRequest["username"] = user;
+        updateRequest["password"] = newPassword;
+        updateRequest["baseVersion"] = baseVersion;
+        updateRequest["vaultData"] = vaultHex;
+        
+        json updateResponse = sendRequest(updateRequest);
+        if (updateResponse["status"] != "conflict" || attempt >= MAX_MERGE_ATTEMPTS) {
+            return updateResponse;
+        }
+        
+        string decryptedJson;
+        if (!validateCodeWordWithVault(codeWord, oldVaultSaltHex, updateResponse.value("vaultData", ""), decryptedJson)) {
+            return updateResponse;
+        }
+        vaultHex = toHex(encrypt_aes_gcm(decryptedJson, newVaultKey));
+        baseVersion = responseVaultVersion(updateResponse);
+    }
+}
+
 bool Client::changePassword(const string& seedPhrase, const string& newPassword, const string& codeWord) {
+    // Хранилище перезагружается с сервера под новым ключом - сначала выгружаем правки
+    flushSync();
+    // Фоновая выгрузка и сверка не должны идти со старым паролем или ключом посреди смены
+    lock_guard<mutex> upload(uploadMutex);
     try {
         // Validate code word
         string errorMessage;
@@ -343,29 +831,34 @@ bool Client::changePassword(const string& seedPhrase, const string& newPassword,
             // Шифруем данные с новым ключом
             // ВАЖНО: Используем то же кодовое слово, но с новой солью
             auto newVaultKey = deriveVaultKey(codeWord, newVaultSaltHex);
-            auto reEncryptedVault = encrypt_aes_gcm(decryptedJson, newVaultKey);
-            string reEncryptedVaultHex = toHex(reEncryptedVault);
+            string reEncryptedVaultHex = toHex(encrypt_aes_gcm(decryptedJson, newVaultKey));
             
             // Отправляем обратно зашифрованные данные на сервер
-            json updateRequest;
-            updateRequest["action"] = "updateVault";
-            updateRequest["username"] = username;
-            updateRequest["password"] = newPassword;
-            updateRequest["vaultData"] = reEncryptedVaultHex;
-            
-            json updateResponse = sendRequest(updateRequest);
+            json updateResponse;
+            try {
+                updateResponse = uploadReencryptedVault(username, newPassword, codeWord, currentVaultSaltHex, newVaultKey,
+                                                        responseVaultVersion(getVaultResponse), reEncryptedVaultHex);
+            } catch (...) {
+                sodium_memzero(newVaultKey.data(), newVaultKey.size());
+                throw;
+            }
             
             if (updateResponse["status"] != "success") {
+                sodium_memzero(newVaultKey.data(), newVaultKey.size());
                 return false;
             }
             
             // Обновляем локальные данные
-            password = newPassword;
-            this->codeWord = codeWord;
-            vaultKey = newVaultKey;
+            {
+                lock_guard<mutex> lock(stateMutex);
+                password = newPassword;
+                this->codeWord = codeWord;
+            }
+            setVaultKey(newVaultKey, newVaultSaltHex);
             
             // Перезагружаем vault с новым ключом
-            decryptAndLoadVault(reEncryptedVaultHex);
+            decryptAndLoadVault(reEncryptedVaultHex, responseVaultVersion(updateResponse));
+            offlineCache.store(username, newVaultSaltHex, reEncryptedVaultHex, responseVaultVersion(updateResponse));
             
             return true;
         } else {
@@ -409,6 +902,8 @@ bool Client::recoverPassword(const string& user, const string& seedPhrase, const
 }
 
 bool Client::recoverPassword(const string& user, const string& seedPhrase, const string& newPassword, const string& codeWord, vector<string>& newSeedWords) {
+    // Соль и хранилище на сервере меняются - выгрузки и сверка ждут окончания
+    lock_guard<mutex> upload(uploadMutex);
     try {
         // Validate code word
         string errorMessage;
@@ -463,22 +958,24 @@ bool Client::recoverPassword(const string& user, const string& seedPhrase, const
             // Шифруем данные с новым ключом
             // ВАЖНО: Используем то же кодовое слово, но с новой солью
             auto newVaultKey = deriveVaultKey(codeWord, newVaultSaltHex);
-            auto reEncryptedVault = encrypt_aes_gcm(decryptedJson, newVaultKey);
-            string reEncryptedVaultHex = toHex(reEncryptedVault);
+            string reEncryptedVaultHex = toHex(encrypt_aes_gcm(decryptedJson, newVaultKey));
             
             // Отправляем обратно зашифрованные данные на сервер
-            json updateRequest;
-            updateRequest["action"] = "updateVault";
-            updateRequest["username"] = user;
-            updateRequest["password"] = newPassword;
-            updateRequest["vaultData"] = reEncryptedVaultHex;
-            
-            json updateResponse = sendRequest(updateRequest);
+            json updateResponse;
+            try {
+                updateResponse = uploadReencryptedVault(user, newPassword, codeWord, currentVaultSaltHex, newVaultKey,
+                                                        responseVaultVersion(getVaultResponse), reEncryptedVaultHex);
+            } catch (...) {
+                sodium_memzero(newVaultKey.data(), newVaultKey.size());
+                throw;
+            }
+            sodium_memzero(newVaultKey.data(), newVaultKey.size());
             
             if (updateResponse["status"] != "success") {
                 return false;
             }
             
+            offlineCache.store(user, newVaultSaltHex, reEncryptedVaultHex, responseVaultVersion(updateResponse));
             return true;
         } else {
             return false;
@@ -490,19 +987,31 @@ bool Client::recoverPassword(const string& user, const string& seedPhrase, const
 
 void Client::logout() {
     if (isLoggedIn && vault) {
-        // Синхронизируем данные перед выходом
-        syncToServer();
+        // Выгружаем отложенные правки перед выходом
+        flushSync();
     }
     
-    isLoggedIn = false;
-    username.clear();
-    password.clear();
-    codeWord.clear();  // Очищаем кодовое слово
-    vaultKey.clear();
-    
-    if (vault) {
-        delete vault;
-        vault = nullptr;
+    {
+        // Дожидаемся выгрузки, которую мог начать фоновый поток
+        lock_guard<mutex> upload(uploadMutex);
+        lock_guard<mutex> lock(stateMutex);
+        isLoggedIn = false;
+        syncDirty = false;
+        syncFailures = 0;
+        reconcilePending = false;
+        vaultVersion = 0;
+        baseVaultHex.clear();
+        username.clear();
+        password.clear();
+        codeWord.clear();  // Очищаем кодовое слово
+        
+        replaceVault(nullptr);
+    }
+    clearVaultKey();   // Затираем ключ хранилища и подготовленное состояние AES
+    {
+        // Фоновый поток может выводить ключ и класть его в кэш в это же время
+        lock_guard<mutex> lock(keyMutex);
+        keyCache.clear();
     }
 }
 
@@ -517,10 +1026,6 @@ void Client::displayAllEntries() {
 bool Client::addEntry(const string& service, const string& login, 
                      const string& password, const string& url, 
                      const string& note) {
-    if (!isLoggedIn || !vault) {
-        return false;
-    }
-    
     // Получаем текущее время
     auto now = chrono::system_clock::now();
     auto now_c = chrono::system_clock::to_time_t(now);
@@ -528,7 +1033,18 @@ bool Client::addEntry(const string& service, const string& login,
     ss << put_time(localtime(&now_c), "%Y-%m-%d %H:%M:%S");
     string lastModified = ss.str();
     
-    if (vault->insert(service, lastModified, login, password, url, note)) {
+    bool inserted;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        // Хранилище может подменить фоновая сверка или синхронизация
+        if (!isLoggedIn || !vault) {
+            return false;
+        }
+        inserted = vault->insert(service, lastModified, login, password, url, note);
+    }
+    
+    if (inserted) {
+        scheduleSync();
         return true;
     } else {
         return false;
@@ -538,11 +1054,6 @@ bool Client::addEntry(const string& service, const string& login,
 bool Client::updateEntryFull(const string& service, const string& login,
                              const string& newPassword, const string& newUrl, 
                              const string& newNote) {
-    if (!isLoggedIn || !vault) {
-        return false;
-    }
-    
-    // Для обновления в UserHashTable нужно удалить и снова добавить
     // Получаем текущее время
     auto now = chrono::system_clock::now();
     auto now_c = chrono::system_clock::to_time_t(now);
@@ -550,9 +1061,19 @@ bool Client::updateEntryFull(const string& service, const string& login,
     ss << put_time(localtime(&now_c), "%Y-%m-%d %H:%M:%S");
     string lastModified = ss.str();
     
-    // Удаляем старую запись (если есть функция deleteEntry в UserHashTable)
-    // Затем добавляем обновленную
-    if (vault->insert(service, lastModified, login, newPassword, newUrl, newNote)) {
+    // Запись обновляется на месте (id сохраняется); если её уже нет - например,
+    // удалена при слиянии с сервером, - заново не создаётся
+    bool updated;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (!isLoggedIn || !vault) {
+            return false;
+        }
+        updated = vault->update(service, lastModified, login, newPassword, newUrl, newNote);
+    }
+    
+    if (updated) {
+        scheduleSync();
         return true;
     } else {
         return false;
@@ -560,12 +1081,18 @@ bool Client::updateEntryFull(const string& service, const string& login,
 }
 
 bool Client::deleteEntry(const string& service, const string& login) {
-    if (!isLoggedIn || !vault) {
-        return false;
+    // Используем метод remove из UserHashTable
+    bool removed;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (!isLoggedIn || !vault) {
+            return false;
+        }
+        removed = vault->remove(service, login);
     }
     
-    // Используем метод remove из UserHashTable
-    if (vault->remove(service, login)) {
+    if (removed) {
+        scheduleSync();
         return true;
     } else {
         return false;
@@ -573,53 +1100,323 @@ bool Client::deleteEntry(const string& service, const string& login) {
 }
 
 bool Client::syncToServer() {
-    if (!isLoggedIn || !vault) {
-        return false;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (!isLoggedIn || !vault) {
+            return false;
+        }
+        syncDirty = true;
     }
     
-    try {
-        string encryptedVault = encryptVault();
-        
+    return uploadVault();
+}
+
+void Client::scheduleSync() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (!isLoggedIn) {
+            return;
+        }
+        // Каждая новая правка сдвигает выгрузку: серия правок уходит одним запросом
+        syncDirty = true;
+        syncFailures = 0;
+        syncDeadline = chrono::steady_clock::now() + syncDelay;
+    }
+    syncCondition.notify_all();
+}
+
+bool Client::flushSync() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (!syncDirty) {
+            return true;
+        }
+    }
+    return uploadVault();
+}
+
+bool Client::hasPendingSync() const {
+    lock_guard<mutex> lock(stateMutex);
+    return syncDirty;
+}
+
+void Client::setSyncDelay(chrono::milliseconds delay) {
+    lock_guard<mutex> lock(stateMutex);
+    syncDelay = delay;
+}
+
+// Снимок хранилища шифруется под stateMutex, сетевой запрос идёт уже без него,
+// чтобы правки и чтение хранилища не ждали сервер. Выгрузка идёт поверх известной
+// версии; если сервер успел принять другую, правки сливаются с ней и выгружаются снова
+bool Client::uploadVault() {
+    lock_guard<mutex> upload(uploadMutex);
+    
+    bool success = false;
+    for (int attempt = 0; attempt < MAX_MERGE_ATTEMPTS && !success; attempt++) {
         json request;
-        request["action"] = "updateVault";
-        request["username"] = username;
-        request["password"] = password;
-        request["vaultData"] = encryptedVault;
+        string vaultSaltHex;
+        {
+            lock_guard<mutex> lock(stateMutex);
+            if (!syncDirty) {
+                return true;  // уже выгружено другим вызовом
+            }
+            if (!isLoggedIn || !vault || !vaultCipher) {
+                syncDirty = false;
+                return false;
+            }
+            
+            request["action"] = "updateVault";
+            request["username"] = username;
+            request["password"] = password;
+            request["baseVersion"] = vaultVersion;
+            vaultSaltHex = sessionVaultSaltHex;
+            try {
+                request["vaultData"] = encryptVault();
+            } catch (const exception& e) {
+                request.clear();
+            }
+            syncDirty = false;
+        }
+        if (request.empty()) {
+            break;
+        }
         
-        json response = sendRequest(request);
+        json response;
+        try {
+            response = exchange(request);
+        } catch (const exception& e) {
+            break;
+        }
         
         if (response["status"] == "success") {
-            return true;
+            success = true;
+            const uint64_t version = responseVaultVersion(response);
+            {
+                lock_guard<mutex> lock(stateMutex);
+                vaultVersion = version;
+                baseVaultHex = request["vaultData"];
+            }
+            offlineCache.store(request["username"], vaultSaltHex, request["vaultData"], version);
+        } else if (isThrottled(response)) {
+            noteThrottled(response);
+            break;
+        } else if (response["status"] == "conflict") {
+            // Правки ещё не выгружены: слитое хранилище уходит следующей попыткой
+            // поверх новой версии
+            {
+                lock_guard<mutex> lock(stateMutex);
+                syncDirty = isLoggedIn;
+            }
+            if (!mergeServerVault(response)) {
+                break;
+            }
         } else {
-            return false;
+            break;
         }
-    } catch (const exception& e) {
-        return false;
     }
+    
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (success) {
+            syncFailures = 0;
+        } else if (isLoggedIn) {
+            // Повтор с экспоненциальной задержкой; новые правки задержку сбрасывают
+            syncDirty = true;
+            syncFailures++;
+            auto backoff = syncDelay * (1LL << min(syncFailures, 16));
+            syncDeadline = max(chrono::steady_clock::now() + min<chrono::milliseconds>(backoff, MAX_SYNC_BACKOFF), retryNotBefore);
+        }
+    }
+    if (!success) {
+        savePendingEdits();
+    }
+    syncCondition.notify_all();
+    return success;
 }
 
-bool Client::syncFromServer() {
-    if (!isLoggedIn) {
+void Client::noteThrottled(const json& response) {
+    const auto wait = chrono::seconds(max<int64_t>(response.value("retryAfter", int64_t(1)), 1));
+    lock_guard<mutex> lock(stateMutex);
+    retryNotBefore = max(retryNotBefore, chrono::steady_clock::now() + wait);
+}
+
+chrono::seconds Client::throttledFor() const {
+    lock_guard<mutex> lock(stateMutex);
+    const auto left = retryNotBefore - chrono::steady_clock::now();
+    return left > chrono::steady_clock::duration::zero() ? chrono::ceil<chrono::seconds>(left) : chrono::seconds(0);
+}
+
+void Client::savePendingEdits() {
+    string user;
+    string vaultSaltHex;
+    string baseHex;
+    string pendingHex;
+    uint64_t baseVersion;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (!isLoggedIn || !vault || !vaultCipher || !syncDirty) {
+            return;
+        }
+        try {
+            pendingHex = encryptVault();
+        } catch (const exception& e) {
+            return;
+        }
+        user = username;
+        vaultSaltHex = sessionVaultSaltHex;
+        baseHex = baseVaultHex;
+        baseVersion = vaultVersion;
+    }
+    offlineCache.store(user, vaultSaltHex, baseHex, baseVersion, pendingHex);
+}
+
+// Правки, оставшиеся в кэше с прошлого раза, сливаются с только что загруженной копией
+// сервера так же, как при конфликте выгрузки: общая база - копия, от которой они сделаны
+bool Client::restorePendingEdits(const string& user, const string& userCodeWord) {
+    string cachedSaltHex;
+    string cachedBaseHex;
+    string pendingHex;
+    uint64_t cachedVersion = 0;
+    if (!offlineCache.load(user, cachedSaltHex, cachedBaseHex, cachedVersion, pendingHex) || pendingHex.empty()) {
         return false;
     }
     
+    UserHashTable* base = nullptr;
+    UserHashTable* pending = nullptr;
+    try {
+        // Соль могла смениться с тех пор - правки расшифровываются ключом своей соли
+        auto key = deriveVaultKey(userCodeWord, cachedSaltHex);
+        VaultCipher cipher(key);
+        sodium_memzero(key.data(), key.size());
+        pending = decryptVault(pendingHex, cipher);
+        base = decryptVault(cachedBaseHex, cipher);
+        
+        {
+            lock_guard<mutex> lock(stateMutex);
+            if (!isLoggedIn || !vault) {
+                delete base;
+                delete pending;
+                return false;
+            }
+            mergeVaults(*vault, *base, *pending);
+            syncDirty = true;
+            syncFailures = 0;
+            syncDeadline = chrono::steady_clock::now();
+        }
+        delete base;
+        delete pending;
+    } catch (const exception& e) {
+        delete base;
+        delete pending;
+        return false;  // правки остаются в кэше до следующей попытки
+    }
+    
+    syncCondition.notify_all();
+    savePendingEdits();
+    return true;
+}
+
+void Client::syncLoop() {
+    unique_lock<mutex> lock(stateMutex);
+    while (!syncStopping) {
+        // Сверка открытого из кэша хранилища идёт раньше выгрузок
+        if (reconcilePending) {
+            if (chrono::steady_clock::now() < syncDeadline) {
+                syncCondition.wait_until(lock, syncDeadline);
+                continue;
+            }
+            
+            lock.unlock();
+            ReconcileResult result = reconcileWithServer();
+            lock.lock();
+            if (!reconcilePending) {
+                continue;  // пока шла сверка, был выход
+            }
+            
+            if (result == ReconcileResult::Offline) {
+                // Сервер недоступен - работаем с локальной копией и пробуем позже
+                syncFailures++;
+                auto backoff = syncDelay * (1LL << min(syncFailures, 16));
+                syncDeadline = max(chrono::steady_clock::now() + min<chrono::milliseconds>(backoff, MAX_SYNC_BACKOFF), retryNotBefore);
+                continue;
+            }
+            
+            reconcilePending = false;
+            syncFailures = 0;
+            syncDeadline = chrono::steady_clock::now() + syncDelay;
+            auto callback = reconcileCallback;
+            lock.unlock();
+            if (callback) {
+                callback(result == ReconcileResult::Synced);
+            }
+            lock.lock();
+            continue;
+        }
+        
+        if (!syncDirty) {
+            syncCondition.wait(lock);
+            continue;
+        }
+        if (chrono::steady_clock::now() < syncDeadline) {
+            syncCondition.wait_until(lock, syncDeadline);
+            continue;
+        }
+        
+        lock.unlock();
+        uploadVault();
+        lock.lock();
+    }
+}
+
+bool Client::syncFromServer() {
+    // Хранилище и ключ подменяются целиком - не посреди выгрузки или сверки
+    lock_guard<mutex> upload(uploadMutex);
+    
     try {
         json request;
-        request["action"] = "getVault";
-        request["username"] = username;
-        request["password"] = password;
+        string user;
+        string userCodeWord;
+        string currentSaltHex;
+        bool haveKey;
+        {
+            lock_guard<mutex> lock(stateMutex);
+            if (!isLoggedIn) {
+                return false;
+            }
+            request["action"] = "getVault";
+            request["username"] = username;
+            request["password"] = password;
+            user = username;
+            userCodeWord = codeWord;
+            currentSaltHex = sessionVaultSaltHex;
+            haveKey = vaultCipher != nullptr;
+        }
         
         json response = sendRequest(request);
         
         if (response["status"] == "success") {
-            // Обновляем vaultKey если нужно
+            // Невыгруженные правки не затираются копией сервера, а сливаются с ней
+            bool localChanges;
+            {
+                lock_guard<mutex> lock(stateMutex);
+                localChanges = syncDirty;
+            }
+            if (localChanges) {
+                return mergeServerVault(response);
+            }
+            
+            // Ключ пересчитывается только если соль на сервере изменилась
             if (response.contains("vaultSalt")) {
                 string vaultSaltHex = response["vaultSalt"];
-                vaultKey = deriveVaultKey(codeWord, vaultSaltHex);
+                if (!haveKey || vaultSaltHex != currentSaltHex) {
+                    loadVaultKey(userCodeWord, vaultSaltHex);
+                    currentSaltHex = vaultSaltHex;
+                }
             }
             
             string encryptedVaultHex = response["vaultData"];
-            decryptAndLoadVault(encryptedVaultHex);
+            decryptAndLoadVault(encryptedVaultHex, responseVaultVersion(response));
+            offlineCache.store(user, currentSaltHex, encryptedVaultHex, responseVaultVersion(response));
             return true;
         } else {
             return false;
@@ -630,8 +1427,68 @@ bool Client::syncFromServer() {
 }
 
 json Client::getVaultEntries() const {
+    lock_guard<mutex> lock(stateMutex);
     if (!vault) {
         return json::array();
     }
     return vault->toJson();
 }
+
+bool Client::getEntry(size_t id, UserHashTable::Entry& entry) const {
+    lock_guard<mutex> lock(stateMutex);
+    if (!vault) {
+        return false;
+    }
+    const UserHashTable::Entry* found = vault->findById(id);
+    if (!found) {
+        return false;
+    }
+    entry = *found;
+    return true;
+}
+
+bool Client::findEntry(const string& service, const string& login, UserHashTable::Entry& entry) const {
+    lock_guard<mutex> lock(stateMutex);
+    if (!vault) {
+        return false;
+    }
+    const UserHashTable::Entry* found = vault->find(service, login);
+    if (!found) {
+        return false;
+    }
+    entry = *found;
+    return true;
+}
+
+void Client::forEachEntry(const function<void(const UserHashTable::Entry&)>& visit) const {
+    lock_guard<mutex> lock(stateMutex);
+    if (vault) {
+        vault->forEach(visit);
+    }
+}
+
+vector<size_t> Client::searchEntries(const string& query, size_t limit) const {
+    lock_guard<mutex> lock(stateMutex);
+    if (!vault) {
+        return {};
+    }
+    return searchIndex.search(query, limit);
+}
+
+void Client::addVaultObserver(UserHashTable::Observer* observer) {
+    lock_guard<mutex> lock(stateMutex);
+    vaultObservers.push_back(observer);
+    if (vault) {
+        vault->addObserver(observer);
+    } else {
+        observer->entriesReset();
+    }
+}
+
+void Client::removeVaultObserver(UserHashTable::Observer* observer) {
+    lock_guard<mutex> lock(stateMutex);
+    vaultObservers.erase(remove(vaultObservers.begin(), vaultObservers.end(), observer), vaultObservers.end());
+    if (vault) {
+        vault->removeObserver(observer);
+    }
+}
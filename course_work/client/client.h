@@ -1,33 +1,122 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include "json.hpp"
 #include "userHashTable.h"
+#include "vaultStream.h"
+#include "vaultKeyCache.h"
+#include "vaultSearchIndex.h"
+#include "offlineVaultCache.h"
+#include "wireCodec.h"
+#include "messageChannel.h"
+
+class TlsContext;
 
 class Client {
 private:
     std::string serverHost;
     int serverPort;
+    std::atomic<const WireCodec*> wireCodec;  // кодирование запросов и разбор ответов (по умолчанию бинарный протокол)
+    
+    // TLS (если включён): свободные соединения остаются открытыми для следующих запросов
+    TlsContext* tlsContext;
+    std::mutex channelMutex;
+    std::vector<Channel*> idleChannels;
     std::string username;
     std::string password;
     std::string codeWord;  // Кодовое слово для шифрования хранилища (не сохраняется)
     bool isLoggedIn;
     
     UserHashTable* vault;
-    std::vector<unsigned char> vaultKey;
+    VaultSearchIndex searchIndex;  // обновляется вместе с vault
+    std::vector<UserHashTable::Observer*> vaultObservers;  // подписчики извне (список в GUI)
+    // Ключ хранилища на сессию (затирается при выходе). Меняется под stateMutex;
+    // расшифровка без блокировки работает с копией указателя (currentCipher),
+    // так что подмена ключа не освобождает его посреди работы
+    std::shared_ptr<VaultCipher> vaultCipher;
+    std::string sessionVaultSaltHex;  // Соль, из которой выведен текущий ключ (под stateMutex)
+    VaultKeyCache keyCache;           // Выведенные ключи, чтобы не повторять Argon2id
+    std::mutex keyMutex;              // keyCache и вывод ключа (из рабочего и фонового потоков)
+    std::atomic<const std::atomic<bool>*> cancelFlag;  // Отмена текущей операции (см. setCancelFlag)
+    
+    // Последнее известное состояние хранилища на сервере: версия и зашифрованная
+    // копия. Выгрузка идёт с этой версией; если сервер уже дальше, копия служит
+    // общей базой для трёхстороннего слияния (см. vaultMerge.h)
+    uint64_t vaultVersion;
+    std::string baseVaultHex;
+    
+    // Хранилище, открытое из локального кэша, сверяется с сервером в фоновом
+    // потоке раньше любых выгрузок
+    OfflineVaultCache offlineCache;
+    bool reconcilePending;
+    std::function<void(bool accepted)> reconcileCallback;
+    
+    // Фоновая синхронизация: правки помечают хранилище изменённым, поток
+    // выгружает его одним запросом, когда правки затихли на syncDelay
+    mutable std::mutex stateMutex;  // vault, vaultCipher, учётные данные, состояние синхронизации
+    std::mutex uploadMutex;         // выгрузки, сверка и смена ключа хранилища идут строго по очереди
+    std::condition_variable syncCondition;
+    std::thread syncThread;
+    bool syncDirty;
+    bool syncStopping;
+    int syncFailures;
+    std::chrono::milliseconds syncDelay;
+    std::chrono::steady_clock::time_point syncDeadline;
+    // Сервер ограничил частоту попыток (ответ с retryAfter): до этого момента
+    // запросы с проверкой пароля не отправляются
+    std::chrono::steady_clock::time_point retryNotBefore;
+    
+    void syncLoop();
+    bool uploadVault();
+    void noteThrottled(const nlohmann::json& response);
+    
+    enum class ReconcileResult { Synced, Offline, Rejected };
+    ReconcileResult reconcileWithServer();
+    bool mergeServerVault(const nlohmann::json& response);  // ответ getVault или конфликт updateVault
+    
+    // Невыгруженные правки - в локальный кэш вместе с базой, от которой они сделаны;
+    // после входа они сливаются с копией сервера и выгружаются
+    void savePendingEdits();
+    bool restorePendingEdits(const std::string& user, const std::string& userCodeWord);
     
     // Сетевые функции
     nlohmann::json sendRequest(const nlohmann::json& request);
+    nlohmann::json exchange(const nlohmann::json& request);
+    std::string roundTrip(const std::string& requestStr);  // запрос и ответ целиком
+    int connectToServer();
+    Channel* takeChannel(bool& reused);
+    void releaseChannel(Channel* channel);
+    void throwIfCancelled() const;
     
     // Криптография
     std::vector<unsigned char> deriveVaultKey(const std::string& codeWord, const std::string& vaultSaltHex);
-    void decryptAndLoadVault(const std::string& encryptedVaultHex);
-    std::string encryptVault();
+    void setVaultKey(std::vector<unsigned char>& key, const std::string& vaultSaltHex);
+    std::shared_ptr<VaultCipher> currentCipher() const;
+    void loadVaultKey(const std::string& codeWord, const std::string& vaultSaltHex);
+    void clearVaultKey();
+    UserHashTable* decryptVault(const std::string& encryptedVaultHex);
+    static UserHashTable* decryptVault(const std::string& encryptedVaultHex, const VaultCipher& cipher);
+    void decryptAndLoadVault(const std::string& encryptedVaultHex, uint64_t version);  // копия с сервера
+    void replaceVault(UserHashTable* table);  // вызывается под stateMutex
+    std::string encryptVault();  // вызывается под stateMutex
     
     // Вспомогательная функция для валидации кодового слова путем попытки расшифровки хранилища
     bool validateCodeWordWithVault(const std::string& codeWord, const std::string& vaultSaltHex, const std::string& encryptedVaultHex, std::string& decryptedJson);
+    // Выгрузка хранилища, перешифрованного под новую соль, поверх baseVersion
+    nlohmann::json uploadReencryptedVault(const std::string& user, const std::string& newPassword,
+                                          const std::string& codeWord, const std::string& oldVaultSaltHex,
+                                          const std::vector<unsigned char>& newVaultKey,
+                                          uint64_t baseVersion, std::string& vaultHex);
     
 public:
     Client(const std::string& host = "127.0.0.1", int port = 8080);
@@ -48,6 +137,21 @@ public:
     // Login with code word for vault decryption
     bool login(const std::string& username, const std::string& password, const std::string& codeWord);
     
+    // Быстрый вход по локальной копии хранилища: оно расшифровывается без обращения
+    // к серверу, а сверка с сервером (и проверка пароля) идёт в фоновом потоке.
+    // false - кэша нет или кодовое слово не подошло, нужен обычный login
+    bool unlockCached(const std::string& username, const std::string& password, const std::string& codeWord);
+    bool isReconciled() const;
+    // Вызывается из фонового потока по итогам сверки: false - сервер отклонил учётные данные.
+    // Ограничение частоты попыток отказом не считается: сверка повторяется позже
+    void setReconcileCallback(std::function<void(bool accepted)> callback);
+    void setOfflineCacheDirectory(const std::string& directory) { offlineCache.setDirectory(directory); }
+    // Кодек должен жить дольше клиента (обычно - статический)
+    void setWireCodec(const WireCodec& codec) { wireCodec = &codec; }
+    // Соединение по TLS с проверкой сервера по сертификату из caPath
+    // (для самоподписанного - файл server.crt сервера). Вызывается до первого запроса
+    void enableTls(const std::string& caPath);
+    
     // Change password (logged in users)
     // Note: Code word CANNOT be changed - it remains the same
     bool changePassword(const std::string& seedPhrase, const std::string& newPassword, const std::string& codeWord);
@@ -77,10 +181,38 @@ public:
     bool syncToServer();
     bool syncFromServer();
     
+    // Отложенная синхронизация: серия правок в пределах окна даёт одну выгрузку,
+    // при ошибке повтор с экспоненциальной задержкой
+    void scheduleSync();
+    bool flushSync();  // выгрузить немедленно, если есть невыгруженные правки
+    bool hasPendingSync() const;
+    void setSyncDelay(std::chrono::milliseconds delay);
+    
+    // Флаг отмены выставляется из другого потока (GUI) и проверяется перед каждым
+    // сетевым запросом и перед выводом ключа; уже начатый шаг доводится до конца
+    void setCancelFlag(const std::atomic<bool>* flag) { cancelFlag = flag; }
+    
     // Утилиты
     bool isAuthenticated() const { return isLoggedIn; }
+    // Сколько ещё сервер не примет попыток входа (0 - ограничения нет)
+    std::chrono::seconds throttledFor() const;
     std::string getUsername() const { return username; }
     nlohmann::json getVaultEntries() const;
+    
+    // Доступ к отдельным записям без сборки JSON всего хранилища.
+    // Запись копируется под блокировкой: хранилище может меняться из фонового потока
+    bool getEntry(size_t id, UserHashTable::Entry& entry) const;
+    bool findEntry(const std::string& service, const std::string& login, UserHashTable::Entry& entry) const;
+    void forEachEntry(const std::function<void(const UserHashTable::Entry&)>& visit) const;
+    
+    // Поиск по сервису, логину, URL и заметке; id записей от лучшего совпадения
+    std::vector<size_t> searchEntries(const std::string& query, size_t limit = 0) const;
+    
+    // Подписка на изменения хранилища, в том числе на его замену при входе и выходе.
+    // Уведомления приходят под внутренней блокировкой и в том потоке, где изменено
+    // хранилище, поэтому из наблюдателя нельзя вызывать методы Client
+    void addVaultObserver(UserHashTable::Observer* observer);
+    void removeVaultObserver(UserHashTable::Observer* observer);
 };
 
 #endif // CLIENT_H
@@ -1,5 +1,6 @@
 #include "client.h"
 #include "common_utils.h"
+#include <fstream>
 #include <iostream>
 #include <limits>
 
@@ -160,9 +161,32 @@ int main(int argc, char* argv[]) {
         serverPort = atoi(argv[2]);
     }
     
+    if (!initCryptoRuntime()) {
+        cerr << "Ошибка инициализации libsodium" << endl;
+        return 1;
+    }
+    
     cout << "Подключение к серверу " << serverHost << ":" << serverPort << endl;
     
     Client client(serverHost, serverPort);
+    // Третий аргумент - сертификат сервера (server.crt): соединение по TLS.
+    // Без аргумента берётся server.crt из текущей директории, если он есть
+    string serverCert = argc > 3 ? argv[3] : "";
+    if (serverCert.empty() && ifstream("server.crt").good()) {
+        serverCert = "server.crt";
+    }
+    if (!serverCert.empty()) {
+        try {
+            client.enableTls(serverCert);
+        } catch (const exception& e) {
+            cerr << "Ошибка настройки TLS: " << e.what() << endl;
+            return 1;
+        }
+    } else {
+        cerr << "ВНИМАНИЕ: соединение с сервером не зашифровано, пароль передаётся открытым текстом. "
+             << "Укажите сертификат сервера третьим аргументом: " << argv[0] << " "
+             << serverHost << " " << serverPort << " server.crt" << endl;
+    }
     
     bool running = true;
     while (running) {
@@ -0,0 +1,145 @@
+// Замер скорости шифрования хранилища на текущей машине:
+// AES-256-GCM (если есть AES-NI) против XChaCha20-Poly1305 на разных размерах хранилища,
+// плюс генерация соли: старый вариант через /dev/urandom против randombytes_buf.
+#include "vaultStream.h"
+#include "common_utils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+// Повторяет op, пока не наберётся minSeconds, и возвращает МБ/с
+template <typename Op>
+double measureThroughput(size_t bytesPerOp, double minSeconds, Op op) {
+    size_t iterations = 0;
+    const auto start = Clock::now();
+    double elapsed = 0;
+    do {
+        op();
+        iterations++;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return static_cast<double>(bytesPerOp) * iterations / elapsed / (1024.0 * 1024.0);
+}
+
+// Прежняя реализация generateSaltRaw: файл открывается на каждую соль
+vector<unsigned char> generateSaltUrandom(size_t size) {
+    ifstream urandom("/dev/urandom", ios::binary);
+    if (!urandom) {
+        throw runtime_error("Cannot open /dev/urandom");
+    }
+
+    vector<unsigned char> salt(size);
+    urandom.read(reinterpret_cast<char*>(salt.data()), size);
+
+    if (urandom.gcount() != static_cast<streamsize>(size)) {
+        throw runtime_error("Failed to read enough random bytes");
+    }
+    return salt;
+}
+
+// Возвращает среднее время одной операции в наносекундах
+template <typename Op>
+double measureLatency(double minSeconds, Op op) {
+    size_t iterations = 0;
+    const auto start = Clock::now();
+    double elapsed = 0;
+    do {
+        op();
+        iterations++;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed * 1e9 / iterations;
+}
+
+void benchSaltGeneration(double minSeconds) {
+    printf("\n%-28s %12s\n", "salt (16 bytes)", "ns/op");
+
+    const double before = measureLatency(minSeconds, []() {
+        if (generateSaltUrandom(16).size() != 16) {
+            throw runtime_error("unexpected salt size");
+        }
+    });
+    const double after = measureLatency(minSeconds, []() {
+        if (generateSaltRaw(16).size() != 16) {
+            throw runtime_error("unexpected salt size");
+        }
+    });
+
+    printf("%-28s %12.0f\n", "ifstream /dev/urandom", before);
+    printf("%-28s %12.0f\n", "randombytes_buf", after);
+    printf("%-28s %11.1fx\n", "speedup", before / after);
+}
+
+void benchVaultAlgorithms(double minSeconds) {
+    vector<unsigned char> key(VAULT_KEY_BYTES);
+    randombytes_buf(key.data(), key.size());
+    // Ключ готовится один раз, как и в клиенте на время сессии
+    const VaultCipher cipher(key);
+
+    cout << "Алгоритм по умолчанию: " << vaultAlgorithmName(defaultVaultAlgorithm()) << endl;
+    printf("%-20s %12s %14s %14s\n", "algorithm", "size", "encrypt MB/s", "decrypt MB/s");
+
+    const size_t sizes[] = {4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+    const VaultAlgorithm algorithms[] = {VaultAlgorithm::Aes256Gcm, VaultAlgorithm::XChaCha20Poly1305};
+
+    for (VaultAlgorithm alg : algorithms) {
+        if (!isVaultAlgorithmAvailable(alg)) {
+            printf("%-20s недоступен на этом процессоре\n", vaultAlgorithmName(alg));
+            continue;
+        }
+        for (size_t size : sizes) {
+            vector<unsigned char> plaintext(size);
+            randombytes_buf(plaintext.data(), plaintext.size());
+            const auto blob = encryptVaultBuffer(plaintext.data(), plaintext.size(), cipher, alg);
+
+            const double encrypt = measureThroughput(size, minSeconds, [&]() {
+                auto out = encryptVaultBuffer(plaintext.data(), plaintext.size(), cipher, alg);
+                if (out.size() != blob.size()) {
+                    throw runtime_error("unexpected ciphertext size");
+                }
+            });
+            const double decrypt = measureThroughput(size, minSeconds, [&]() {
+                auto out = decryptVaultBuffer(blob.data(), blob.size(), cipher);
+                if (out.size() != size) {
+                    throw runtime_error("unexpected plaintext size");
+                }
+            });
+
+            printf("%-20s %9zu KiB %14.1f %14.1f\n", vaultAlgorithmName(alg), size / 1024, encrypt, decrypt);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!initCryptoRuntime()) {
+        cerr << "Ошибка инициализации libsodium" << endl;
+        return 1;
+    }
+
+    double minSeconds = 0.5;
+    if (argc > 1) {
+        minSeconds = atof(argv[1]);
+    }
+
+    try {
+        benchVaultAlgorithms(minSeconds);
+        benchSaltGeneration(minSeconds);
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,12 +1,12 @@
 #include "mainwindow.h"
 #include <QApplication>
 #include <iostream>
-#include <sodium.h>
+#include "common_utils.h"
 
 int main(int argc, char *argv[])
 {
     // Initialize libsodium
-    if (sodium_init() < 0) {
+    if (!initCryptoRuntime()) {
         std::cerr << "Ошибка инициализации libsodium" << std::endl;
         return 1;
     }
@@ -7,7 +7,7 @@
 #include <QGroupBox>
 #include <QScrollArea>
 #include <QTimer>
-#include <QListWidget>
+#include <QListView>
 #include <QSplitter>
 #include <QInputDialog>
 #include <QClipboard>
@@ -16,18 +16,63 @@
 #include <QSlider>
 #include <QDialog>
 #include <QProgressDialog>
+#include <QFile>
 #include <sodium.h>
 
+namespace {
+
+// The search runs on the GUI thread on every keystroke; only the best
+// matches are ranked and shown
+constexpr size_t SEARCH_RESULT_LIMIT = 200;
+
+}
+
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), loginAttempts(0), isEditingEntry(false)
+    : QMainWindow(parent), loginAttempts(0), isEditingEntry(false), connectionEncrypted(false)
 {
     client = new Client("127.0.0.1", 8080);
+    
+    // TLS by default: the server's certificate (server.crt, created by the server
+    // on first start) is named by PM_SERVER_CERT or lies next to the program.
+    // Without it the connection is unencrypted and every page says so
+    QString serverCert = QString::fromLocal8Bit(qgetenv("PM_SERVER_CERT"));
+    if (serverCert.isEmpty()) {
+        const QString bundledCert = QCoreApplication::applicationDirPath() + "/server.crt";
+        if (QFile::exists(bundledCert)) {
+            serverCert = bundledCert;
+        }
+    }
+    if (!serverCert.isEmpty()) {
+        try {
+            client->enableTls(serverCert.toStdString());
+            connectionEncrypted = true;
+        } catch (const std::exception& e) {
+            QMessageBox::warning(this, "TLS", QString::fromStdString(e.what()));
+        }
+    }
+    
+    // All network and key derivation work runs on a worker thread
+    asyncClient = new AsyncClient(client, this);
+    connect(asyncClient, &AsyncClient::busyChanged, this, &MainWindow::onClientBusyChanged);
+    
+    // A vault opened from the local cache is checked against the server
+    // in the background; the result arrives on the sync thread
+    client->setReconcileCallback([this](bool accepted) {
+        QMetaObject::invokeMethod(this, [this, accepted]() {
+            onVaultReconciled(accepted);
+        }, Qt::QueuedConnection);
+    });
+    
     setupUI();
     showMainMenu();
 }
 
 MainWindow::~MainWindow()
 {
+    // Worker must be stopped before the client it uses is destroyed,
+    // the list model unsubscribes from the client on deletion
+    delete asyncClient;
+    delete entriesModel;
     delete client;
 }
 
@@ -113,31 +158,50 @@ void MainWindow::setupUI()
         QTextEdit[readOnly="true"] {
             background-color: #f5f5f7;
         }
-        QListWidget {
+        QListView {
             background-color: #f5f5f7;
             border: none;
             border-radius: 8px;
             padding: 4px;
         }
-        QListWidget::item {
+        QListView::item {
             background-color: white;
             border-radius: 6px;
             padding: 12px;
             margin: 2px;
             color: #1d1d1f;
         }
-        QListWidget::item:selected {
+        QListView::item:selected {
             background-color: #007aff;
             color: white;
         }
-        QListWidget::item:hover {
+        QListView::item:hover {
             background-color: #e8e8ed;
         }
     )";
     setStyleSheet(appStyle);
     
-    stackedWidget = new QStackedWidget(this);
-    setCentralWidget(stackedWidget);
+    QWidget* central = new QWidget(this);
+    QVBoxLayout* centralLayout = new QVBoxLayout(central);
+    centralLayout->setContentsMargins(0, 0, 0, 0);
+    centralLayout->setSpacing(0);
+    
+    // Unencrypted connection: the warning stays above every page
+    if (!connectionEncrypted) {
+        QLabel* plaintextBanner = new QLabel(
+            "Соединение с сервером не зашифровано: пароль и фраза восстановления "
+            "передаются открытым текстом. Укажите сертификат сервера (server.crt) "
+            "в переменной PM_SERVER_CERT или положите его рядом с программой.");
+        plaintextBanner->setWordWrap(true);
+        plaintextBanner->setStyleSheet(
+            "background-color: #e74c3c; color: white; font-weight: bold; padding: 10px;"
+        );
+        centralLayout->addWidget(plaintextBanner);
+    }
+    
+    stackedWidget = new QStackedWidget(central);
+    centralLayout->addWidget(stackedWidget);
+    setCentralWidget(central);
     
     createMainMenuPage();
     createRegisterPage();
@@ -528,30 +592,44 @@ void MainWindow::createUserMenuPage()
     );
     connect(searchBox, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
     
-    // Entries list
-    entriesList = new QListWidget();
-    entriesList->setStyleSheet(
-        "QListWidget { "
+    // Entries list: the view only asks the model for rows that are visible
+    entriesModel = new VaultListModel(client, this);
+    entriesView = new QListView();
+    entriesView->setModel(entriesModel);
+    entriesView->setUniformItemSizes(true);
+    entriesView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    entriesView->setStyleSheet(
+        "QListView { "
         "background-color: transparent; "
         "border: none; "
         "}"
-        "QListWidget::item { "
+        "QListView::item { "
         "background-color: white; "
         "border-radius: 6px; "
         "padding: 12px; "
         "margin: 2px 0; "
         "color: #1d1d1f; "
         "}"
-        "QListWidget::item:selected { "
+        "QListView::item:selected { "
         "background-color: #007aff; "
         "color: white; "
         "}"
-        "QListWidget::item:hover:!selected { "
+        "QListView::item:hover:!selected { "
         "background-color: #e8e8ed; "
         "}"
     );
     
-    connect(entriesList, &QListWidget::currentTextChanged, this, &MainWindow::showEntryDetails);
+    connect(entriesView->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, &MainWindow::showEntryDetails);
+    
+    // An edited entry changes its row in place; refresh details if it is the current one
+    connect(entriesModel, &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+        QModelIndex current = entriesView->currentIndex();
+        if (current.isValid() && current.row() >= topLeft.row() && current.row() <= bottomRight.row()) {
+            showEntryDetails(current);
+        }
+    });
     
     // Add button at bottom of sidebar
     QPushButton* addBtn = new QPushButton("+ Добавить пароль");
@@ -572,7 +650,7 @@ void MainWindow::createUserMenuPage()
     sidebarLayout->addWidget(sidebarTitle);
     sidebarLayout->addWidget(searchBox);
     sidebarLayout->addSpacing(8);
-    sidebarLayout->addWidget(entriesList);
+    sidebarLayout->addWidget(entriesView);
     
     // Add utility buttons
     QPushButton* generateBtn = new QPushButton("Генератор паролей");
@@ -893,34 +971,24 @@ void MainWindow::showUserMenu()
 
 void MainWindow::updateEntriesList()
 {
-    // Clear current selection first to ensure details update correctly
-    entriesList->setCurrentRow(-1);
-    entriesList->clear();
-    
-    if (!client->isAuthenticated()) {
-        return;
-    }
-    
-    // Get actual entries from vault
-    auto vaultJson = client->getVaultEntries();
-    
-    if (vaultJson.is_array()) {
-        for (const auto& entry : vaultJson) {
-            QString service = QString::fromStdString(entry["_service"]);
-            QString login = QString::fromStdString(entry["_login"]);
-            
-            // Create list item with service and login
-            QString itemText = service;
-            if (!login.isEmpty()) {
-                itemText += " (" + login + ")";
-            }
-            
-            entriesList->addItem(itemText);
-        }
+    // Full reload, only needed on login and when the search query changes;
+    // single edits reach the model through its vault subscription
+    QString query = searchBox->text().trimmed();
+    if (query.isEmpty() || !client->isAuthenticated()) {
+        entriesModel->showAll();
+    } else {
+        // Ranked results from the client's search index
+        entriesModel->showSearchResults(client->searchEntries(query.toStdString(), SEARCH_RESULT_LIMIT));
     }
     
-    if (entriesList->count() > 0) {
-        entriesList->setCurrentRow(0);
+    if (entriesModel->rowCount() > 0) {
+        entriesView->setCurrentIndex(entriesModel->index(0));
+    } else if (!query.isEmpty()) {
+        detailServiceLabel->setText("Ничего не найдено");
+        detailLoginLabel->setText("");
+        detailPasswordLabel->setText("");
+        detailUrlLabel->setText("");
+        detailNoteLabel->setText("");
     } else {
         // Show empty state
         detailServiceLabel->setText("Пока нет паролей");
@@ -931,9 +999,29 @@ void MainWindow::updateEntriesList()
     }
 }
 
-void MainWindow::showEntryDetails(const QString& itemText)
+void MainWindow::returnToEntries()
 {
-    if (itemText.isEmpty()) {
+    // The model already holds the change, only search results have to be recomputed
+    stackedWidget->setCurrentWidget(userMenuPage);
+    entriesModel->applyPendingChanges();
+    if (!searchBox->text().trimmed().isEmpty()) {
+        updateEntriesList();
+    }
+}
+
+bool MainWindow::currentEntry(UserHashTable::Entry& entry) const
+{
+    QModelIndex index = entriesView->currentIndex();
+    if (!index.isValid()) {
+        return false;
+    }
+    return client->getEntry(entriesModel->entryId(index), entry);
+}
+
+void MainWindow::showEntryDetails(const QModelIndex& index)
+{
+    UserHashTable::Entry entry;
+    if (!index.isValid() || !client->getEntry(entriesModel->entryId(index), entry)) {
         detailServiceLabel->setText("Выберите пароль");
         detailLoginLabel->setText("");
         detailPasswordLabel->setText("••••••••");
@@ -942,56 +1030,35 @@ void MainWindow::showEntryDetails(const QString& itemText)
         return;
     }
     
-    // Get vault entries
-    auto vaultJson = client->getVaultEntries();
-    
-    if (!vaultJson.is_array()) {
-        return;
+    QString service = QString::fromStdString(entry._service);
+    QString login = QString::fromStdString(entry._login);
+    QString password = QString::fromStdString(entry._password);
+    QString url = QString::fromStdString(entry._url);
+    QString note = QString::fromStdString(entry._note);
+    
+    detailServiceLabel->setText(service);
+    detailLoginLabel->setText(login);
+    detailPasswordLabel->setText("••••••••");
+    detailPasswordLabel->setProperty("actualPassword", password);
+    
+    if (!url.isEmpty()) {
+        detailUrlLabel->setText(QString("<a href='%1' style='color: #007aff; text-decoration: underline;'>%1</a>").arg(url));
+        detailUrlLabel->setStyleSheet("font-size: 15px; padding: 8px 0;");
+        detailUrlLabel->setWordWrap(true);  // Ensure word wrap is enabled
+    } else {
+        detailUrlLabel->setText("(нет веб-сайта)");
+        detailUrlLabel->setStyleSheet("color: #86868b; font-size: 13px; padding: 8px 0; font-style: italic;");
+        detailUrlLabel->setWordWrap(true);
     }
     
-    // Find the matching entry
-    for (const auto& entry : vaultJson) {
-        QString service = QString::fromStdString(entry["_service"]);
-        QString login = QString::fromStdString(entry["_login"]);
-        
-        QString checkText = service;
-        if (!login.isEmpty()) {
-            checkText += " (" + login + ")";
-        }
-        
-        if (checkText == itemText) {
-            // Found the entry - display its details
-            QString password = QString::fromStdString(entry["_password"]);
-            QString url = QString::fromStdString(entry["_url"]);
-            QString note = QString::fromStdString(entry["_note"]);
-            
-            detailServiceLabel->setText(service);
-            detailLoginLabel->setText(login);
-            detailPasswordLabel->setText("••••••••");
-            detailPasswordLabel->setProperty("actualPassword", password);
-            
-            if (!url.isEmpty()) {
-                detailUrlLabel->setText(QString("<a href='%1' style='color: #007aff; text-decoration: underline;'>%1</a>").arg(url));
-                detailUrlLabel->setStyleSheet("font-size: 15px; padding: 8px 0;");
-                detailUrlLabel->setWordWrap(true);  // Ensure word wrap is enabled
-            } else {
-                detailUrlLabel->setText("(нет веб-сайта)");
-                detailUrlLabel->setStyleSheet("color: #86868b; font-size: 13px; padding: 8px 0; font-style: italic;");
-                detailUrlLabel->setWordWrap(true);
-            }
-            
-            if (!note.isEmpty()) {
-                detailNoteLabel->setText(note);
-            } else {
-                detailNoteLabel->setText("(нет заметок)");
-            }
-            
-            // Reset show/hide button
-            showPasswordBtn->setText("Показать");
-            
-            return;
-        }
+    if (!note.isEmpty()) {
+        detailNoteLabel->setText(note);
+    } else {
+        detailNoteLabel->setText("(нет заметок)");
     }
+    
+    // Reset show/hide button
+    showPasswordBtn->setText("Показать");
 }
 
 void MainWindow::onRegisterClicked()
@@ -1041,31 +1108,54 @@ void MainWindow::onRegisterSubmitClicked()
             return;
         }
         
-        // Check if user exists
-        if (client->checkUserExists(username.toStdString())) {
-            QMessageBox msgBox(this);
-            msgBox.setWindowTitle("Пользователь существует");
-            msgBox.setIcon(QMessageBox::Warning);
-            msgBox.setText("Пользователь с таким логином уже существует!");
-            msgBox.setInformativeText("Хотите войти в существующий аккаунт?");
-            msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-            msgBox.setDefaultButton(QMessageBox::Yes);
-            
-            QAbstractButton* yesBtn = msgBox.button(QMessageBox::Yes);
-            yesBtn->setText("Да, войти");
-            QAbstractButton* noBtn = msgBox.button(QMessageBox::No);
-            noBtn->setText("Нет");
-            
-            int reply = msgBox.exec();
-            
-            if (reply == QMessageBox::Yes) {
-                // Switch to login page with this username
-                loginUsernameEdit->setText(username);
-                onLoginClicked();
-            }
-            return;
-        }
-        
+        // Check if user exists (network request runs in background)
+        std::string user = username.toStdString();
+        runClientJob("Регистрация", "Проверка логина...",
+            [user](Client& client, ClientJobResult&) {
+                return client.checkUserExists(user);
+            },
+            [this, username, password](const ClientJobResult& result) {
+                if (result.cancelled) {
+                    return;
+                }
+                if (result.success) {
+                    QMessageBox msgBox(this);
+                    msgBox.setWindowTitle("Пользователь существует");
+                    msgBox.setIcon(QMessageBox::Warning);
+                    msgBox.setText("Пользователь с таким логином уже существует!");
+                    msgBox.setInformativeText("Хотите войти в существующий аккаунт?");
+                    msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+                    msgBox.setDefaultButton(QMessageBox::Yes);
+                    
+                    QAbstractButton* yesBtn = msgBox.button(QMessageBox::Yes);
+                    yesBtn->setText("Да, войти");
+                    QAbstractButton* noBtn = msgBox.button(QMessageBox::No);
+                    noBtn->setText("Нет");
+                    
+                    int reply = msgBox.exec();
+                    
+                    if (reply == QMessageBox::Yes) {
+                        // Switch to login page with this username
+                        loginUsernameEdit->setText(username);
+                        onLoginClicked();
+                    }
+                    return;
+                }
+                
+                continueRegistration(username, password);
+            });
+    } catch (const std::exception& e) {
+        regResultText->setText(QString("Ошибка регистрации: %1").arg(e.what()));
+        regResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
+    } catch (...) {
+        regResultText->setText("Неизвестная ошибка при регистрации. Попробуйте снова.");
+        regResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
+    }
+}
+
+void MainWindow::continueRegistration(const QString& username, const QString& password)
+{
+    try {
         // Validate password
         std::string errorMessage;
         if (!validatePassword(password.toStdString(), errorMessage)) {
@@ -1131,47 +1221,26 @@ void MainWindow::onRegisterSubmitClicked()
         }
         
         // Now register user with code word and get seed words
-        std::vector<std::string> seedWords;
-        if (client->registerUser(username.toStdString(), password.toStdString(), 
-                                codeWord.toStdString(), seedWords)) {
-            regResultText->setText("Регистрация успешна!");
-            regResultText->setStyleSheet("color: #27ae60; background-color: #d5f4e6; padding: 10px; border-radius: 5px;");
-            regPasswordEdit->clear();
-            
-            // Display seed words in a beautiful dialog
-            QString seedWordsText = "<b>Ваши слова для восстановления пароля</b><br><br>";
-            seedWordsText += "<font color='#e74c3c'><b>ВАЖНО! Сохраните эти слова в безопасном месте!</b></font><br>";
-            seedWordsText += "Они понадобятся для восстановления доступа к аккаунту.<br><br>";
-            seedWordsText += "<table style='width:100%; border-collapse: collapse;'>";
-            
-            for (size_t i = 0; i < seedWords.size(); i++) {
-                if (i % 3 == 0) seedWordsText += "<tr>";
-                seedWordsText += QString("<td style='padding: 5px; background-color: #ecf0f1; border: 1px solid #bdc3c7; font-weight: bold;'>%1. %2</td>")
-                    .arg(i + 1).arg(QString::fromStdString(seedWords[i]));
-                if (i % 3 == 2 || i == seedWords.size() - 1) seedWordsText += "</tr>";
-            }
-            seedWordsText += "</table>";
-            
-            QMessageBox seedDialog(this);
-            seedDialog.setWindowTitle("Слова для восстановления");
-            seedDialog.setIcon(QMessageBox::Information);
-            seedDialog.setText(seedWordsText);
-            seedDialog.setStandardButtons(QMessageBox::Ok);
-            seedDialog.setDefaultButton(QMessageBox::Ok);
-            seedDialog.setTextFormat(Qt::RichText);
-            
-            // Make the dialog larger to show all words nicely
-            seedDialog.setStyleSheet("QLabel{min-width: 500px; min-height: 300px;}");
-            
-            seedDialog.exec();
-            
-            QMessageBox::information(this, "Успех", 
-                "Регистрация завершена! Теперь вы можете войти в систему.");
-            showMainMenu();
-        } else {
-            regResultText->setText("Ошибка регистрации. Возможно, проблема с подключением к серверу.");
-            regResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
-        }
+        std::string user = username.toStdString();
+        std::string pass = password.toStdString();
+        std::string word = codeWord.toStdString();
+        runClientJob("Регистрация", "Создание аккаунта и шифрование хранилища...",
+            [user, pass, word](Client& client, ClientJobResult& result) {
+                return client.registerUser(user, pass, word, result.seedWords);
+            },
+            [this](const ClientJobResult& result) {
+                if (result.cancelled) {
+                    regResultText->setText("Регистрация отменена.");
+                    regResultText->setStyleSheet("color: #e67e22; background-color: #fde3cf; padding: 10px; border-radius: 5px;");
+                    return;
+                }
+                if (!result.error.isEmpty()) {
+                    regResultText->setText(QString("Ошибка регистрации: %1").arg(result.error));
+                    regResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
+                    return;
+                }
+                onRegisterFinished(result.success, result.seedWords);
+            });
     } catch (const std::exception& e) {
         regResultText->setText(QString("Ошибка регистрации: %1").arg(e.what()));
         regResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
@@ -1181,6 +1250,49 @@ void MainWindow::onRegisterSubmitClicked()
     }
 }
 
+void MainWindow::onRegisterFinished(bool success, const std::vector<std::string>& seedWords)
+{
+    if (success) {
+        regResultText->setText("Регистрация успешна!");
+        regResultText->setStyleSheet("color: #27ae60; background-color: #d5f4e6; padding: 10px; border-radius: 5px;");
+        regPasswordEdit->clear();
+        
+        // Display seed words in a beautiful dialog
+        QString seedWordsText = "<b>Ваши слова для восстановления пароля</b><br><br>";
+        seedWordsText += "<font color='#e74c3c'><b>ВАЖНО! Сохраните эти слова в безопасном месте!</b></font><br>";
+        seedWordsText += "Они понадобятся для восстановления доступа к аккаунту.<br><br>";
+        seedWordsText += "<table style='width:100%; border-collapse: collapse;'>";
+        
+        for (size_t i = 0; i < seedWords.size(); i++) {
+            if (i % 3 == 0) seedWordsText += "<tr>";
+            seedWordsText += QString("<td style='padding: 5px; background-color: #ecf0f1; border: 1px solid #bdc3c7; font-weight: bold;'>%1. %2</td>")
+                .arg(i + 1).arg(QString::fromStdString(seedWords[i]));
+            if (i % 3 == 2 || i == seedWords.size() - 1) seedWordsText += "</tr>";
+        }
+        seedWordsText += "</table>";
+        
+        QMessageBox seedDialog(this);
+        seedDialog.setWindowTitle("Слова для восстановления");
+        seedDialog.setIcon(QMessageBox::Information);
+        seedDialog.setText(seedWordsText);
+        seedDialog.setStandardButtons(QMessageBox::Ok);
+        seedDialog.setDefaultButton(QMessageBox::Ok);
+        seedDialog.setTextFormat(Qt::RichText);
+        
+        // Make the dialog larger to show all words nicely
+        seedDialog.setStyleSheet("QLabel{min-width: 500px; min-height: 300px;}");
+        
+        seedDialog.exec();
+        
+        QMessageBox::information(this, "Успех", 
+            "Регистрация завершена! Теперь вы можете войти в систему.");
+        showMainMenu();
+    } else {
+        regResultText->setText("Ошибка регистрации. Возможно, проблема с подключением к серверу.");
+        regResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
+    }
+}
+
 void MainWindow::onRegisterBackClicked()
 {
     showMainMenu();
@@ -1209,18 +1321,18 @@ void MainWindow::onLoginSubmitClicked()
     }
 }
 
-void MainWindow::performLogin(const QString& username, const QString& password)
+QProgressDialog* MainWindow::createBusyDialog(const QString& title, const QString& text)
 {
-    // Create loading dialog
-    QProgressDialog* loadingDialog = new QProgressDialog("Подключение к серверу и загрузка данных...", 
-                                                         QString(), 0, 0, this);
-    loadingDialog->setWindowTitle("Вход в систему");
-    loadingDialog->setWindowModality(Qt::WindowModal);
-    loadingDialog->setCancelButton(nullptr);  // No cancel button
-    loadingDialog->setMinimumDuration(0);  // Show immediately
+    QProgressDialog* dialog = new QProgressDialog(text, "Отмена", 0, 0, this);
+    dialog->setWindowTitle(title);
+    dialog->setWindowModality(Qt::WindowModal);
+    dialog->setMinimumDuration(0);  // Show immediately
+    // Keep the dialog open after Cancel until the job actually stops
+    dialog->setAutoClose(false);
+    dialog->setAutoReset(false);
     
     // Light background styling for better visibility
-    loadingDialog->setStyleSheet(
+    dialog->setStyleSheet(
         "QProgressDialog {"
         "    background-color: white;"
         "}"
@@ -1240,102 +1352,166 @@ void MainWindow::performLogin(const QString& username, const QString& password)
         "    border-radius: 2px;"
         "}"
     );
-    loadingDialog->setValue(0);
-    loadingDialog->show();
-    QApplication::processEvents();  // Force display
+    dialog->setValue(0);
+    dialog->show();
+    return dialog;
+}
+
+int MainWindow::runClientJob(const QString& title, const QString& text,
+                             AsyncClient::Job job, AsyncClient::Callback done)
+{
+    QProgressDialog* dialog = createBusyDialog(title, text);
     
-    try {
-        if (attemptLogin(username, password)) {
-            // Update loading message
-            loadingDialog->setLabelText("Загрузка паролей...");
-            QApplication::processEvents();
+    int jobId = asyncClient->run(text, job, [dialog, done](const ClientJobResult& result) {
+        dialog->close();
+        dialog->deleteLater();
+        if (done) {
+            done(result);
+        }
+    });
+    
+    connect(dialog, &QProgressDialog::canceled, this, [this, dialog, jobId]() {
+        // The current step (socket or Argon2id) cannot be interrupted,
+        // the job stops before the next one
+        dialog->setLabelText("Отмена операции...");
+        asyncClient->cancel(jobId);
+    });
+    
+    return jobId;
+}
+
+void MainWindow::onClientBusyChanged(bool busy, const QString& description)
+{
+    Q_UNUSED(description);
+    
+    // While a job is running the client belongs to the worker thread
+    stackedWidget->setEnabled(!busy);
+    if (busy) {
+        if (!QApplication::overrideCursor()) {
+            QApplication::setOverrideCursor(Qt::BusyCursor);
+        }
+    } else {
+        while (QApplication::overrideCursor()) {
+            QApplication::restoreOverrideCursor();
+        }
+    }
+}
+
+void MainWindow::performLogin(const QString& username, const QString& password)
+{
+    QString codeWord;
+    if (!askLoginCodeWord(codeWord)) {
+        handleLoginResult(false);
+        return;
+    }
+    
+    std::string user = username.toStdString();
+    std::string pass = password.toStdString();
+    std::string word = codeWord.toStdString();
+    
+    runClientJob("Вход в систему", "Подключение к серверу и загрузка данных...",
+        [user, pass, word](Client& client, ClientJobResult& result) {
+            // Local copy first: no network round trip or server-side hashing,
+            // the server check follows in the background
+            if (client.unlockCached(user, pass, word)) {
+                return true;
+            }
             
-            loginResultText->setText("Вход выполнен успешно!");
-            loginResultText->setStyleSheet("color: #27ae60; background-color: #d5f4e6; padding: 10px; border-radius: 5px;");
-            loginPasswordEdit->clear();
+            if (!client.login(user, pass, word)) {
+                // Rate-limited or overloaded server: the credentials were not checked
+                const long long wait = client.throttledFor().count();
+                if (wait > 0) {
+                    result.error = QString("сервер не принял попытку входа, повторите через %1 с").arg(wait);
+                }
+                return false;
+            }
             
             // Load data from server
             try {
-                client->syncFromServer();
+                client.syncFromServer();
             } catch (...) {
                 // Ignore sync errors, user is still logged in
             }
-            
-            // Close loading dialog
-            loadingDialog->close();
-            delete loadingDialog;
-            
-            // Show user menu after short delay
-            QTimer::singleShot(300, this, &MainWindow::showUserMenu);
-        } else {
-            // Close loading dialog on failure
-            loadingDialog->close();
-            delete loadingDialog;
-            
-            loginAttempts++;
-            int remaining = 3 - loginAttempts;
-            
-            if (remaining > 0) {
-                loginAttemptsLabel->setText(QString("Попыток осталось: %1").arg(remaining));
-                loginResultText->setText(QString("Неверный пароль. Осталось попыток: %1").arg(remaining));
+            return true;
+        },
+        [this](const ClientJobResult& result) {
+            if (result.cancelled) {
+                // Login may have finished before the cancel was noticed
+                if (client->isAuthenticated()) {
+                    asyncClient->run("Выход", [](Client& client, ClientJobResult&) {
+                        client.logout();
+                        return true;
+                    }, nullptr);
+                }
+                loginResultText->setText("Вход отменен.");
                 loginResultText->setStyleSheet("color: #e67e22; background-color: #fde3cf; padding: 10px; border-radius: 5px;");
-                loginPasswordEdit->clear();
-                loginPasswordEdit->setFocus();
-            } else {
-                loginAttemptsLabel->setText("Попыток осталось: 0");
-                loginAttemptsLabel->setStyleSheet("color: red; font-weight: bold;");
-                loginResultText->setText("Исчерпаны все попытки входа!\n"
-                                        "Нажмите 'Восстановить пароль' чтобы сбросить пароль.");
-                loginRecoverBtn->setVisible(true);
-                loginPasswordEdit->setEnabled(false);
+                return;
             }
-        }
-    } catch (const std::exception& e) {
-        loadingDialog->close();
-        delete loadingDialog;
-        
-        loginResultText->setText(QString("Ошибка при попытке входа: %1").arg(e.what()));
-        loginResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
-    } catch (...) {
-        loadingDialog->close();
-        delete loadingDialog;
-        
-        loginResultText->setText("Неизвестная ошибка. Проверьте подключение к серверу.");
-        loginResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
-    }
+            
+            if (!result.error.isEmpty()) {
+                loginResultText->setText(QString("Ошибка при попытке входа: %1").arg(result.error));
+                loginResultText->setStyleSheet("color: #e74c3c; background-color: #fadbd8; padding: 10px; border-radius: 5px;");
+                return;
+            }
+            
+            handleLoginResult(result.success);
+        });
 }
 
-bool MainWindow::attemptLogin(const QString& username, const QString& password)
+void MainWindow::handleLoginResult(bool success)
 {
-    try {
-        // Ask for code word before attempting login
-        QInputDialog inputDialog(this);
-        inputDialog.setWindowTitle("Кодовое слово");
-        inputDialog.setLabelText("Введите кодовое слово для расшифровки ваших данных:");
-        inputDialog.setTextValue("");
-        inputDialog.setTextEchoMode(QLineEdit::Password);
-        inputDialog.setInputMode(QInputDialog::TextInput);
-        
-        // Apply light background styling
-        inputDialog.setStyleSheet(
-            "QInputDialog { background-color: white; }"
-            "QLabel { color: #1d1d1f; background-color: transparent; }"
-            "QLineEdit { background-color: white; border: 1px solid #d1d1d6; border-radius: 4px; padding: 6px; }"
-            "QPushButton { background-color: #007aff; color: white; border: none; border-radius: 6px; padding: 8px 16px; }"
-            "QPushButton:hover { background-color: #0051d5; }"
-        );
-        
-        bool ok = (inputDialog.exec() == QDialog::Accepted);
-        QString codeWord = inputDialog.textValue();
-        
-        if (!ok || codeWord.isEmpty()) {
-            return false;
-        }
+    if (success) {
+        loginResultText->setText("Вход выполнен успешно!");
+        loginResultText->setStyleSheet("color: #27ae60; background-color: #d5f4e6; padding: 10px; border-radius: 5px;");
+        loginPasswordEdit->clear();
         
-        return client->login(username.toStdString(), password.toStdString(), codeWord.toStdString());
-    } catch (...) {
-        return false;
+        // Show user menu after short delay
+        QTimer::singleShot(300, this, &MainWindow::showUserMenu);
+        return;
     }
+    
+    loginAttempts++;
+    int remaining = 3 - loginAttempts;
+    
+    if (remaining > 0) {
+        loginAttemptsLabel->setText(QString("Попыток осталось: %1").arg(remaining));
+        loginResultText->setText(QString("Неверный пароль. Осталось попыток: %1").arg(remaining));
+        loginResultText->setStyleSheet("color: #e67e22; background-color: #fde3cf; padding: 10px; border-radius: 5px;");
+        loginPasswordEdit->clear();
+        loginPasswordEdit->setFocus();
+    } else {
+        loginAttemptsLabel->setText("Попыток осталось: 0");
+        loginAttemptsLabel->setStyleSheet("color: red; font-weight: bold;");
+        loginResultText->setText("Исчерпаны все попытки входа!\n"
+                                "Нажмите 'Восстановить пароль' чтобы сбросить пароль.");
+        loginRecoverBtn->setVisible(true);
+        loginPasswordEdit->setEnabled(false);
+    }
+}
+
+bool MainWindow::askLoginCodeWord(QString& codeWord)
+{
+    // Ask for code word before attempting login
+    QInputDialog inputDialog(this);
+    inputDialog.setWindowTitle("Кодовое слово");
+    inputDialog.setLabelText("Введите кодовое слово для расшифровки ваших данных:");
+    inputDialog.setTextValue("");
+    inputDialog.setTextEchoMode(QLineEdit::Password);
+    inputDialog.setInputMode(QInputDialog::TextInput);
+    
+    // Apply light background styling
+    inputDialog.setStyleSheet(
+        "QInputDialog { background-color: white; }"
+        "QLabel { color: #1d1d1f; background-color: transparent; }"
+        "QLineEdit { background-color: white; border: 1px solid #d1d1d6; border-radius: 4px; padding: 6px; }"
+        "QPushButton { background-color: #007aff; color: white; border: none; border-radius: 6px; padding: 8px 16px; }"
+        "QPushButton:hover { background-color: #0051d5; }"
+    );
+    
+    bool ok = (inputDialog.exec() == QDialog::Accepted);
+    codeWord = inputDialog.textValue();
+    
+    return ok && !codeWord.isEmpty();
 }
 
 void MainWindow::onLoginBackClicked()
@@ -1455,9 +1631,6 @@ void MainWindow::onRecoverySubmitClicked()
         return;
     }
     
-    // Recover password and get new seed words
-    std::vector<std::string> newSeedWords;
-    
     // Ask for code word
     QInputDialog inputDialog(this);
     inputDialog.setWindowTitle("Кодовое слово");
@@ -1488,8 +1661,27 @@ void MainWindow::onRecoverySubmitClicked()
         return;
     }
     
-    if (client->recoverPassword(username.toStdString(), seedPhrase.toStdString(), 
-                                newPassword.toStdString(), codeWord.toStdString(), newSeedWords)) {
+    std::string user = username.toStdString();
+    std::string seed = seedPhrase.toStdString();
+    std::string pass = newPassword.toStdString();
+    std::string word = codeWord.toStdString();
+    runClientJob("Восстановление пароля", "Проверка кодового слова и перешифрование хранилища...",
+        [user, seed, pass, word](Client& client, ClientJobResult& result) {
+            return client.recoverPassword(user, seed, pass, word, result.seedWords);
+        },
+        [this](const ClientJobResult& result) {
+            if (result.cancelled) {
+                recoveryResultText->setText("Восстановление отменено.");
+                recoveryResultText->setStyleSheet("color: #e67e22; background-color: #fde3cf; padding: 10px; border-radius: 5px;");
+                return;
+            }
+            onRecoveryFinished(result.success, result.seedWords);
+        });
+}
+
+void MainWindow::onRecoveryFinished(bool success, const std::vector<std::string>& newSeedWords)
+{
+    if (success) {
         
         recoveryResultText->setText("Пароль успешно восстановлен!\n"
                                    "Теперь вы можете войти с новым паролем.");
@@ -1679,11 +1871,7 @@ void MainWindow::onAddEntryPageSubmitClicked()
         );
         
         if (success) {
-            // Sync to server immediately after add
-            if (!client->syncToServer()) {
-                QMessageBox::warning(this, "Предупреждение", 
-                    "Пароль сохранён локально, но не удалось синхронизировать с сервером.");
-            }
+            // Client uploads the vault in background after a burst of edits
             QMessageBox::information(this, "Успешно", "Пароль успешно сохранён!");
         } else {
             QMessageBox::warning(this, "Ошибка", "Не удалось сохранить пароль. Попробуйте снова.");
@@ -1691,21 +1879,59 @@ void MainWindow::onAddEntryPageSubmitClicked()
     }
     
     if (success) {
-        // Go back to user menu and refresh
-        showUserMenu();
+        // Go back to the list and select the saved entry
+        returnToEntries();
+        UserHashTable::Entry saved;
+        if (client->findEntry(service.toStdString(), login.toStdString(), saved)) {
+            QModelIndex index = entriesModel->indexOf(saved._id);
+            if (index.isValid()) {
+                entriesView->setCurrentIndex(index);
+            }
+        }
     }
 }
 
 void MainWindow::onAddEntryPageCancelClicked()
 {
-    showUserMenu();
+    returnToEntries();
 }
 
 void MainWindow::onLogoutClicked()
 {
-    client->logout();
-    QMessageBox::information(this, "Выход", "Вы вышли из системы.");
-    showMainMenu();
+    // Pending edits are flushed to the server before keys are wiped
+    runClientJob("Выход", "Синхронизация и выход из системы...",
+        [](Client& client, ClientJobResult&) {
+            bool synced = client.flushSync();
+            client.logout();
+            return synced;
+        },
+        [this](const ClientJobResult& result) {
+            if (!result.success && !result.cancelled) {
+                // Unsynced edits stay in the local cache and are merged at the next login
+                QMessageBox::warning(this, "Предупреждение", 
+                    "Не удалось синхронизировать последние изменения с сервером. "
+                    "Они сохранены на этом устройстве и будут отправлены при следующем входе.");
+            }
+            QMessageBox::information(this, "Выход", "Вы вышли из системы.");
+            showMainMenu();
+        });
+}
+
+void MainWindow::onVaultReconciled(bool accepted)
+{
+    if (accepted || !client->isAuthenticated()) {
+        return;
+    }
+    
+    // The cached vault was opened with credentials the server no longer accepts
+    asyncClient->run("Выход", [](Client& client, ClientJobResult&) {
+        client.logout();
+        return true;
+    }, nullptr);
+    stackedWidget->setCurrentWidget(loginPage);
+    QMessageBox::warning(this, "Вход", 
+        "Сервер отклонил учётные данные. Войдите снова.");
+    handleLoginResult(false);
 }
 
 void MainWindow::onShowPasswordClicked()
@@ -1744,126 +1970,85 @@ void MainWindow::onCopyPasswordClicked()
 
 void MainWindow::onEditEntryClicked()
 {
-    QString currentItem = entriesList->currentItem() ? entriesList->currentItem()->text() : "";
-    if (currentItem.isEmpty()) {
+    UserHashTable::Entry entry;
+    if (!currentEntry(entry)) {
         QMessageBox::warning(this, "Редактировать", "Пожалуйста, выберите пароль для редактирования.");
         return;
     }
     
-    // Find the entry in vault
-    auto vaultJson = client->getVaultEntries();
-    if (!vaultJson.is_array()) {
-        return;
+    QString service = QString::fromStdString(entry._service);
+    QString login = QString::fromStdString(entry._login);
+    
+    // Populate form
+    isEditingEntry = true;
+    currentEditService = service;
+    currentEditLogin = login;
+    
+    addServiceEdit->setText(service);
+    addLoginEdit->setText(login);
+    addPasswordEdit->setText(QString::fromStdString(entry._password));
+    addUrlEdit->setText(QString::fromStdString(entry._url));
+    addNoteEdit->setText(QString::fromStdString(entry._note));
+    
+    // Disable service and login fields during editing (they are the key identifiers)
+    addServiceEdit->setEnabled(false);
+    addLoginEdit->setEnabled(false);
+    
+    // Update title and button text
+    QLabel* titleLabel = addEntryPage->findChild<QLabel*>();
+    if (titleLabel) {
+        titleLabel->setText("Редактирование пароля");
     }
     
-    for (const auto& entry : vaultJson) {
-        QString service = QString::fromStdString(entry["_service"]);
-        QString login = QString::fromStdString(entry["_login"]);
-        
-        QString checkText = service;
-        if (!login.isEmpty()) {
-            checkText += " (" + login + ")";
-        }
-        
-        if (checkText == currentItem) {
-            // Found the entry - populate form
-            isEditingEntry = true;
-            currentEditService = service;
-            currentEditLogin = login;
-            
-            addServiceEdit->setText(service);
-            addLoginEdit->setText(login);
-            addPasswordEdit->setText(QString::fromStdString(entry["_password"]));
-            addUrlEdit->setText(QString::fromStdString(entry["_url"]));
-            addNoteEdit->setText(QString::fromStdString(entry["_note"]));
-            
-            // Disable service and login fields during editing (they are the key identifiers)
-            addServiceEdit->setEnabled(false);
-            addLoginEdit->setEnabled(false);
-            
-            // Update title and button text
-            QLabel* titleLabel = addEntryPage->findChild<QLabel*>();
-            if (titleLabel) {
-                titleLabel->setText("Редактирование пароля");
-            }
-            
-            QPushButton* submitBtn = addEntryPage->findChildren<QPushButton*>().last();
-            if (submitBtn) {
-                submitBtn->setText("Обновить пароль");
-            }
-            
-            // Switch to add/edit page
-            stackedWidget->setCurrentWidget(addEntryPage);
-            addPasswordEdit->setFocus();
-            
-            return;
-        }
+    QPushButton* submitBtn = addEntryPage->findChildren<QPushButton*>().last();
+    if (submitBtn) {
+        submitBtn->setText("Обновить пароль");
     }
+    
+    // Switch to add/edit page
+    stackedWidget->setCurrentWidget(addEntryPage);
+    addPasswordEdit->setFocus();
 }
 
 void MainWindow::onDeleteEntryClicked()
 {
-    QString currentItem = entriesList->currentItem() ? entriesList->currentItem()->text() : "";
-    if (currentItem.isEmpty()) {
+    UserHashTable::Entry entry;
+    if (!currentEntry(entry)) {
         QMessageBox::warning(this, "Удалить", "Пожалуйста, выберите пароль для удаления.");
         return;
     }
+    QString currentItem = entriesView->currentIndex().data().toString();
     
     QMessageBox::StandardButton reply = QMessageBox::question(this, "Удалить пароль",
         QString("Вы уверены, что хотите удалить '%1'?").arg(currentItem),
         QMessageBox::Yes | QMessageBox::No);
     
     if (reply == QMessageBox::Yes) {
-        // Parse service and login from the item text
-        // Format is "ServiceName (username)"
-        int openParen = currentItem.indexOf('(');
-        int closeParen = currentItem.indexOf(')');
+        QString service = QString::fromStdString(entry._service);
         
-        if (openParen > 0 && closeParen > openParen) {
-            QString service = currentItem.left(openParen).trimmed();
-            QString login = currentItem.mid(openParen + 1, closeParen - openParen - 1).trimmed();
-            
-            // Call the deleteEntry function
-            if (client->deleteEntry(service.toStdString(), login.toStdString())) {
-                // Sync to server immediately after delete
-                if (!client->syncToServer()) {
-                    QMessageBox::warning(this, "Предупреждение", 
-                        "Запись удалена локально, но не удалось синхронизировать с сервером.");
-                }
-                
-                QMessageBox::information(this, "Успешно", 
-                    QString("Пароль '%1' успешно удален.").arg(service));
-                
-                // Refresh the entries list
+        // Service and login come from the entry itself, not from the item text
+        if (client->deleteEntry(entry._service, entry._login)) {
+            // Only the deleted row is removed; the view moves the selection
+            // to a neighbouring row and its details are shown
+            entriesModel->applyPendingChanges();
+            if (entriesModel->rowCount() == 0) {
                 updateEntriesList();
-                
-                // Clear the detail view
-                detailServiceLabel->setText("Не выбрано");
-                detailLoginLabel->setText("");
-                detailPasswordLabel->setText("");
-                detailPasswordLabel->setProperty("isVisible", false);
-                showPasswordBtn->setText("Показать");
-                detailUrlLabel->setText("");
-                detailNoteLabel->setText("");
-            } else {
-                QMessageBox::warning(this, "Ошибка", 
-                    "Не удалось удалить пароль. Попробуйте еще раз.");
             }
+            
+            // Client uploads the vault in background after a burst of edits
+            QMessageBox::information(this, "Успешно", 
+                QString("Пароль '%1' успешно удален.").arg(service));
         } else {
             QMessageBox::warning(this, "Ошибка", 
-                "Не удалось определить данные записи для удаления.");
+                "Не удалось удалить пароль. Попробуйте еще раз.");
         }
     }
 }
 
-void MainWindow::onSearchTextChanged(const QString& text)
+void MainWindow::onSearchTextChanged(const QString&)
 {
-    // Simple filter for entries list
-    for (int i = 0; i < entriesList->count(); ++i) {
-        QListWidgetItem* item = entriesList->item(i);
-        bool matches = item->text().contains(text, Qt::CaseInsensitive);
-        item->setHidden(!matches);
-    }
+    // The list is rebuilt from the search index, best matches first
+    updateEntriesList();
 }
 
 std::string MainWindow::generateCustomPassword(int length, bool useUpper, bool useLower, bool useDigits, bool useSpecial)
@@ -7,8 +7,11 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QTextEdit>
-#include <QListWidget>
+#include <QListView>
+#include <QProgressDialog>
 #include "client.h"
+#include "asyncClient.h"
+#include "vaultListModel.h"
 
 class MainWindow : public QMainWindow
 {
@@ -78,10 +81,22 @@ private:
     void showMainMenu();
     void showUserMenu();
     void performLogin(const QString& username, const QString& password);
-    bool attemptLogin(const QString& username, const QString& password);
+    bool askLoginCodeWord(QString& codeWord);
+    void handleLoginResult(bool success);
+    void onVaultReconciled(bool accepted);
+    void continueRegistration(const QString& username, const QString& password);
+    void onRegisterFinished(bool success, const std::vector<std::string>& seedWords);
+    void onRecoveryFinished(bool success, const std::vector<std::string>& newSeedWords);
+    
+    // Background client operations
+    QProgressDialog* createBusyDialog(const QString& title, const QString& text);
+    int runClientJob(const QString& title, const QString& text,
+                     AsyncClient::Job job, AsyncClient::Callback done);
+    void onClientBusyChanged(bool busy, const QString& description);
     
     QStackedWidget* stackedWidget;
     Client* client;
+    AsyncClient* asyncClient;
     
     // Main menu page
     QWidget* mainMenuPage;
@@ -116,7 +131,8 @@ private:
     
     // User menu page
     QWidget* userMenuPage;
-    QListWidget* entriesList;
+    QListView* entriesView;
+    VaultListModel* entriesModel;
     QWidget* entryDetailWidget;
     QLabel* detailServiceLabel;
     QLabel* detailLoginLabel;
@@ -137,11 +153,14 @@ private:
     QLineEdit* addUrlEdit;
     QTextEdit* addNoteEdit;
     bool isEditingEntry;
+    bool connectionEncrypted;  // TLS to the server; otherwise a warning banner is shown
     QString currentEditService;
     QString currentEditLogin;
     
     void updateEntriesList();
-    void showEntryDetails(const QString& service);
+    void showEntryDetails(const QModelIndex& index);
+    void returnToEntries();
+    bool currentEntry(UserHashTable::Entry& entry) const;
 };
 
 #endif // MAINWINDOW_H
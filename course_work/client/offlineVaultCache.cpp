@@ -0,0 +1,123 @@
+#include "offlineVaultCache.h"
+#include "json.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sodium.h>
+
+using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int CACHE_FORMAT_VERSION = 1;
+
+} // namespace
+
+OfflineVaultCache::OfflineVaultCache() : directory(defaultDirectory()) {}
+
+string OfflineVaultCache::defaultDirectory() {
+    if (const char* cacheHome = getenv("XDG_CACHE_HOME")) {
+        if (*cacheHome) {
+            return string(cacheHome) + "/password-manager";
+        }
+    }
+    if (const char* home = getenv("HOME")) {
+        if (*home) {
+            return string(home) + "/.cache/password-manager";
+        }
+    }
+    return ".";
+}
+
+void OfflineVaultCache::setDirectory(const string& dir) {
+    lock_guard<mutex> lock(fileMutex);
+    directory = dir;
+}
+
+string OfflineVaultCache::pathFor(const string& username) const {
+    // Имя пользователя в имени файла не светится и не ломает путь
+    unsigned char digest[16];
+    crypto_generichash(digest, sizeof(digest),
+                       reinterpret_cast<const unsigned char*>(username.data()), username.size(),
+                       nullptr, 0);
+    char hex[sizeof(digest) * 2 + 1];
+    sodium_bin2hex(hex, sizeof(hex), digest, sizeof(digest));
+    return directory + "/vault_" + hex + ".json";
+}
+
+bool OfflineVaultCache::load(const string& username, string& vaultSaltHex, string& vaultDataHex,
+                             uint64_t& vaultVersion, string& pendingDataHex) const {
+    lock_guard<mutex> lock(fileMutex);
+    ifstream file(pathFor(username));
+    if (!file.is_open()) {
+        return false;
+    }
+
+    try {
+        json doc = json::parse(file);
+        if (doc.value("version", 0) != CACHE_FORMAT_VERSION || doc.value("username", "") != username) {
+            return false;
+        }
+        vaultSaltHex = doc.at("vaultSalt").get<string>();
+        vaultDataHex = doc.at("vaultData").get<string>();
+        vaultVersion = doc.value("vaultVersion", uint64_t(0));
+        pendingDataHex = doc.value("pendingData", "");
+    } catch (const exception& e) {
+        return false;  // повреждённый кэш - просто идём на сервер
+    }
+    return !vaultSaltHex.empty() && (!vaultDataHex.empty() || !pendingDataHex.empty());
+}
+
+bool OfflineVaultCache::store(const string& username, const string& vaultSaltHex, const string& vaultDataHex,
+                              uint64_t vaultVersion, const string& pendingDataHex) {
+    if (username.empty() || vaultSaltHex.empty() || (vaultDataHex.empty() && pendingDataHex.empty())) {
+        return false;
+    }
+
+    json doc;
+    doc["version"] = CACHE_FORMAT_VERSION;
+    doc["username"] = username;
+    doc["vaultSalt"] = vaultSaltHex;
+    doc["vaultData"] = vaultDataHex;
+    doc["vaultVersion"] = vaultVersion;
+    if (!pendingDataHex.empty()) {
+        doc["pendingData"] = pendingDataHex;
+    }
+
+    lock_guard<mutex> lock(fileMutex);
+    error_code ec;
+    fs::create_directories(directory, ec);
+    fs::permissions(directory, fs::perms::owner_all, fs::perm_options::replace, ec);
+
+    const string path = pathFor(username);
+    const string tmpPath = path + ".tmp";
+    {
+        ofstream file(tmpPath, ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        fs::permissions(tmpPath, fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::replace, ec);
+        file << doc.dump();
+        if (!file.good()) {
+            file.close();
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+void OfflineVaultCache::remove(const string& username) {
+    lock_guard<mutex> lock(fileMutex);
+    error_code ec;
+    fs::remove(pathFor(username), ec);
+}
@@ -0,0 +1,38 @@
+#ifndef COURSEWORK_OFFLINE_VAULT_CACHE_H
+#define COURSEWORK_OFFLINE_VAULT_CACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Локальная копия последнего синхронизированного хранилища пользователя.
+// На диске лежит то же, что хранит сервер: соль и зашифрованное хранилище в
+// прежнем конверте (AES-256-GCM / XChaCha20-Poly1305), поэтому без кодового
+// слова файл бесполезен. Вместе с ним хранится версия хранилища на сервере.
+// Имя файла - хеш имени пользователя, права 0600, запись атомарная
+// (временный файл + rename).
+// Если правки не удалось выгрузить (сервер недоступен), рядом с последней
+// подтверждённой сервером копией лежит хранилище с этими правками
+// (pendingData, тем же ключом): при следующем входе оно сливается с сервером.
+class OfflineVaultCache {
+private:
+    std::string directory;
+    mutable std::mutex fileMutex;
+
+    std::string pathFor(const std::string& username) const;
+
+public:
+    // По умолчанию $XDG_CACHE_HOME/password-manager или ~/.cache/password-manager
+    OfflineVaultCache();
+    static std::string defaultDirectory();
+    void setDirectory(const std::string& dir);
+
+    bool load(const std::string& username, std::string& vaultSaltHex, std::string& vaultDataHex,
+              uint64_t& vaultVersion, std::string& pendingDataHex) const;
+    // Пустой pendingDataHex - невыгруженных правок нет
+    bool store(const std::string& username, const std::string& vaultSaltHex, const std::string& vaultDataHex,
+               uint64_t vaultVersion, const std::string& pendingDataHex = "");
+    void remove(const std::string& username);
+};
+
+#endif // COURSEWORK_OFFLINE_VAULT_CACHE_H
@@ -0,0 +1,71 @@
+#include "vaultKeyCache.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+using namespace std;
+
+constexpr size_t CACHED_KEY_BYTES = 32;
+
+struct VaultKeyCache::Secrets {
+    unsigned char tagKey[crypto_generichash_KEYBYTES];  // ключ хеша кодового слова
+    unsigned char codeWordTag[crypto_generichash_BYTES];
+    unsigned char key[CACHED_KEY_BYTES];
+};
+
+VaultKeyCache::VaultKeyCache() : secrets(nullptr), valid(false) {
+    secrets = static_cast<Secrets*>(sodium_malloc(sizeof(Secrets)));
+    if (secrets == nullptr) {
+        throw bad_alloc();
+    }
+    randombytes_buf(secrets->tagKey, sizeof(secrets->tagKey));
+}
+
+VaultKeyCache::~VaultKeyCache() {
+    // sodium_free затирает память перед освобождением
+    sodium_free(secrets);
+}
+
+void VaultKeyCache::codeWordTag(const string& codeWord, unsigned char* tag) const {
+    crypto_generichash(tag, crypto_generichash_BYTES,
+                       reinterpret_cast<const unsigned char*>(codeWord.data()), codeWord.size(),
+                       secrets->tagKey, sizeof(secrets->tagKey));
+}
+
+bool VaultKeyCache::lookup(const string& codeWord, const vector<unsigned char>& vaultSalt,
+                           vector<unsigned char>& key) const {
+    if (!valid || vaultSalt != salt) {
+        return false;
+    }
+
+    unsigned char tag[crypto_generichash_BYTES];
+    codeWordTag(codeWord, tag);
+    const bool match = sodium_memcmp(tag, secrets->codeWordTag, sizeof(tag)) == 0;
+    sodium_memzero(tag, sizeof(tag));
+    if (!match) {
+        return false;
+    }
+
+    key.assign(secrets->key, secrets->key + CACHED_KEY_BYTES);
+    return true;
+}
+
+void VaultKeyCache::store(const string& codeWord, const vector<unsigned char>& vaultSalt,
+                          const vector<unsigned char>& key) {
+    if (key.size() != CACHED_KEY_BYTES) {
+        throw invalid_argument("Invalid vault key size");
+    }
+
+    codeWordTag(codeWord, secrets->codeWordTag);
+    memcpy(secrets->key, key.data(), CACHED_KEY_BYTES);
+    salt = vaultSalt;
+    valid = true;
+}
+
+void VaultKeyCache::clear() {
+    sodium_memzero(secrets->codeWordTag, sizeof(secrets->codeWordTag));
+    sodium_memzero(secrets->key, sizeof(secrets->key));
+    salt.clear();
+    valid = false;
+}
@@ -0,0 +1,39 @@
+#ifndef COURSEWORK_VAULT_KEY_CACHE_H
+#define COURSEWORK_VAULT_KEY_CACHE_H
+
+#include <string>
+#include <vector>
+#include <sodium.h>
+
+// Кэш ключа хранилища на время сессии.
+// Argon2id по кодовому слову стоит ~1 ГиБ памяти и несколько секунд, поэтому
+// выведенный ключ запоминается вместе с солью и повторно не вычисляется,
+// пока соль не изменилась. Кодовое слово не хранится: сравнивается его хеш с
+// ключом, случайным для каждого кэша, так что неверное кодовое слово не
+// получит чужой ключ. Ключ и хеш лежат в заблокированной памяти (sodium_malloc
+// делает mlock) и затираются в clear()/деструкторе.
+class VaultKeyCache {
+private:
+    struct Secrets;
+    Secrets* secrets;
+    std::vector<unsigned char> salt;
+    bool valid;
+
+    void codeWordTag(const std::string& codeWord, unsigned char* tag) const;
+
+public:
+    VaultKeyCache();
+    ~VaultKeyCache();
+
+    VaultKeyCache(const VaultKeyCache&) = delete;
+    VaultKeyCache& operator=(const VaultKeyCache&) = delete;
+
+    // true и ключ в key, если для этой пары (кодовое слово, соль) ключ уже выведен
+    bool lookup(const std::string& codeWord, const std::vector<unsigned char>& vaultSalt,
+                std::vector<unsigned char>& key) const;
+    void store(const std::string& codeWord, const std::vector<unsigned char>& vaultSalt,
+               const std::vector<unsigned char>& key);
+    void clear();
+};
+
+#endif // COURSEWORK_VAULT_KEY_CACHE_H
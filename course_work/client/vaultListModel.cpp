@@ -0,0 +1,211 @@
+#include "vaultListModel.h"
+
+#include <QMetaObject>
+#include <algorithm>
+
+VaultListModel::VaultListModel(Client* client, QObject* parent)
+    : QAbstractListModel(parent), client(client), removedSinceRenumber(0), filtered(false),
+      pendingReset(false), applyQueued(false)
+{
+    client->addVaultObserver(this);
+}
+
+VaultListModel::~VaultListModel()
+{
+    client->removeVaultObserver(this);
+}
+
+QString VaultListModel::entryText(const UserHashTable::Entry& entry)
+{
+    QString text = QString::fromStdString(entry._service);
+    if (!entry._login.empty()) {
+        text += " (" + QString::fromStdString(entry._login) + ")";
+    }
+    return text;
+}
+
+int VaultListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+QVariant VaultListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size()) {
+        return QVariant();
+    }
+
+    const Row& row = rows[index.row()];
+    if (role == Qt::DisplayRole) {
+        return row.text;
+    }
+    if (role == EntryIdRole) {
+        return QVariant::fromValue<qulonglong>(row.id);
+    }
+    return QVariant();
+}
+
+size_t VaultListModel::entryId(const QModelIndex& index) const
+{
+    if (!index.isValid() || index.row() >= rows.size()) {
+        return 0;
+    }
+    return rows[index.row()].id;
+}
+
+QModelIndex VaultListModel::indexOf(size_t id) const
+{
+    const int row = rowOf(id);
+    return row < 0 ? QModelIndex() : index(row);
+}
+
+int VaultListModel::rowOf(size_t id) const
+{
+    auto it = rowById.constFind(id);
+    if (it == rowById.constEnd()) {
+        return -1;
+    }
+    // Строки только сдвигаются вверх, так что искать ниже сохранённого номера не нужно
+    const int lowest = std::max(0, it.value() - removedSinceRenumber);
+    for (int row = std::min(it.value(), rows.size() - 1); row >= lowest; row--) {
+        if (rows[row].id == id) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+void VaultListModel::renumberRows()
+{
+    for (int i = 0; i < rows.size(); i++) {
+        rowById[rows[i].id] = i;
+    }
+    removedSinceRenumber = 0;
+}
+
+void VaultListModel::resetRows(QVector<Row> newRows)
+{
+    beginResetModel();
+    rows = std::move(newRows);
+    rowById.clear();
+    rowById.reserve(rows.size());
+    for (int i = 0; i < rows.size(); i++) {
+        rowById.insert(rows[i].id, i);
+    }
+    removedSinceRenumber = 0;
+    endResetModel();
+}
+
+void VaultListModel::showAll()
+{
+    applyPendingChanges();
+
+    QVector<Row> newRows;
+    client->forEachEntry([&newRows](const UserHashTable::Entry& entry) {
+        newRows.append({entry._id, entryText(entry)});
+    });
+    filtered = false;
+    resetRows(std::move(newRows));
+}
+
+void VaultListModel::showSearchResults(const std::vector<size_t>& ids)
+{
+    applyPendingChanges();
+
+    QVector<Row> newRows;
+    newRows.reserve(ids.size());
+    UserHashTable::Entry entry;
+    for (size_t id : ids) {
+        if (client->getEntry(id, entry)) {
+            newRows.append({id, entryText(entry)});
+        }
+    }
+    filtered = true;
+    resetRows(std::move(newRows));
+}
+
+void VaultListModel::entryStored(const UserHashTable::Entry& entry)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    // После замены хранилища список всё равно перечитывается целиком
+    if (pendingReset) {
+        return;
+    }
+    pending.push_back({entry._id, entryText(entry), false});
+    queueApply();
+}
+
+void VaultListModel::entryRemoved(size_t id)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (pendingReset) {
+        return;
+    }
+    pending.push_back({id, QString(), true});
+    queueApply();
+}
+
+void VaultListModel::entriesReset()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.clear();
+    pendingReset = true;
+    queueApply();
+}
+
+void VaultListModel::queueApply()
+{
+    if (applyQueued) {
+        return;
+    }
+    applyQueued = true;
+    // Серия уведомлений применяется одним вызовом в потоке GUI
+    QMetaObject::invokeMethod(this, [this]() {
+        applyPendingChanges();
+    }, Qt::QueuedConnection);
+}
+
+void VaultListModel::applyPendingChanges()
+{
+    std::vector<Change> changes;
+    bool reset;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        changes.swap(pending);
+        reset = pendingReset;
+        pendingReset = false;
+        applyQueued = false;
+    }
+
+    if (reset) {
+        // Новое хранилище (вход, выход, загрузка с сервера)
+        showAll();
+        return;
+    }
+
+    for (const Change& change : changes) {
+        const int row = rowOf(change.id);
+
+        if (change.removed) {
+            if (row < 0) {
+                continue;
+            }
+            beginRemoveRows(QModelIndex(), row, row);
+            rows.remove(row);
+            rowById.remove(change.id);
+            if (++removedSinceRenumber >= std::max(MIN_RENUMBER_AFTER, rows.size() / 16)) {
+                renumberRows();
+            }
+            endRemoveRows();
+        } else if (row >= 0) {
+            rows[row].text = change.text;
+            emit dataChanged(index(row), index(row));
+        } else if (!filtered) {
+            const int newRow = rows.size();
+            beginInsertRows(QModelIndex(), newRow, newRow);
+            rows.append({change.id, change.text});
+            rowById.insert(change.id, newRow);
+            endInsertRows();
+        }
+    }
+}
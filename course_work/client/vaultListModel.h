@@ -0,0 +1,84 @@
+#ifndef VAULT_LIST_MODEL_H
+#define VAULT_LIST_MODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <mutex>
+#include <vector>
+#include "client.h"
+
+// Модель списка записей для QListView. Хранит только id записи и подпись
+// "сервис (логин)", остальные поля читаются из Client по id; QListView
+// запрашивает данные лишь видимых строк.
+// Модель подписана на изменения хранилища: правка одной записи даёт одну
+// вставку, удаление или изменение строки, а не перестроение всего списка.
+// Уведомления могут прийти из рабочего потока, поэтому они копятся в очереди
+// и применяются в потоке GUI.
+class VaultListModel : public QAbstractListModel, public UserHashTable::Observer
+{
+    Q_OBJECT
+
+public:
+    static constexpr int EntryIdRole = Qt::UserRole;
+
+    explicit VaultListModel(Client* client, QObject* parent = nullptr);
+    ~VaultListModel() override;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    size_t entryId(const QModelIndex& index) const;
+    QModelIndex indexOf(size_t id) const;  // пустой индекс, если строки нет
+
+    // Всё хранилище или только результаты поиска в порядке их оценки.
+    // В режиме поиска новые записи в список не добавляются
+    void showAll();
+    void showSearchResults(const std::vector<size_t>& ids);
+
+    // Применить накопленные изменения сразу (только из потока GUI)
+    void applyPendingChanges();
+
+    // UserHashTable::Observer: вызываются под блокировкой Client из любого потока
+    void entryStored(const UserHashTable::Entry& entry) override;
+    void entryRemoved(size_t id) override;
+    void entriesReset() override;
+
+private:
+    struct Row {
+        size_t id;
+        QString text;
+    };
+
+    struct Change {
+        size_t id;
+        QString text;
+        bool removed;
+    };
+
+    Client* client;
+    QVector<Row> rows;
+    // Номер строки по id на момент вставки или последней перенумерации. Удаление
+    // не перенумеровывает строки ниже удалённой: каждая из них сдвинулась вверх
+    // не больше чем на removedSinceRenumber, и rowOf ищет её в этом окне.
+    // Номера пересчитываются, когда удалений набирается 1/16 списка (не меньше
+    // MIN_RENUMBER_AFTER): пересчёт обходится в O(1) на удаление, окно остаётся коротким
+    static constexpr int MIN_RENUMBER_AFTER = 64;
+    QHash<size_t, int> rowById;
+    int removedSinceRenumber;
+    bool filtered;
+
+    std::mutex pendingMutex;
+    std::vector<Change> pending;
+    bool pendingReset;
+    bool applyQueued;
+
+    int rowOf(size_t id) const;  // -1, если строки нет
+    void renumberRows();  // пересчёт номеров после удалений
+    void queueApply();  // под pendingMutex
+    void resetRows(QVector<Row> newRows);
+    static QString entryText(const UserHashTable::Entry& entry);
+};
+
+#endif // VAULT_LIST_MODEL_H
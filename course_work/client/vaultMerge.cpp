@@ -0,0 +1,68 @@
+#include "vaultMerge.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+using Entry = UserHashTable::Entry;
+
+bool sameEntry(const Entry* a, const Entry* b) {
+    if (!a || !b) {
+        return a == b;
+    }
+    return a->_lastModifiedTime == b->_lastModifiedTime && a->_password == b->_password &&
+           a->_url == b->_url && a->_note == b->_note;
+}
+
+void store(UserHashTable& table, const Entry& entry) {
+    table.insert(entry._service, entry._lastModifiedTime, entry._login,
+                 entry._password, entry._url, entry._note);
+}
+
+} // namespace
+
+size_t mergeVaults(UserHashTable& local, const UserHashTable& base, const UserHashTable& remote) {
+    // Сначала решения, потом изменения: указатели find живут до первой правки local
+    vector<const Entry*> toStore;
+    vector<pair<string, string>> toRemove;
+
+    remote.forEach([&](const Entry& theirs) {
+        const Entry* mine = local.find(theirs._service, theirs._login);
+        const Entry* ancestor = base.find(theirs._service, theirs._login);
+
+        if (sameEntry(mine, &theirs) || sameEntry(ancestor, &theirs)) {
+            return;  // совпадает или менялась только локально
+        }
+        if (!mine) {
+            // Новая на сервере либо удалена здесь, но изменена там
+            toStore.push_back(&theirs);
+        } else if (sameEntry(mine, ancestor)) {
+            toStore.push_back(&theirs);  // менялась только на сервере
+        } else if (theirs._lastModifiedTime > mine->_lastModifiedTime) {
+            toStore.push_back(&theirs);  // менялась на обеих сторонах
+        }
+    });
+
+    local.forEach([&](const Entry& mine) {
+        if (remote.find(mine._service, mine._login)) {
+            return;
+        }
+        // Удалена на сервере: убираем, если здесь её не трогали
+        const Entry* ancestor = base.find(mine._service, mine._login);
+        if (ancestor && sameEntry(&mine, ancestor)) {
+            toRemove.emplace_back(mine._service, mine._login);
+        }
+    });
+
+    for (const auto& key : toRemove) {
+        local.remove(key.first, key.second);
+    }
+    for (const Entry* entry : toStore) {
+        store(local, *entry);
+    }
+    return toStore.size() + toRemove.size();
+}
@@ -0,0 +1,18 @@
+#ifndef COURSEWORK_VAULT_MERGE_H
+#define COURSEWORK_VAULT_MERGE_H
+
+#include <cstddef>
+#include "userHashTable.h"
+
+// Трёхстороннее слияние хранилища при конфликте версий на сервере.
+// base - состояние сервера, от которого начинались локальные правки,
+// remote - текущее состояние сервера. Запись (сервис, логин), изменённая
+// только на одной стороне, берётся оттуда; изменённая на обеих - более поздняя
+// по _lastModifiedTime (при равенстве остаётся локальная). Правка записи
+// важнее её удаления на другой стороне.
+// Изменения применяются к local по одной записи, так что наблюдатели local
+// получают обычные уведомления, а не перезагрузку всего списка.
+// Возвращает число изменённых в local записей.
+size_t mergeVaults(UserHashTable& local, const UserHashTable& base, const UserHashTable& remote);
+
+#endif // COURSEWORK_VAULT_MERGE_H
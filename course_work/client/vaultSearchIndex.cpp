@@ -0,0 +1,413 @@
+#include "vaultSearchIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <iterator>
+
+using namespace std;
+
+namespace {
+
+// Вес совпадения в поле: сервис важнее логина, логин важнее URL и заметки
+constexpr int FIELD_WEIGHTS[] = {8, 4, 2, 1};
+
+// Оценка совпадения внутри поля
+constexpr int SCORE_EXACT = 100;       // поле целиком
+constexpr int SCORE_PREFIX = 50;       // начало поля
+constexpr int SCORE_WORD_PREFIX = 30;  // начало слова
+constexpr int SCORE_SUBSTRING = 10;    // середина слова
+constexpr int SCORE_FUZZY = 3;         // слово с опечаткой, за каждую правку меньше
+
+bool isSeparator(unsigned char c) {
+    // Байты UTF-8 (>= 0x80) считаются частью слова
+    return c < 0x80 && !isalnum(c);
+}
+
+// Нижний регистр для ASCII и русских букв в UTF-8
+string normalize(const string& text) {
+    string result(text);
+    for (size_t i = 0; i < result.size(); i++) {
+        unsigned char c = result[i];
+        if (c >= 'A' && c <= 'Z') {
+            result[i] = static_cast<char>(c - 'A' + 'a');
+        } else if (c == 0xD0 && i + 1 < result.size()) {
+            unsigned char next = result[i + 1];
+            if (next >= 0x90 && next <= 0x9F) {         // А-П -> а-п
+                result[i + 1] = static_cast<char>(next + 0x20);
+            } else if (next >= 0xA0 && next <= 0xAF) {  // Р-Я -> р-я
+                result[i] = static_cast<char>(0xD1);
+                result[i + 1] = static_cast<char>(next - 0x20);
+            } else if (next == 0x81) {                  // Ё -> ё
+                result[i] = static_cast<char>(0xD1);
+                result[i + 1] = static_cast<char>(0x91);
+            }
+            i++;
+        }
+    }
+    return result;
+}
+
+uint32_t trigramAt(const string& text, size_t pos) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+}
+
+void collectTrigrams(const string& text, vector<uint32_t>& out) {
+    for (size_t i = 0; i + 3 <= text.size(); i++) {
+        out.push_back(trigramAt(text, i));
+    }
+}
+
+void collectWords(const string& text, vector<string>& out) {
+    size_t start = 0;
+    while (start < text.size()) {
+        while (start < text.size() && isSeparator(text[start])) {
+            start++;
+        }
+        size_t end = start;
+        while (end < text.size() && !isSeparator(text[end])) {
+            end++;
+        }
+        if (end > start) {
+            out.push_back(text.substr(start, end - start));
+        }
+        start = end;
+    }
+}
+
+void sortUnique(vector<uint32_t>& values) {
+    sort(values.begin(), values.end());
+    values.erase(unique(values.begin(), values.end()), values.end());
+}
+
+constexpr size_t MAX_FUZZY_LENGTH = 64;
+
+// Расстояние Дамерау-Левенштейна (с перестановкой соседних символов);
+// если оно больше maxDistance, возвращается maxDistance + 1
+size_t editDistance(const string& a, const string& b, size_t maxDistance) {
+    const size_t n = a.size();
+    const size_t m = b.size();
+    if ((n > m ? n - m : m - n) > maxDistance || m > MAX_FUZZY_LENGTH) {
+        return maxDistance + 1;
+    }
+
+    // Строки таблицы на стеке: функция вызывается для тысяч слов подряд
+    size_t rows[3][MAX_FUZZY_LENGTH + 1];
+    size_t* prev2 = rows[0];
+    size_t* prev = rows[1];
+    size_t* cur = rows[2];
+    for (size_t j = 0; j <= m; j++) {
+        prev[j] = j;
+    }
+    for (size_t i = 1; i <= n; i++) {
+        cur[0] = i;
+        size_t rowMin = cur[0];
+        for (size_t j = 1; j <= m; j++) {
+            const size_t cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            cur[j] = min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + cost});
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+                cur[j] = min(cur[j], prev2[j - 2] + 1);
+            }
+            rowMin = min(rowMin, cur[j]);
+        }
+        if (rowMin > maxDistance) {
+            return maxDistance + 1;
+        }
+        size_t* oldest = prev2;
+        prev2 = prev;
+        prev = cur;
+        cur = oldest;
+    }
+    return prev[m];
+}
+
+// Лучшая оценка вхождения term в документ, 0 - не входит
+int scoreFields(const string* fields, const string& term) {
+    int best = 0;
+    for (size_t f = 0; f < size(FIELD_WEIGHTS); f++) {
+        // Поля идут по убыванию веса: дальше лучшую оценку уже не превзойти
+        if (best >= SCORE_EXACT * FIELD_WEIGHTS[f]) {
+            break;
+        }
+        const string& field = fields[f];
+        const size_t pos = field.find(term);
+        if (pos == string::npos) {
+            continue;
+        }
+
+        int score = SCORE_SUBSTRING;
+        if (pos == 0) {
+            score = field.size() == term.size() ? SCORE_EXACT : SCORE_PREFIX;
+        } else if (isSeparator(field[pos - 1])) {
+            score = SCORE_WORD_PREFIX;
+        }
+        best = max(best, score * FIELD_WEIGHTS[f]);
+    }
+    return best;
+}
+
+} // namespace
+
+void VaultSearchIndex::addDocument(size_t id, const Document& doc) {
+    vector<uint32_t> grams;
+    vector<string> docWords;
+    for (const auto& field : doc.fields) {
+        collectTrigrams(field, grams);
+        collectWords(field, docWords);
+    }
+    sortUnique(grams);
+
+    for (uint32_t gram : grams) {
+        auto& ids = trigrams[gram];
+        // id новых записей растут, поэтому обычно это просто добавление в конец
+        if (ids.empty() || ids.back() < id) {
+            ids.push_back(id);
+        } else {
+            auto it = lower_bound(ids.begin(), ids.end(), id);
+            if (it == ids.end() || *it != id) {
+                ids.insert(it, id);
+            }
+        }
+    }
+    for (auto& word : docWords) {
+        words.emplace(move(word), id);
+    }
+}
+
+void VaultSearchIndex::removeDocument(size_t id, const Document& doc) {
+    vector<uint32_t> grams;
+    vector<string> docWords;
+    for (const auto& field : doc.fields) {
+        collectTrigrams(field, grams);
+        collectWords(field, docWords);
+    }
+    sortUnique(grams);
+
+    for (uint32_t gram : grams) {
+        auto found = trigrams.find(gram);
+        if (found == trigrams.end()) {
+            continue;
+        }
+        auto& ids = found->second;
+        auto it = lower_bound(ids.begin(), ids.end(), id);
+        if (it != ids.end() && *it == id) {
+            ids.erase(it);
+        }
+        if (ids.empty()) {
+            trigrams.erase(found);
+        }
+    }
+    for (auto& word : docWords) {
+        words.erase(make_pair(move(word), id));
+    }
+}
+
+void VaultSearchIndex::entryStored(const UserHashTable::Entry& entry) {
+    Document doc;
+    doc.fields[0] = normalize(entry._service);
+    doc.fields[1] = normalize(entry._login);
+    doc.fields[2] = normalize(entry._url);
+    doc.fields[3] = normalize(entry._note);
+
+    doc.present = true;
+
+    if (entry._id >= docs.size()) {
+        docs.resize(entry._id + 1);
+    }
+    Document& stored = docs[entry._id];
+    if (stored.present) {
+        // Обновление записи: индексируем заново, только если поменялись искомые поля
+        if (equal(begin(doc.fields), end(doc.fields), begin(stored.fields))) {
+            return;
+        }
+        removeDocument(entry._id, stored);
+    } else {
+        documentCount++;
+    }
+
+    addDocument(entry._id, doc);
+    stored = move(doc);
+}
+
+void VaultSearchIndex::entryRemoved(size_t id) {
+    if (id >= docs.size() || !docs[id].present) {
+        return;
+    }
+    removeDocument(id, docs[id]);
+    docs[id] = Document();
+    documentCount--;
+}
+
+void VaultSearchIndex::clear() {
+    docs.clear();
+    documentCount = 0;
+    trigrams.clear();
+    words.clear();
+}
+
+vector<size_t> VaultSearchIndex::exactCandidates(const string& term) const {
+    vector<size_t> candidates;
+    if (term.size() < 3) {
+        // Короткое слово: записи, где какое-то слово начинается с него
+        for (auto it = words.lower_bound(make_pair(term, size_t(0)));
+             it != words.end() && it->first.compare(0, term.size(), term) == 0; ++it) {
+            candidates.push_back(it->second);
+        }
+        sort(candidates.begin(), candidates.end());
+        candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+        return candidates;
+    }
+
+    vector<uint32_t> grams;
+    collectTrigrams(term, grams);
+    sortUnique(grams);
+
+    // Пересекаем списки начиная с самого короткого
+    vector<const vector<size_t>*> lists;
+    for (uint32_t gram : grams) {
+        auto found = trigrams.find(gram);
+        if (found == trigrams.end()) {
+            return candidates;
+        }
+        lists.push_back(&found->second);
+    }
+    sort(lists.begin(), lists.end(), [](const vector<size_t>* a, const vector<size_t>* b) {
+        return a->size() < b->size();
+    });
+
+    candidates = *lists[0];
+    vector<size_t> next;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+        next.clear();
+        set_intersection(candidates.begin(), candidates.end(),
+                         lists[i]->begin(), lists[i]->end(), back_inserter(next));
+        candidates.swap(next);
+    }
+    return candidates;
+}
+
+vector<pair<size_t, int>> VaultSearchIndex::fuzzyMatches(const string& term) const {
+    vector<pair<size_t, int>> matches;
+    if (term.size() < 3 || term.size() > MAX_FUZZY_LENGTH) {
+        return matches;
+    }
+    const size_t maxDistance = term.size() <= 5 ? 1 : 2;
+
+    // Опечатку в первой букве не ищем: это сужает перебор до слов на ту же букву
+    const unsigned char lead = term[0];
+    const size_t leadSize = lead < 0x80 ? 1 : (lead >= 0xF0 ? 4 : (lead >= 0xE0 ? 3 : 2));
+    const string first = term.substr(0, min(leadSize, term.size()));
+
+    for (auto it = words.lower_bound(make_pair(first, size_t(0)));
+         it != words.end() && it->first.compare(0, first.size(), first) == 0; ++it) {
+        const size_t distance = editDistance(term, it->first, maxDistance);
+        if (distance <= maxDistance) {
+            matches.emplace_back(it->second, static_cast<int>(SCORE_FUZZY * (maxDistance + 1 - distance)));
+        }
+    }
+
+    // По id, у записи остаётся лучшее из похожих слов
+    sort(matches.begin(), matches.end(), [](const pair<size_t, int>& a, const pair<size_t, int>& b) {
+        return a.first != b.first ? a.first < b.first : a.second > b.second;
+    });
+    matches.erase(unique(matches.begin(), matches.end(), [](const pair<size_t, int>& a, const pair<size_t, int>& b) {
+        return a.first == b.first;
+    }), matches.end());
+    return matches;
+}
+
+vector<size_t> VaultSearchIndex::search(const string& query, size_t limit) const {
+    vector<string> terms;
+    const string normalized = normalize(query);
+    size_t start = 0;
+    while (start < normalized.size()) {
+        size_t end = normalized.find(' ', start);
+        if (end == string::npos) {
+            end = normalized.size();
+        }
+        if (end > start) {
+            terms.push_back(normalized.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    if (terms.empty()) {
+        return {};
+    }
+
+    // Сначала только отбор по индексу: запись должна подходить под каждое слово.
+    // Слова без точных совпадений ищутся с опечатками
+    vector<vector<size_t>> exact(terms.size());
+    vector<vector<pair<size_t, int>>> fuzzy(terms.size());
+    vector<size_t> order;
+    for (size_t i = 0; i < terms.size(); i++) {
+        exact[i] = exactCandidates(terms[i]);
+        if (exact[i].empty()) {
+            fuzzy[i] = fuzzyMatches(terms[i]);
+            if (fuzzy[i].empty()) {
+                return {};
+            }
+            for (const auto& match : fuzzy[i]) {
+                exact[i].push_back(match.first);
+            }
+        }
+        order.push_back(i);
+    }
+    sort(order.begin(), order.end(), [&exact](size_t a, size_t b) {
+        return exact[a].size() < exact[b].size();
+    });
+
+    vector<size_t> candidates(exact[order[0]]);
+    vector<size_t> next;
+    for (size_t i = 1; i < order.size() && !candidates.empty(); i++) {
+        const auto& ids = exact[order[i]];
+        next.clear();
+        set_intersection(candidates.begin(), candidates.end(), ids.begin(), ids.end(), back_inserter(next));
+        candidates.swap(next);
+    }
+
+    // Оценка считается только для оставшихся записей; совпадение по всем
+    // триграммам ещё не значит, что слово входит подстрокой, такие отбрасываются
+    vector<pair<int, size_t>> ranked;
+    for (size_t id : candidates) {
+        const Document& doc = docs[id];
+        int total = 0;
+        for (size_t i = 0; i < terms.size(); i++) {
+            int score;
+            if (fuzzy[i].empty()) {
+                score = scoreFields(doc.fields, terms[i]);
+            } else {
+                auto found = lower_bound(fuzzy[i].begin(), fuzzy[i].end(), make_pair(id, INT_MIN));
+                score = found->second;
+            }
+            if (score == 0) {
+                total = 0;
+                break;
+            }
+            total += score;
+        }
+        if (total > 0) {
+            ranked.emplace_back(total, id);
+        }
+    }
+
+    // От лучшей оценки к худшей, при равной - старые записи раньше. С limit
+    // упорядочиваются только первые limit записей
+    auto better = [](const pair<int, size_t>& a, const pair<int, size_t>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    if (limit > 0 && limit < ranked.size()) {
+        partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(), better);
+        ranked.resize(limit);
+    } else {
+        sort(ranked.begin(), ranked.end(), better);
+    }
+
+    vector<size_t> result;
+    result.reserve(ranked.size());
+    for (const auto& match : ranked) {
+        result.push_back(match.second);
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef COURSEWORK_VAULT_SEARCH_INDEX_H
+#define COURSEWORK_VAULT_SEARCH_INDEX_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "userHashTable.h"
+
+// Поисковый индекс по записям хранилища: сервис, логин, URL и заметка
+// (пароль не индексируется). Обновляется инкрементально как наблюдатель
+// UserHashTable, поэтому поиск не перебирает всё хранилище:
+//  - слова от 3 байт ищутся как подстрока через пересечение списков триграмм;
+//  - короткие слова (1-2 символа) - по началу слов в полях;
+//  - если точных совпадений нет, слово ищется с опечатками (1-2 правки).
+// Регистр латиницы и кириллицы не учитывается.
+class VaultSearchIndex : public UserHashTable::Observer {
+private:
+    static constexpr int FIELD_COUNT = 4;  // сервис, логин, URL, заметка
+
+    struct Document {
+        std::string fields[FIELD_COUNT];  // в нижнем регистре
+        bool present = false;
+    };
+
+    // id записей выдаются подряд, поэтому документы лежат в векторе по id:
+    // при оценке тысяч кандидатов это дешевле поиска в хеш-таблице
+    std::vector<Document> docs;
+    size_t documentCount = 0;
+    std::unordered_map<uint32_t, std::vector<size_t>> trigrams;  // триграмма -> отсортированные id
+    std::set<std::pair<std::string, size_t>> words;              // (слово, id) для поиска по началу слова
+
+    void addDocument(size_t id, const Document& doc);
+    void removeDocument(size_t id, const Document& doc);
+    std::vector<size_t> exactCandidates(const std::string& term) const;  // отсортированные id
+    std::vector<std::pair<size_t, int>> fuzzyMatches(const std::string& term) const;  // (id, оценка) по id
+
+public:
+    void entryStored(const UserHashTable::Entry& entry) override;
+    void entryRemoved(size_t id) override;
+    void entriesReset() override { clear(); }
+    void clear();
+
+    // id записей, подходящих под все слова запроса, от лучшего совпадения к худшему;
+    // limit = 0 - без ограничения
+    std::vector<size_t> search(const std::string& query, size_t limit = 0) const;
+
+    size_t count() const { return documentCount; }
+};
+
+#endif // COURSEWORK_VAULT_SEARCH_INDEX_H
@@ -12,26 +12,18 @@
 
 using namespace std;
 
+bool initCryptoRuntime() {
+    return sodium_init() >= 0;
+}
+
 // Генерация соли
 vector<unsigned char> generateSaltRaw(size_t size) {
-    std::ifstream urandom("/dev/urandom", std::ios::binary);
-    if (!urandom) {
-        throw std::runtime_error("Cannot open /dev/urandom");
-    }
-
     std::vector<unsigned char> salt(size);
-    urandom.read(reinterpret_cast<char*>(salt.data()), size);
-
-    if (urandom.gcount() != static_cast<std::streamsize>(size)) {
-        throw std::runtime_error("Failed to read enough random bytes");
-    }
+    randombytes_buf(salt.data(), salt.size());
     return salt;
 }
 
 std::vector<unsigned char> generate128bitLibsodium() {
-    if (sodium_init() < 0) {
-        throw std::runtime_error("Libsodium initialization failed");
-    }
     // Генерируем 16 байт (128 бит)
     std::vector<unsigned char> randomData(16);
     randombytes_buf(randomData.data(), randomData.size());
@@ -47,10 +39,6 @@ std::vector<unsigned char> hashPasswordArgon2id(
     unsigned long long opsLimit,
     size_t memLimit) {
 
-    if (sodium_init() < 0) {
-        throw std::runtime_error("Libsodium initialization failed");
-    }
-
     std::vector<unsigned char> hash(hashLength);
 
     if (crypto_pwhash_argon2id(
@@ -67,10 +55,6 @@ std::vector<unsigned char> hashPasswordArgon2id(
 }
 
 std::vector<unsigned char> hashSHA512(const std::string& data) {
-    if (sodium_init() < 0) {
-        throw std::runtime_error("Libsodium initialization failed");
-    }
-
     std::vector<unsigned char> hash(crypto_hash_sha512_BYTES);
 
     crypto_hash_sha512(
@@ -84,22 +68,37 @@ std::vector<unsigned char> hashSHA512(const std::string& data) {
 
 // Перевод в HEX
 std::string toHex(const std::vector<unsigned char>& data) {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (unsigned char byte : data) {
-        ss << std::setw(2) << static_cast<int>(byte);
+    return toHex(data.data(), data.size());
+}
+
+// Таблица вместо stringstream: хранилище в несколько мегабайт переводится за один проход
+std::string toHex(const unsigned char* data, size_t size) {
+    static const char DIGITS[] = "0123456789abcdef";
+    std::string hex(size * 2, '\0');
+    for (size_t i = 0; i < size; i++) {
+        hex[2 * i] = DIGITS[data[i] >> 4];
+        hex[2 * i + 1] = DIGITS[data[i] & 0x0F];
     }
-    return ss.str();
+    return hex;
 }
 
-vector<unsigned char> hexToBytes(const std::string& hex) {
-    vector<unsigned char> bytes;
-    bytes.reserve(hex.length() / 2);
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    throw std::invalid_argument("Некорректный символ в hex-строке");
+}
 
-    for (size_t i = 0; i < hex.length(); i += 2) {
-        std::string byte_str = hex.substr(i, 2);
-        unsigned char byte = static_cast<unsigned char>(std::stoi(byte_str, nullptr, 16));
-        bytes.push_back(byte);
+// Без временных строк на каждый байт: хранилище в несколько мегабайт
+// разбирается за один проход
+vector<unsigned char> hexToBytes(std::string_view hex) {
+    vector<unsigned char> bytes((hex.length() + 1) / 2);
+    size_t i = 0;
+    for (; i + 1 < hex.length(); i += 2) {
+        bytes[i / 2] = static_cast<unsigned char>((hexDigit(hex[i]) << 4) | hexDigit(hex[i + 1]));
+    }
+    if (i < hex.length()) {
+        bytes[i / 2] = static_cast<unsigned char>(hexDigit(hex[i]));  // нечётная длина
     }
     return bytes;
 }
@@ -2,9 +2,14 @@
 #define COURSEWORK_COMMON_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sodium.h>
 
+// Инициализация libsodium один раз при старте процесса (вызывается из main).
+// Остальные функции считают, что библиотека уже инициализирована
+bool initCryptoRuntime();
+
 // Генерация случайных данных
 std::vector<unsigned char> generateSaltRaw(size_t size = 16);
 std::vector<unsigned char> generate128bitLibsodium();
@@ -20,7 +25,8 @@ std::vector<unsigned char> hashSHA512(const std::string& data);
 
 // Преобразование данных
 std::string toHex(const std::vector<unsigned char>& data);
-std::vector<unsigned char> hexToBytes(const std::string& hex);
+std::string toHex(const unsigned char* data, size_t size);
+std::vector<unsigned char> hexToBytes(std::string_view hex);
 std::vector<unsigned char> hexStringToVector(const std::string& hexStr);
 
 // Генерация мнемонических фраз
@@ -1,7 +1,7 @@
 #include "hashTableUrers.h"
+#include "logger.h"
 #include <vector>
 #include <fstream>
-#include <iostream>
 
 
 using namespace std;
@@ -115,7 +115,7 @@ void HashTableUsers::loadFromFile(const std::string &filename) {
         try {
             file >> docs;
         } catch (...) {
-            cerr << "Файл повреждён — начинаем с нуля." << endl;
+            logWarn("Файл повреждён — начинаем с нуля", {{"file", filename}});
         }
         file.close();
     }
@@ -164,7 +164,7 @@ void HashTableUsers::saveToFile(const std::string &filename) const{
         file << data.dump(4);
         file.close();
     } else {
-        cerr << "Не удалось открыть файл для записи: " << filename << endl;
+        logError("Не удалось открыть файл для записи", {{"file", filename}});
     }
 }
 
@@ -4,7 +4,6 @@
 #include "common_utils.h"
 
 #include <fstream>
-#include <iostream>
 
 using namespace std;
 
@@ -24,9 +23,6 @@ bool checkPasswordUser(const string& login, const string& password, const HashTa
 bool checkPhrase(const string& login, HashTableUsers& users, const string& words) {
     auto _Phrase = users.getSeedPhraseHash(login);
     auto hashWords = toHex(hashSHA512(words));
-    cout << "Слова юзера: " << words << endl;
-    cout << "Хэш в таблице: " << _Phrase << endl;
-    cout << "Полученный хэш: " << hashWords << endl;
     return _Phrase == hashWords;
 }
 
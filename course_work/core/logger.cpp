@@ -0,0 +1,266 @@
+#include "logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+using namespace std;
+
+namespace {
+
+const char* const REDACTED = "[скрыто]";
+
+// Поля с такими именами не выводятся, даже если значение передано без Secret
+const char* const SENSITIVE_KEY_PARTS[] = {
+    "password", "phrase", "seed", "salt", "hash", "secret", "token", "key"
+};
+
+constexpr auto IDLE_FLUSH_INTERVAL = chrono::milliseconds(50);
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info:  return "INFO ";
+        case LogLevel::Warn:  return "WARN ";
+        case LogLevel::Error: return "ERROR";
+    }
+    return "?";
+}
+
+LogLevel levelFromEnvironment() {
+    const char* value = getenv("PM_LOG_LEVEL");
+    if (!value) {
+        return LogLevel::Info;
+    }
+    string level(value);
+    transform(level.begin(), level.end(), level.begin(), ::tolower);
+    if (level == "debug") return LogLevel::Debug;
+    if (level == "warn" || level == "warning") return LogLevel::Warn;
+    if (level == "error") return LogLevel::Error;
+    return LogLevel::Info;
+}
+
+// Значение в кавычках, если в нём пробелы, '=' или управляющие символы:
+// перевод строки в данных не должен порождать поддельную строку лога
+void appendValue(string& out, const string& value) {
+    const bool plain = !value.empty() && none_of(value.begin(), value.end(), [](unsigned char c) {
+        return c <= ' ' || c == '=' || c == '"' || c == '\\' || c == 0x7f;
+    });
+    if (plain) {
+        out += value;
+        return;
+    }
+    out += '"';
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < ' ' || c == 0x7f) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\x%02x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+// ---------- LogField ----------
+
+bool LogField::isSensitiveKey(const string& key) {
+    string lower(key);
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (const char* part : SENSITIVE_KEY_PARTS) {
+        if (lower.find(part) != string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LogField::assign(string value) {
+    fieldValue = isSensitiveKey(fieldKey) ? string(REDACTED) : move(value);
+}
+
+LogField::LogField(const char* key, const string& value) : fieldKey(key) {
+    assign(value);
+}
+
+LogField::LogField(const char* key, const char* value) : fieldKey(key) {
+    assign(value ? value : "");
+}
+
+LogField::LogField(const char* key, const Secret&) : fieldKey(key), fieldValue(REDACTED) {}
+
+// ---------- Logger ----------
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : slots(new Slot[CAPACITY]), tail(0), head(0), dropped(0), written(0), pushed(0),
+      minLevel(levelFromEnvironment()), stopping(false) {
+    for (size_t i = 0; i < CAPACITY; i++) {
+        slots[i].sequence.store(i, memory_order_relaxed);
+    }
+    writer = thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    stopping = true;
+    wake.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    delete[] slots;
+}
+
+void Logger::log(LogLevel level, const string& message, initializer_list<LogField> fields) {
+    if (!enabled(level)) {
+        return;
+    }
+
+    Record record;
+    record.time = chrono::system_clock::now();
+    record.level = level;
+    record.message = message;
+    record.fields.reserve(fields.size());
+    for (const auto& field : fields) {
+        record.fields.emplace_back(field.key(), field.value());
+    }
+
+    if (!tryPush(move(record))) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    pushed.fetch_add(1, memory_order_relaxed);
+
+    // Обычные записи фоновый поток подберёт сам; будим его только ради
+    // предупреждений и ошибок или когда буфер заполнен наполовину
+    const size_t backlog = tail.load(memory_order_relaxed) - written.load(memory_order_relaxed);
+    if (level >= LogLevel::Warn || backlog > CAPACITY / 2) {
+        wake.notify_one();
+    }
+}
+
+void Logger::flush() {
+    const uint64_t target = pushed.load();
+    unique_lock<mutex> lock(wakeMutex);
+    wake.notify_one();
+    while (written.load() < target && writer.joinable()) {
+        drained.wait_for(lock, IDLE_FLUSH_INTERVAL);
+        wake.notify_one();
+    }
+}
+
+bool Logger::tryPush(Record&& record) {
+    size_t pos = tail.load(memory_order_relaxed);
+    while (true) {
+        Slot& slot = slots[pos & (CAPACITY - 1)];
+        const size_t sequence = slot.sequence.load(memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                slot.record = move(record);
+                slot.sequence.store(pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // буфер полон
+        } else {
+            pos = tail.load(memory_order_relaxed);
+        }
+    }
+}
+
+bool Logger::tryPop(Record& record) {
+    Slot& slot = slots[head & (CAPACITY - 1)];
+    const size_t sequence = slot.sequence.load(memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(head + 1) < 0) {
+        return false;  // пусто или запись ещё не дописана
+    }
+    record = move(slot.record);
+    slot.sequence.store(head + CAPACITY, memory_order_release);
+    head++;
+    return true;
+}
+
+void Logger::run() {
+    string out;
+    while (true) {
+        writeBatch(out);
+        if (stopping) {
+            writeBatch(out);  // всё, что успели положить до остановки
+            break;
+        }
+        unique_lock<mutex> lock(wakeMutex);
+        wake.wait_for(lock, IDLE_FLUSH_INTERVAL);
+    }
+}
+
+void Logger::writeBatch(string& out) {
+    out.clear();
+    Record record;
+    uint64_t count = 0;
+    while (tryPop(record)) {
+        format(record, out);
+        count++;
+    }
+
+    const uint64_t lost = dropped.exchange(0, memory_order_relaxed);
+    if (lost != 0) {
+        Record notice;
+        notice.time = chrono::system_clock::now();
+        notice.level = LogLevel::Warn;
+        notice.message = "Буфер лога переполнен, записи отброшены";
+        notice.fields.emplace_back("dropped", to_string(lost));
+        format(notice, out);
+    }
+
+    if (!out.empty()) {
+        fwrite(out.data(), 1, out.size(), stderr);
+        fflush(stderr);
+    }
+    if (count != 0) {
+        written.fetch_add(count);
+        lock_guard<mutex> lock(wakeMutex);
+        drained.notify_all();
+    }
+}
+
+void Logger::format(const Record& record, string& out) {
+    const time_t seconds = chrono::system_clock::to_time_t(record.time);
+    const auto millis = chrono::duration_cast<chrono::milliseconds>(record.time.time_since_epoch()).count() % 1000;
+    tm local{};
+    localtime_r(&seconds, &local);
+
+    char stamp[32];
+    const size_t len = strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(stamp + len, sizeof(stamp) - len, ".%03d ", static_cast<int>(millis));
+
+    out += stamp;
+    out += levelName(record.level);
+    out += ' ';
+    for (char c : record.message) {
+        out += c == '\n' || c == '\r' ? ' ' : c;
+    }
+    for (const auto& [key, value] : record.fields) {
+        out += ' ';
+        out += key;
+        out += '=';
+        appendValue(out, value);
+    }
+    out += '\n';
+}
@@ -0,0 +1,131 @@
+#ifndef COURSEWORK_LOGGER_H
+#define COURSEWORK_LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Асинхронный структурированный лог.
+//
+//   logInfo("Сервер инициализирован", {{"port", port}});
+//   logWarn("Ошибка обработки запроса", {{"action", action}, {"error", e.what()}});
+//
+// Запись кладётся в кольцевой буфер без блокировок (Vyukov MPMC); в stderr её
+// пишет фоновый поток пачками с одним fflush. Вызывающий поток не ждёт вывода,
+// при переполнении буфера запись отбрасывается и учитывается в счётчике.
+// Уровень задаётся переменной окружения PM_LOG_LEVEL (debug, info, warn, error).
+//
+// Секреты не попадают в лог по построению: значение в обёртке Secret и любое
+// поле с именем вроде password/seed/phrase/hash/salt/key печатаются как [скрыто].
+
+enum class LogLevel { Debug = 0, Info = 1, Warn = 2, Error = 3 };
+
+// Значение, которое никогда не выводится как есть
+class Secret {
+public:
+    explicit Secret(const std::string&) {}
+};
+
+class LogField {
+private:
+    std::string fieldKey;
+    std::string fieldValue;
+
+    static bool isSensitiveKey(const std::string& key);
+    void assign(std::string value);
+
+public:
+    LogField(const char* key, const std::string& value);
+    LogField(const char* key, const char* value);
+    LogField(const char* key, const Secret& value);
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    LogField(const char* key, T value) : fieldKey(key) {
+        if constexpr (std::is_same_v<T, bool>) {
+            assign(value ? "true" : "false");
+        } else {
+            assign(std::to_string(value));
+        }
+    }
+
+    const std::string& key() const { return fieldKey; }
+    const std::string& value() const { return fieldValue; }
+};
+
+class Logger {
+public:
+    static Logger& instance();
+
+    bool enabled(LogLevel level) const { return level >= minLevel; }
+    void log(LogLevel level, const std::string& message, std::initializer_list<LogField> fields);
+
+    // Дождаться вывода всего, что уже в буфере
+    void flush();
+
+    ~Logger();
+
+private:
+    struct Record {
+        std::chrono::system_clock::time_point time;
+        LogLevel level = LogLevel::Info;
+        std::string message;
+        std::vector<std::pair<std::string, std::string>> fields;
+    };
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    static constexpr size_t CAPACITY = 4096;  // степень двойки
+
+    Slot* slots;
+    alignas(64) std::atomic<size_t> tail;  // следующая позиция записи (производители)
+    alignas(64) size_t head;               // следующая позиция чтения (только фоновый поток)
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> pushed;
+    LogLevel minLevel;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::atomic<bool> stopping;
+    std::thread writer;
+
+    Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    bool tryPush(Record&& record);
+    bool tryPop(Record& record);
+    void run();
+    void writeBatch(std::string& out);
+    static void format(const Record& record, std::string& out);
+};
+
+inline void logDebug(const std::string& message, std::initializer_list<LogField> fields = {}) {
+    Logger::instance().log(LogLevel::Debug, message, fields);
+}
+
+inline void logInfo(const std::string& message, std::initializer_list<LogField> fields = {}) {
+    Logger::instance().log(LogLevel::Info, message, fields);
+}
+
+inline void logWarn(const std::string& message, std::initializer_list<LogField> fields = {}) {
+    Logger::instance().log(LogLevel::Warn, message, fields);
+}
+
+inline void logError(const std::string& message, std::initializer_list<LogField> fields = {}) {
+    Logger::instance().log(LogLevel::Error, message, fields);
+}
+
+#endif // COURSEWORK_LOGGER_H
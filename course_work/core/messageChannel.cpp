@@ -0,0 +1,214 @@
+#include "messageChannel.h"
+#include "wireCodec.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t READ_CHUNK = 64 * 1024;
+
+// Поиск конца JSON-объекта по мере поступления данных; каждый байт
+// просматривается один раз. Внутри строк ищем только кавычку (memchr),
+// так что многомегабайтный hex хранилища пролетает быстро
+class ObjectFramer {
+private:
+    size_t pos = 0;
+    int depth = 0;
+    bool started = false;
+    bool inString = false;
+
+public:
+    // Длина объекта, 0 - нужны ещё данные, npos - не JSON-объект
+    size_t scan(const string& data) {
+        while (pos < data.size()) {
+            if (inString) {
+                const void* quote = memchr(data.data() + pos, '"', data.size() - pos);
+                if (!quote) {
+                    pos = data.size();
+                    break;
+                }
+                const size_t at = static_cast<const char*>(quote) - data.data();
+                size_t backslashes = 0;
+                while (at - backslashes > 0 && data[at - backslashes - 1] == '\\') {
+                    backslashes++;
+                }
+                pos = at + 1;
+                if (backslashes % 2 == 0) {
+                    inString = false;
+                }
+                continue;
+            }
+
+            const char c = data[pos++];
+            if (!started) {
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                    continue;
+                }
+                if (c != '{') {
+                    return string::npos;
+                }
+                started = true;
+                depth = 1;
+                continue;
+            }
+            switch (c) {
+                case '"': inString = true; break;
+                case '{': case '[': depth++; break;
+                case '}': case ']':
+                    if (--depth == 0) {
+                        return pos;
+                    }
+                    break;
+                default: break;
+            }
+        }
+        return 0;
+    }
+};
+
+// Длина сообщения в начале data, 0 - нужны ещё данные
+ReadStatus frameMessage(const string& data, ObjectFramer& framer, bool& binary, size_t maxBytes, size_t& length) {
+    length = 0;
+    if (BinaryWireCodec::isFrame(data)) {
+        binary = true;
+        bool valid = true;
+        if (BinaryWireCodec::frameLength(data.data(), data.size(), length, valid)) {
+            if (length > maxBytes) {
+                return ReadStatus::TooLarge;  // по заголовку, не дожидаясь тела
+            }
+            if (data.size() < length) {
+                length = 0;
+            }
+        } else if (!valid) {
+            return ReadStatus::Malformed;
+        }
+        return ReadStatus::Ok;
+    }
+
+    length = framer.scan(data);
+    if (length == string::npos) {
+        return ReadStatus::Malformed;
+    }
+    if (length == 0 && data.size() > maxBytes) {
+        return ReadStatus::TooLarge;
+    }
+    return ReadStatus::Ok;
+}
+
+} // namespace
+
+Channel::~Channel() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool waitReadable(int socket, chrono::steady_clock::time_point deadline) {
+    if (deadline == chrono::steady_clock::time_point::max()) {
+        return true;
+    }
+    pollfd ready{socket, POLLIN, 0};
+    while (true) {
+        const auto left = chrono::ceil<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+        if (left.count() <= 0) {
+            errno = EAGAIN;
+            return false;
+        }
+        const int n = poll(&ready, 1, static_cast<int>(min<chrono::milliseconds::rep>(left.count(), INT_MAX)));
+        if (n > 0) {
+            return true;
+        }
+        if (n == 0) {
+            errno = EAGAIN;
+            return false;
+        }
+        if (errno != EINTR) {
+            return true;  // ошибку сокета вернёт recv
+        }
+    }
+}
+
+ssize_t Channel::receive(char* buffer, size_t length) {
+    if (!waitReadable(fd, readDeadline)) {
+        return -1;
+    }
+    while (true) {
+        const ssize_t n = recv(fd, buffer, length, 0);
+        if (n >= 0 || errno != EINTR) {
+            return n;
+        }
+    }
+}
+
+bool Channel::sendAll(const char* data, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        const ssize_t n = send(fd, data + sent, length - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+ReadStatus readMessage(Channel& channel, string& message, bool& binary, size_t maxBytes,
+                       chrono::milliseconds timeLimit) {
+    message.swap(channel.carry);
+    channel.carry.clear();
+    binary = false;
+    ObjectFramer framer;
+    char chunk[READ_CHUNK];
+    
+    // Сообщение началось - дальше на него отводится не больше timeLimit
+    bool started = false;
+    auto startTimer = [&] {
+        started = true;
+        if (timeLimit.count() > 0) {
+            channel.setReadDeadline(min(channel.deadline(), chrono::steady_clock::now() + timeLimit));
+        }
+    };
+    if (!message.empty()) {
+        startTimer();
+    }
+
+    while (true) {
+        if (!message.empty()) {
+            size_t length = 0;
+            const ReadStatus status = frameMessage(message, framer, binary, maxBytes, length);
+            if (status != ReadStatus::Ok) {
+                return status;
+            }
+            if (length != 0) {
+                // Следующее сообщение того же соединения, если оно уже пришло
+                channel.carry.assign(message, length, string::npos);
+                message.resize(length);
+                return ReadStatus::Ok;
+            }
+        }
+
+        const ssize_t n = channel.receive(chunk, sizeof(chunk));
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK ? ReadStatus::Timeout : ReadStatus::Closed;
+        }
+        if (n == 0) {
+            // Соединение закрыто до конца сообщения
+            return message.empty() ? ReadStatus::Closed : ReadStatus::Malformed;
+        }
+        message.append(chunk, static_cast<size_t>(n));
+        if (!started) {
+            startTimer();
+        }
+    }
+}
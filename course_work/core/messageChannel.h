@@ -0,0 +1,59 @@
+#ifndef COURSEWORK_MESSAGE_CHANNEL_H
+#define COURSEWORK_MESSAGE_CHANNEL_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+// Соединение с сервером или клиентом: сокет как есть. TLS поверх сокета -
+// наследник TlsChannel (tlsChannel.h). Деструктор закрывает сокет
+class Channel {
+public:
+    explicit Channel(int socket) : fd(socket) {}
+    virtual ~Channel();
+
+    // Как recv: >0 - прочитано байт, 0 - соединение закрыто, -1 - ошибка в errno
+    // (EAGAIN - истёк таймаут сокета)
+    virtual ssize_t receive(char* buffer, size_t length);
+    virtual bool sendAll(const char* data, size_t length);
+
+    int socket() const { return fd; }
+    
+    // Срок чтения: после него receive возвращает -1 с errno EAGAIN, даже если
+    // данные идут по байту (таймаут сокета отсчитывается заново на каждый recv).
+    // По умолчанию срока нет
+    void setReadDeadline(std::chrono::steady_clock::time_point deadline) { readDeadline = deadline; }
+    std::chrono::steady_clock::time_point deadline() const { return readDeadline; }
+
+    // Прочитано сверх предыдущего сообщения (соединение с несколькими запросами)
+    std::string carry;
+
+protected:
+    int fd;
+    std::chrono::steady_clock::time_point readDeadline = std::chrono::steady_clock::time_point::max();
+
+private:
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+};
+
+// Ждёт данных в сокете не дольше срока: false - срок истёк (errno = EAGAIN).
+// Без срока (time_point::max()) сразу true - ждать будет сам recv
+bool waitReadable(int socket, std::chrono::steady_clock::time_point deadline);
+
+// Чтение одного сообщения. Протокол определяется по первому байту:
+// кадр бинарного протокола читается по длине из заголовка, а JSON - до
+// закрывающей скобки объекта верхнего уровня (с учётом строк и экранирования):
+// стороны не закрывают соединение после отправки.
+// Не-объект и сообщение больше предела отклоняются сразу, без чтения остатка.
+// timeLimit (если задан) - на всё сообщение от прихода его первых байт: срок
+// канала сокращается до него, ожидание начала сообщения остаётся по сроку канала.
+enum class ReadStatus { Ok, Closed, Malformed, TooLarge, Timeout };
+
+constexpr size_t MAX_MESSAGE_BYTES = 16 * 1024 * 1024;
+
+ReadStatus readMessage(Channel& channel, std::string& message, bool& binary, size_t maxBytes = MAX_MESSAGE_BYTES,
+                       std::chrono::milliseconds timeLimit = std::chrono::milliseconds::zero());
+
+#endif // COURSEWORK_MESSAGE_CHANNEL_H
@@ -0,0 +1,795 @@
+// Микробенчмарки ядра (pm_bench): преобразования hex, SHA-512, Argon2id,
+// шифрование хранилища, таблицы пользователей и записей, проверка слабого пароля,
+// генерация сид-фразы, разбор и кодирование сообщений протокола, рукопожатия TLS.
+//
+// Результат печатается в JSON в формате Google Benchmark (context + benchmarks),
+// поэтому прогоны разных версий можно сравнивать его же tools/compare.py:
+//   pm_bench --benchmark_out=before.json
+//   pm_bench --benchmark_filter=HashTableUsers --benchmark_format=console
+//
+// isWeakPassword читает rockyou_1000k.txt из текущей директории: запускать из
+// каталога сборки клиента или сервера, иначе замеряется встроенный короткий список.
+#include "common_utils.h"
+#include "hashTableUrers.h"
+#include "json.hpp"
+#include "tlsChannel.h"
+#include "userHashTable.h"
+#include "vaultStream.h"
+#include "wireCodec.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <openssl/ssl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+constexpr int64_t MAX_ITERATIONS = 1000000000;
+
+// Состояние одного прогона: сколько итераций сделать и сколько времени они заняли.
+// Подготовку внутри цикла можно вынести из замера через pauseTiming/resumeTiming
+class State {
+private:
+    int64_t arg;
+    int64_t maxIterations;
+    int64_t remaining;
+    bool timing;
+    Clock::time_point realStart;
+    clock_t cpuStart;
+    double realSeconds;
+    double cpuSeconds;
+    int64_t bytesProcessed;
+    int64_t itemsProcessed;
+    string labelText;
+    string errorText;
+
+public:
+    State(int64_t arg, int64_t iterations)
+        : arg(arg), maxIterations(iterations), remaining(iterations), timing(false), cpuStart(0),
+          realSeconds(0), cpuSeconds(0), bytesProcessed(0), itemsProcessed(0) {}
+
+    // while (state.keepRunning()) { ... }
+    bool keepRunning() {
+        if (remaining == maxIterations && !timing && errorText.empty()) {
+            resumeTiming();
+        }
+        if (remaining > 0 && errorText.empty()) {
+            remaining--;
+            return true;
+        }
+        if (timing) {
+            pauseTiming();
+        }
+        return false;
+    }
+
+    void pauseTiming() {
+        realSeconds += chrono::duration<double>(Clock::now() - realStart).count();
+        cpuSeconds += static_cast<double>(clock() - cpuStart) / CLOCKS_PER_SEC;
+        timing = false;
+    }
+
+    void resumeTiming() {
+        timing = true;
+        cpuStart = clock();
+        realStart = Clock::now();
+    }
+
+    int64_t range() const { return arg; }
+    int64_t iterations() const { return maxIterations - remaining; }
+    double realTime() const { return realSeconds; }
+    double cpuTime() const { return cpuSeconds; }
+
+    void setBytesProcessed(int64_t bytes) { bytesProcessed = bytes; }
+    void setItemsProcessed(int64_t items) { itemsProcessed = items; }
+    int64_t bytes() const { return bytesProcessed; }
+    int64_t items() const { return itemsProcessed; }
+
+    void setLabel(const string& label) { labelText = label; }
+    const string& label() const { return labelText; }
+
+    // Бенчмарк не может выполниться на этой машине (например, нет AES-NI)
+    void skipWithError(const string& message) { errorText = message; }
+    const string& error() const { return errorText; }
+};
+
+struct Benchmark {
+    string name;
+    function<void(State&)> run;
+    vector<int64_t> args;  // пусто - один прогон без аргумента
+};
+
+vector<Benchmark>& registry() {
+    static vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+void registerBenchmark(const string& name, function<void(State&)> run, vector<int64_t> args = {}) {
+    registry().push_back({name, move(run), move(args)});
+}
+
+template <typename T>
+void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// ---------- Данные для замеров ----------
+
+string randomHex(size_t bytes) {
+    return toHex(generateSaltRaw(bytes));
+}
+
+// Поля как у настоящей записи users.json: SHA-512/Argon2 в hex, соли по 16 байт
+struct UserRecord {
+    string login;
+    string passwordHash;
+    string salt;
+    string seedHash;
+    string vaultSalt;
+};
+
+UserRecord makeUser(int64_t i) {
+    return {"user" + to_string(i), randomHex(32), randomHex(16), randomHex(64), randomHex(16)};
+}
+
+// Первые count записей; общий запас растёт по мере надобности
+vector<UserRecord>::const_iterator users(int64_t count) {
+    static vector<UserRecord> records;
+    while (static_cast<int64_t>(records.size()) < count) {
+        records.push_back(makeUser(static_cast<int64_t>(records.size())));
+    }
+    return records.cbegin();
+}
+
+// Заполненная таблица для замеров поиска; держим одну, чтобы 1M записей
+// не строились заново на каждом прогоне
+const HashTableUsers& filledUsersTable(int64_t count) {
+    static unique_ptr<HashTableUsers> table;
+    static int64_t tableCount = -1;
+    if (tableCount != count) {
+        table.reset();
+        table = make_unique<HashTableUsers>();
+        const auto records = users(count);
+        for (int64_t i = 0; i < count; i++) {
+            const auto& user = records[i];
+            table->insert(user.login, user.passwordHash, user.salt, user.seedHash, user.vaultSalt);
+        }
+        tableCount = count;
+    }
+    return *table;
+}
+
+void fillVault(UserHashTable& vault, int64_t entries) {
+    for (int64_t i = 0; i < entries; i++) {
+        vault.insert("service" + to_string(i), "2024-01-01 12:00:00", "login" + to_string(i),
+                     generate_password(20), "https://service" + to_string(i) + ".example.com",
+                     i % 4 == 0 ? "note for entry " + to_string(i) : "");
+    }
+}
+
+// Открытый текст хранилища из entries записей, как его шифрует клиент
+string vaultPlaintext(int64_t entries) {
+    UserHashTable vault;
+    fillVault(vault, entries);
+    return vault.toJson().dump();
+}
+
+bool weakPasswordListPresent() {
+    return ifstream("rockyou_1000k.txt").is_open();
+}
+
+// ---------- Бенчмарки ----------
+
+void BM_ToHex(State& state) {
+    const auto data = generateSaltRaw(static_cast<size_t>(state.range()));
+    while (state.keepRunning()) {
+        doNotOptimize(toHex(data));
+    }
+    state.setBytesProcessed(state.iterations() * state.range());
+}
+
+void BM_HexToBytes(State& state) {
+    const string hex = randomHex(static_cast<size_t>(state.range()));
+    while (state.keepRunning()) {
+        doNotOptimize(hexToBytes(hex));
+    }
+    state.setBytesProcessed(state.iterations() * state.range());
+}
+
+void BM_HashSHA512(State& state) {
+    const string data(static_cast<size_t>(state.range()), 'x');
+    while (state.keepRunning()) {
+        doNotOptimize(hashSHA512(data));
+    }
+    state.setBytesProcessed(state.iterations() * state.range());
+}
+
+void benchArgon2id(State& state, unsigned long long opsLimit, size_t memLimit) {
+    const auto salt = generateSaltRaw(crypto_pwhash_SALTBYTES);
+    while (state.keepRunning()) {
+        doNotOptimize(hashPasswordArgon2id("correct horse battery staple", salt, 32, opsLimit, memLimit));
+    }
+    state.setLabel("ops=" + to_string(opsLimit) + " mem=" + to_string(memLimit / (1024 * 1024)) + "MiB");
+}
+
+// Шифрование с ключом в виде байтов: на каждый вызов готовится новый VaultCipher
+void BM_EncryptAesGcm(State& state) {
+    const string plaintext = vaultPlaintext(state.range());
+    const auto key = generateSaltRaw(VAULT_KEY_BYTES);
+    while (state.keepRunning()) {
+        doNotOptimize(encrypt_aes_gcm(plaintext, key));
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(plaintext.size()));
+    state.setLabel(vaultAlgorithmName(defaultVaultAlgorithm()));
+}
+
+void BM_DecryptAesGcm(State& state) {
+    const string plaintext = vaultPlaintext(state.range());
+    const auto key = generateSaltRaw(VAULT_KEY_BYTES);
+    const auto blob = encrypt_aes_gcm(plaintext, key);
+    while (state.keepRunning()) {
+        doNotOptimize(decrypt_aes_gcm(blob, key));
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(plaintext.size()));
+    state.setLabel(vaultAlgorithmName(defaultVaultAlgorithm()));
+}
+
+// То же с ключом сессии, как шифрует клиент после входа
+void BM_EncryptAesGcmSession(State& state) {
+    const string plaintext = vaultPlaintext(state.range());
+    const VaultCipher cipher(generateSaltRaw(VAULT_KEY_BYTES));
+    while (state.keepRunning()) {
+        doNotOptimize(encrypt_aes_gcm(plaintext, cipher));
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(plaintext.size()));
+    state.setLabel(vaultAlgorithmName(defaultVaultAlgorithm()));
+}
+
+void BM_DecryptAesGcmSession(State& state) {
+    const string plaintext = vaultPlaintext(state.range());
+    const VaultCipher cipher(generateSaltRaw(VAULT_KEY_BYTES));
+    const auto blob = encrypt_aes_gcm(plaintext, cipher);
+    while (state.keepRunning()) {
+        doNotOptimize(decrypt_aes_gcm(blob, cipher));
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(plaintext.size()));
+    state.setLabel(vaultAlgorithmName(defaultVaultAlgorithm()));
+}
+
+// Вставка в таблицу нужного размера - без rehash
+void BM_HashTableUsersInsert(State& state) {
+    const auto records = users(state.range());
+    const int capacity = static_cast<int>(clamp<int64_t>(state.range() * 2 + 1, 1, INT32_MAX));
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        auto* table = new HashTableUsers(capacity);
+        state.resumeTiming();
+        for (int64_t i = 0; i < state.range(); i++) {
+            const auto& user = records[i];
+            table->insert(user.login, user.passwordHash, user.salt, user.seedHash, user.vaultSalt);
+        }
+        state.pauseTiming();
+        delete table;
+        state.resumeTiming();
+    }
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+
+// Вставка с начальной ёмкости по умолчанию: разница с Insert - цена всех rehash
+void BM_HashTableUsersInsertRehash(State& state) {
+    const auto records = users(state.range());
+    while (state.keepRunning()) {
+        auto* table = new HashTableUsers();
+        for (int64_t i = 0; i < state.range(); i++) {
+            const auto& user = records[i];
+            table->insert(user.login, user.passwordHash, user.salt, user.seedHash, user.vaultSalt);
+        }
+        state.pauseTiming();
+        delete table;
+        state.resumeTiming();
+    }
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+
+void BM_HashTableUsersLookupHit(State& state) {
+    const auto records = users(state.range());
+    // searchLogin не const, хотя таблицу не меняет
+    auto& table = const_cast<HashTableUsers&>(filledUsersTable(state.range()));
+    int64_t next = 0;
+    while (state.keepRunning()) {
+        doNotOptimize(table.searchLogin(records[next].login));
+        next = (next + 7919) % state.range();
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_HashTableUsersLookupMiss(State& state) {
+    auto& table = const_cast<HashTableUsers&>(filledUsersTable(state.range()));
+    int64_t next = 0;
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        const string login = "missing" + to_string(next++);
+        state.resumeTiming();
+        doNotOptimize(table.searchLogin(login));
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_UserHashTableToJson(State& state) {
+    UserHashTable vault;
+    fillVault(vault, state.range());
+    while (state.keepRunning()) {
+        doNotOptimize(vault.toJson());
+    }
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+
+void BM_UserHashTableFromJson(State& state) {
+    UserHashTable source;
+    fillVault(source, state.range());
+    const json data = source.toJson();
+    while (state.keepRunning()) {
+        UserHashTable vault;
+        if (!vault.fromJson(data)) {
+            state.skipWithError("fromJson failed");
+        }
+    }
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+
+void BM_IsWeakPasswordHit(State& state) {
+    while (state.keepRunning()) {
+        doNotOptimize(isWeakPassword("123456"));
+    }
+    state.setLabel(weakPasswordListPresent() ? "rockyou_1000k.txt" : "builtin list");
+}
+
+// Промах - худший случай: просматривается весь список
+void BM_IsWeakPasswordMiss(State& state) {
+    const string password = generate_password(24);
+    while (state.keepRunning()) {
+        doNotOptimize(isWeakPassword(password));
+    }
+    state.setLabel(weakPasswordListPresent() ? "rockyou_1000k.txt" : "builtin list");
+}
+
+void BM_GenIndexSeedWord(State& state) {
+    while (state.keepRunning()) {
+        doNotOptimize(genIndexSeedWord());
+    }
+}
+
+// Запрос updateVault с хранилищем заданного размера (hex - вдвое длиннее)
+string updateVaultRequest(size_t vaultBytes) {
+    json request;
+    request["action"] = "updateVault";
+    request["username"] = "user42";
+    request["password"] = "correct horse battery staple";
+    request["vaultData"] = randomHex(vaultBytes);
+    request["baseVersion"] = 7;
+    return request.dump();
+}
+
+void BM_ParseRequestDom(State& state) {
+    const string text = updateVaultRequest(static_cast<size_t>(state.range()));
+    while (state.keepRunning()) {
+        doNotOptimize(json::parse(text));
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+
+// Разбор на месте портит буфер, поэтому копия запроса входит в замер
+void BM_ParseRequestInSitu(State& state) {
+    const string text = updateVaultRequest(static_cast<size_t>(state.range()));
+    string buffer;
+    WireObject message;
+    while (state.keepRunning()) {
+        buffer = text;
+        doNotOptimize(message.parse(buffer.data(), buffer.size()));
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+
+// Тот же запрос кадром бинарного протокола: хранилище сырыми байтами
+void BM_ParseRequestBinary(State& state) {
+    const string frame = binaryWireCodec().encode(json::parse(updateVaultRequest(static_cast<size_t>(state.range()))));
+    WireObject message;
+    while (state.keepRunning()) {
+        doNotOptimize(message.parseBinary(frame.data(), frame.size()));
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(frame.size()));
+}
+
+void benchEncodeResponse(State& state, const WireCodec& codec) {
+    json response;
+    response["status"] = "success";
+    response["vaultData"] = randomHex(static_cast<size_t>(state.range()));
+    response["vaultSalt"] = randomHex(16);
+    response["vaultVersion"] = 7;
+    size_t bytes = 0;
+    while (state.keepRunning()) {
+        string encoded = codec.encode(response);
+        bytes = encoded.size();
+        doNotOptimize(encoded);
+    }
+    state.setBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+
+// Рукопожатие TLS по loopback с самоподписанным сертификатом: сервер принимает
+// соединения в своём потоке и отвечает одним байтом. Итерация - соединение,
+// рукопожатие и первый байт ответа (с ним клиент получает билет сессии), так что
+// время итерации - задержка рукопожатия, а итераций в секунду - рукопожатий в
+// секунду; в CPU-время входят обе стороны
+void benchTlsHandshake(State& state, bool resume) {
+    string certPem;
+    string keyPem;
+    TlsContext::generateSelfSigned(certPem, keyPem);
+    unique_ptr<TlsContext> serverContext(TlsContext::serverFromPem(certPem, keyPem));
+    unique_ptr<TlsContext> clientContext(TlsContext::clientFromPem(certPem));
+    if (!resume) {
+        SSL_CTX_set_session_cache_mode(clientContext->handle(), SSL_SESS_CACHE_OFF);
+    }
+
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressLength = sizeof(address);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 64) != 0 || getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0) {
+        state.skipWithError("Не удалось открыть сокет на loopback");
+        if (listener >= 0) {
+            close(listener);
+        }
+        return;
+    }
+
+    thread server([&] {
+        while (true) {
+            const int fd = accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                return;  // сокет закрыт - замер окончен
+            }
+            TlsChannel channel(*serverContext, fd);
+            if (channel.accept()) {
+                channel.sendAll("k", 1);
+            }
+        }
+    });
+
+    auto handshake = [&](bool expectResumed) {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        TlsChannel channel(*clientContext, fd);
+        char reply = 0;
+        return channel.connect("127.0.0.1") && channel.receive(&reply, 1) == 1 && channel.resumed() == expectResumed;
+    };
+
+    // Первое соединение даёт билет для возобновления
+    bool ok = handshake(false);
+    while (ok && state.keepRunning()) {
+        ok = handshake(resume);
+    }
+    if (!ok) {
+        state.skipWithError(resume ? "Сессия TLS не возобновилась" : "Рукопожатие TLS не удалось");
+    }
+    state.setItemsProcessed(state.iterations());
+
+    shutdown(listener, SHUT_RDWR);
+    close(listener);
+    server.join();
+}
+
+void registerAll() {
+    const vector<int64_t> bufferSizes = {16, 1024, 64 * 1024, 1024 * 1024};
+    const vector<int64_t> vaultEntries = {10, 100, 1000, 10000};
+    const vector<int64_t> tableSizes = {1000, 10000, 100000, 1000000};
+
+    registerBenchmark("BM_ToHex", BM_ToHex, bufferSizes);
+    registerBenchmark("BM_HexToBytes", BM_HexToBytes, bufferSizes);
+    registerBenchmark("BM_HashSHA512", BM_HashSHA512, {64, 1024, 64 * 1024});
+
+    registerBenchmark("BM_HashPasswordArgon2id/interactive", [](State& state) {
+        benchArgon2id(state, crypto_pwhash_OPSLIMIT_INTERACTIVE, crypto_pwhash_MEMLIMIT_INTERACTIVE);
+    });
+    registerBenchmark("BM_HashPasswordArgon2id/moderate", [](State& state) {
+        benchArgon2id(state, crypto_pwhash_OPSLIMIT_MODERATE, crypto_pwhash_MEMLIMIT_MODERATE);
+    });
+    registerBenchmark("BM_HashPasswordArgon2id/sensitive", [](State& state) {
+        benchArgon2id(state, crypto_pwhash_OPSLIMIT_SENSITIVE, crypto_pwhash_MEMLIMIT_SENSITIVE);
+    });
+
+    registerBenchmark("BM_EncryptAesGcm", BM_EncryptAesGcm, vaultEntries);
+    registerBenchmark("BM_DecryptAesGcm", BM_DecryptAesGcm, vaultEntries);
+    registerBenchmark("BM_EncryptAesGcmSession", BM_EncryptAesGcmSession, vaultEntries);
+    registerBenchmark("BM_DecryptAesGcmSession", BM_DecryptAesGcmSession, vaultEntries);
+
+    registerBenchmark("BM_HashTableUsersInsert", BM_HashTableUsersInsert, tableSizes);
+    registerBenchmark("BM_HashTableUsersInsertRehash", BM_HashTableUsersInsertRehash, tableSizes);
+    registerBenchmark("BM_HashTableUsersLookupHit", BM_HashTableUsersLookupHit, tableSizes);
+    registerBenchmark("BM_HashTableUsersLookupMiss", BM_HashTableUsersLookupMiss, tableSizes);
+
+    registerBenchmark("BM_UserHashTableToJson", BM_UserHashTableToJson, {100, 1000, 10000});
+    registerBenchmark("BM_UserHashTableFromJson", BM_UserHashTableFromJson, {100, 1000, 10000});
+
+    registerBenchmark("BM_IsWeakPasswordHit", BM_IsWeakPasswordHit);
+    registerBenchmark("BM_IsWeakPasswordMiss", BM_IsWeakPasswordMiss);
+    registerBenchmark("BM_GenIndexSeedWord", BM_GenIndexSeedWord);
+
+    const vector<int64_t> messageSizes = {1024, 64 * 1024, 1024 * 1024};
+    registerBenchmark("BM_ParseRequestDom", BM_ParseRequestDom, messageSizes);
+    registerBenchmark("BM_ParseRequestInSitu", BM_ParseRequestInSitu, messageSizes);
+    registerBenchmark("BM_ParseRequestBinary", BM_ParseRequestBinary, messageSizes);
+    registerBenchmark("BM_EncodeResponseDom", [](State& state) {
+        benchEncodeResponse(state, DomJsonCodec());
+    }, messageSizes);
+    registerBenchmark("BM_EncodeResponseInSitu", [](State& state) {
+        benchEncodeResponse(state, InSituJsonCodec());
+    }, messageSizes);
+    registerBenchmark("BM_EncodeResponseBinary", [](State& state) {
+        benchEncodeResponse(state, BinaryWireCodec());
+    }, messageSizes);
+
+    registerBenchmark("BM_TlsHandshakeFull", [](State& state) {
+        benchTlsHandshake(state, false);
+    });
+    registerBenchmark("BM_TlsHandshakeResumed", [](State& state) {
+        benchTlsHandshake(state, true);
+    });
+}
+
+// ---------- Запуск и вывод ----------
+
+// Число итераций подбирается как в Google Benchmark: прогон повторяется
+// с увеличенным числом итераций, пока не займёт minTime секунд
+json runOne(const string& name, const function<void(State&)>& run, int64_t arg, double minTime) {
+    int64_t iterations = 1;
+    while (true) {
+        State state(arg, iterations);
+        run(state);
+#ifdef __GLIBC__
+        // Освобождённое предыдущим прогоном (миллион строк таблицы) glibc
+        // склеивает при первом крупном malloc; пусть это случится здесь, а не внутри замера
+        malloc_trim(0);
+#endif
+
+        const double elapsed = state.realTime();
+        if (!state.error().empty() || elapsed >= minTime || iterations >= MAX_ITERATIONS) {
+            json result;
+            result["name"] = name;
+            result["run_name"] = name;
+            result["run_type"] = "iteration";
+            result["iterations"] = state.iterations();
+            if (!state.error().empty()) {
+                result["error_occurred"] = true;
+                result["error_message"] = state.error();
+                return result;
+            }
+            const double perIteration = state.iterations() > 0 ? 1e9 / state.iterations() : 0;
+            result["real_time"] = state.realTime() * perIteration;
+            result["cpu_time"] = state.cpuTime() * perIteration;
+            result["time_unit"] = "ns";
+            if (state.bytes() > 0 && elapsed > 0) {
+                result["bytes_per_second"] = state.bytes() / elapsed;
+            }
+            if (state.items() > 0 && elapsed > 0) {
+                result["items_per_second"] = state.items() / elapsed;
+            }
+            if (!state.label().empty()) {
+                result["label"] = state.label();
+            }
+            return result;
+        }
+
+        double multiplier = elapsed > 0 ? minTime * 1.4 / elapsed : 10.0;
+        multiplier = min(multiplier, 10.0);
+        iterations = min(MAX_ITERATIONS, max(iterations + 1, static_cast<int64_t>(iterations * multiplier)));
+    }
+}
+
+json makeContext(const string& executable) {
+    char date[64];
+    const time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+    char host[256] = {0};
+    gethostname(host, sizeof(host) - 1);
+
+    json context;
+    context["date"] = date;
+    context["host_name"] = host;
+    context["executable"] = executable;
+    context["num_cpus"] = thread::hardware_concurrency();
+#ifdef NDEBUG
+    context["library_build_type"] = "release";
+#else
+    context["library_build_type"] = "debug";
+#endif
+    context["sodium_version"] = sodium_version_string();
+    context["vault_algorithm"] = vaultAlgorithmName(defaultVaultAlgorithm());
+    context["weak_password_list"] = weakPasswordListPresent() ? "rockyou_1000k.txt" : "builtin";
+    return context;
+}
+
+string formatRate(double perSecond, const char* unit) {
+    const char* prefixes[] = {"", "k", "M", "G"};
+    const double step = unit[0] == 'B' ? 1024 : 1000;
+    int p = 0;
+    while (perSecond >= step && p < 3) {
+        perSecond /= step;
+        p++;
+    }
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.1f%s%s/s", perSecond, prefixes[p], unit);
+    return buf;
+}
+
+void printConsole(const json& result) {
+    const string name = result["name"];
+    if (result.value("error_occurred", false)) {
+        printf("%-48s ERROR: %s\n", name.c_str(), result["error_message"].get<string>().c_str());
+        return;
+    }
+    string extra;
+    if (result.contains("bytes_per_second")) {
+        extra += " " + formatRate(result["bytes_per_second"].get<double>(), "B");
+    }
+    if (result.contains("items_per_second")) {
+        extra += " " + formatRate(result["items_per_second"].get<double>(), "");
+    }
+    if (result.contains("label")) {
+        extra += " " + result["label"].get<string>();
+    }
+    printf("%-48s %14.0f ns %14.0f ns %12lld%s\n", name.c_str(), result["real_time"].get<double>(),
+           result["cpu_time"].get<double>(), result["iterations"].get<long long>(), extra.c_str());
+    fflush(stdout);
+}
+
+void printUsage(const char* program) {
+    cerr << "Использование: " << program << " [опции]\n"
+         << "  --benchmark_filter=<regex>      только бенчмарки с подходящим именем\n"
+         << "  --benchmark_min_time=<секунды>  минимальное время одного замера (0.5)\n"
+         << "  --benchmark_format=json|console формат вывода в stdout (json)\n"
+         << "  --benchmark_out=<файл>          дополнительно записать JSON в файл\n"
+         << "  --benchmark_list_tests          только список бенчмарков\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!initCryptoRuntime()) {
+        cerr << "Ошибка инициализации libsodium" << endl;
+        return 1;
+    }
+
+    string filter = ".";
+    double minTime = 0.5;
+    string format = "json";
+    string outFile;
+    bool listOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        const string option = argv[i];
+        auto valueOf = [&option](const string& prefix, string& value) {
+            if (option.compare(0, prefix.size(), prefix) != 0) {
+                return false;
+            }
+            value = option.substr(prefix.size());
+            return true;
+        };
+
+        string value;
+        if (valueOf("--benchmark_filter=", value)) {
+            filter = value;
+        } else if (valueOf("--benchmark_min_time=", value)) {
+            minTime = atof(value.c_str());
+        } else if (valueOf("--benchmark_format=", value) && (value == "json" || value == "console")) {
+            format = value;
+        } else if (valueOf("--benchmark_out=", value)) {
+            outFile = value;
+        } else if (option == "--benchmark_list_tests") {
+            listOnly = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    regex filterRegex;
+    try {
+        filterRegex = regex(filter);
+    } catch (const regex_error& e) {
+        cerr << "Некорректный фильтр: " << filter << endl;
+        return 1;
+    }
+
+    registerAll();
+
+    // Полный список имён вида BM_ToHex/1024 в порядке регистрации
+    vector<tuple<string, const Benchmark*, int64_t>> selected;
+    for (const auto& bench : registry()) {
+        if (bench.args.empty()) {
+            selected.emplace_back(bench.name, &bench, 0);
+        }
+        for (int64_t arg : bench.args) {
+            selected.emplace_back(bench.name + "/" + to_string(arg), &bench, arg);
+        }
+    }
+    selected.erase(remove_if(selected.begin(), selected.end(),
+                             [&filterRegex](const auto& entry) {
+                                 return !regex_search(get<0>(entry), filterRegex);
+                             }),
+                   selected.end());
+
+    if (listOnly) {
+        for (const auto& entry : selected) {
+            cout << get<0>(entry) << "\n";
+        }
+        return 0;
+    }
+
+    json report;
+    report["context"] = makeContext(argv[0]);
+    report["benchmarks"] = json::array();
+
+    if (format == "console") {
+        printf("%-48s %17s %17s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+    }
+
+    try {
+        for (const auto& [name, bench, arg] : selected) {
+            if (format == "json") {
+                cerr << name << "..." << endl;  // прогресс, stdout остаётся чистым JSON
+            }
+            json result = runOne(name, bench->run, arg, minTime);
+            if (format == "console") {
+                printConsole(result);
+            }
+            report["benchmarks"].push_back(move(result));
+        }
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
+
+    if (format == "json") {
+        cout << report.dump(2) << endl;
+    }
+    if (!outFile.empty()) {
+        ofstream out(outFile);
+        if (!out.is_open()) {
+            cerr << "Не удалось открыть файл для записи: " << outFile << endl;
+            return 1;
+        }
+        out << report.dump(2) << endl;
+    }
+    return 0;
+}
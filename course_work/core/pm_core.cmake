@@ -0,0 +1,20 @@
+# Подключение pm_core из CMakeLists.txt клиента и сервера: каждый из них
+# собирается и сам по себе, и из корневого course_work/CMakeLists.txt,
+# а библиотека при этом создаётся один раз.
+option(PM_ENABLE_LTO "Сборка с оптимизацией при компоновке (LTO)" ON)
+
+if(PM_ENABLE_LTO AND NOT DEFINED CMAKE_INTERPROCEDURAL_OPTIMIZATION)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT PM_LTO_SUPPORTED OUTPUT PM_LTO_OUTPUT LANGUAGES CXX)
+    if(PM_LTO_SUPPORTED)
+        # LTO включается для всех целей проекта: объектные файлы ядра собираются
+        # с -flto, и функции ядра встраиваются прямо в код сервера и клиента
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+    else()
+        message(STATUS "LTO не поддерживается компилятором: ${PM_LTO_OUTPUT}")
+    endif()
+endif()
+
+if(NOT TARGET pm_core)
+    add_subdirectory(${CMAKE_CURRENT_LIST_DIR} ${CMAKE_BINARY_DIR}/pm_core)
+endif()
@@ -0,0 +1,34 @@
+# Общее ядро клиента и сервера (в CMake - библиотека pm_core, см. core/CMakeLists.txt)
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/common_utils.cpp \
+    $$PWD/hashTableUrers.cpp \
+    $$PWD/userHashTable.cpp \
+    $$PWD/vaultStream.cpp \
+    $$PWD/register.cpp \
+    $$PWD/log_in.cpp \
+    $$PWD/logger.cpp \
+    $$PWD/wireCodec.cpp \
+    $$PWD/messageChannel.cpp \
+    $$PWD/tlsChannel.cpp
+
+HEADERS += \
+    $$PWD/common_utils.h \
+    $$PWD/hashTableUrers.h \
+    $$PWD/userHashTable.h \
+    $$PWD/vaultStream.h \
+    $$PWD/register.h \
+    $$PWD/log_in.h \
+    $$PWD/logger.h \
+    $$PWD/wireCodec.h \
+    $$PWD/messageChannel.h \
+    $$PWD/tlsChannel.h \
+    $$PWD/json.hpp
+
+# TLS между клиентом и сервером
+LIBS += -lssl -lcrypto
+
+# Оптимизация при компоновке (LTO), как и в CMake-сборке
+CONFIG += ltcg
@@ -0,0 +1,407 @@
+#include "tlsChannel.h"
+
+#include <openssl/bio.h>
+#include <openssl/ec.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// Билет сессии действует рабочий день: дольше полное рукопожатие не нужно
+constexpr long SESSION_LIFETIME_SECONDS = 8 * 60 * 60;
+constexpr long CERT_VALIDITY_SECONDS = 825L * 24 * 60 * 60;
+constexpr char SESSION_ID_CONTEXT[] = "password_manager";
+
+struct BioFree { void operator()(BIO* bio) const { BIO_free(bio); } };
+struct X509Free { void operator()(X509* cert) const { X509_free(cert); } };
+struct KeyFree { void operator()(EVP_PKEY* key) const { EVP_PKEY_free(key); } };
+struct ContextFree { void operator()(SSL_CTX* ctx) const { SSL_CTX_free(ctx); } };
+struct BignumFree { void operator()(BIGNUM* bn) const { BN_free(bn); } };
+using BioPtr = unique_ptr<BIO, BioFree>;
+using X509Ptr = unique_ptr<X509, X509Free>;
+using KeyPtr = unique_ptr<EVP_PKEY, KeyFree>;
+using ContextPtr = unique_ptr<SSL_CTX, ContextFree>;
+using BignumPtr = unique_ptr<BIGNUM, BignumFree>;
+
+// Текст первой ошибки OpenSSL из очереди потока
+string opensslError(const string& what) {
+    const unsigned long code = ERR_get_error();
+    ERR_clear_error();
+    if (code == 0) {
+        return what;
+    }
+    char text[256];
+    ERR_error_string_n(code, text, sizeof(text));
+    return what + ": " + text;
+}
+
+string readFile(const string& path) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        throw runtime_error("Не удалось открыть " + path);
+    }
+    stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// Права задаются при создании: ключ не должен быть доступен другим ни на миг
+void writeFile(const string& path, const string& content, mode_t mode) {
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (fd < 0) {
+        throw runtime_error("Не удалось записать " + path);
+    }
+    const bool written = write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size());
+    close(fd);
+    if (!written) {
+        throw runtime_error("Не удалось записать " + path);
+    }
+}
+
+BioPtr memoryBio(const string& pem) {
+    BioPtr bio(BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size())));
+    if (!bio) {
+        throw runtime_error(opensslError("BIO_new_mem_buf"));
+    }
+    return bio;
+}
+
+string bioContents(BIO* bio) {
+    char* data = nullptr;
+    const long length = BIO_get_mem_data(bio, &data);
+    return string(data, static_cast<size_t>(length));
+}
+
+void addExtension(X509* cert, int nid, const char* value) {
+    X509V3_CTX v3;
+    X509V3_set_ctx_nodb(&v3);
+    X509V3_set_ctx(&v3, cert, cert, nullptr, nullptr, 0);
+    X509_EXTENSION* extension = X509V3_EXT_conf_nid(nullptr, &v3, nid, value);
+    if (!extension || !X509_add_ext(cert, extension, -1)) {
+        X509_EXTENSION_free(extension);
+        throw runtime_error(opensslError("Не удалось добавить расширение сертификата"));
+    }
+    X509_EXTENSION_free(extension);
+}
+
+// BIO поверх сокета: как стандартный, но send с MSG_NOSIGNAL, а чтение
+// соблюдает срок канала (см. Channel::setReadDeadline)
+int socketWrite(BIO* bio, const char* data, int length) {
+    const int fd = static_cast<const Channel*>(BIO_get_data(bio))->socket();
+    BIO_clear_retry_flags(bio);
+    while (true) {
+        const ssize_t n = send(fd, data, static_cast<size_t>(length), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return static_cast<int>(n);
+    }
+}
+
+int socketRead(BIO* bio, char* data, int length) {
+    const Channel* channel = static_cast<const Channel*>(BIO_get_data(bio));
+    const int fd = channel->socket();
+    BIO_clear_retry_flags(bio);
+    if (!waitReadable(fd, channel->deadline())) {
+        return -1;
+    }
+    while (true) {
+        const ssize_t n = recv(fd, data, static_cast<size_t>(length), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return static_cast<int>(n);
+    }
+}
+
+long socketCtrl(BIO*, int command, long, void*) {
+    return command == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+BIO_METHOD* socketMethod() {
+    static BIO_METHOD* method = [] {
+        BIO_METHOD* created = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "pm socket");
+        BIO_meth_set_write(created, socketWrite);
+        BIO_meth_set_read(created, socketRead);
+        BIO_meth_set_ctrl(created, socketCtrl);
+        return created;
+    }();
+    return method;
+}
+
+ContextPtr newContext(const SSL_METHOD* method) {
+    ContextPtr ctx(SSL_CTX_new(method));
+    if (!ctx) {
+        throw runtime_error(opensslError("SSL_CTX_new"));
+    }
+    SSL_CTX_set_min_proto_version(ctx.get(), TLS1_2_VERSION);
+    // Клиенты закрывают соединение без close_notify - это не ошибка
+    SSL_CTX_set_options(ctx.get(), SSL_OP_IGNORE_UNEXPECTED_EOF);
+    return ctx;
+}
+
+} // namespace
+
+TlsContext::TlsContext(SSL_CTX* ctx, bool server) : ctx(ctx), server(server), session(nullptr) {
+    SSL_CTX_set_app_data(ctx, this);
+}
+
+TlsContext::~TlsContext() {
+    if (session) {
+        SSL_SESSION_free(session);
+    }
+    SSL_CTX_free(ctx);
+}
+
+void TlsContext::generateSelfSigned(string& certPem, string& keyPem) {
+    KeyPtr key(EVP_EC_gen("P-256"));
+    X509Ptr cert(X509_new());
+    BignumPtr serial(BN_new());
+    if (!key || !cert || !serial) {
+        throw runtime_error(opensslError("Не удалось создать ключ сертификата"));
+    }
+
+    X509_set_version(cert.get(), 2);
+    BN_rand(serial.get(), 64, BN_RAND_TOP_ANY, BN_RAND_BOTTOM_ANY);
+    BN_to_ASN1_INTEGER(serial.get(), X509_get_serialNumber(cert.get()));
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), CERT_VALIDITY_SECONDS);
+    X509_set_pubkey(cert.get(), key.get());
+
+    X509_NAME* name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+
+    // Сертификат сам себе удостоверяющий центр: клиент доверяет ему напрямую
+    addExtension(cert.get(), NID_basic_constraints, "critical,CA:TRUE");
+    addExtension(cert.get(), NID_key_usage, "critical,digitalSignature,keyCertSign");
+    addExtension(cert.get(), NID_ext_key_usage, "serverAuth");
+    addExtension(cert.get(), NID_subject_alt_name, "DNS:localhost,IP:127.0.0.1");
+
+    if (!X509_sign(cert.get(), key.get(), EVP_sha256())) {
+        throw runtime_error(opensslError("Не удалось подписать сертификат"));
+    }
+
+    BioPtr certBio(BIO_new(BIO_s_mem()));
+    BioPtr keyBio(BIO_new(BIO_s_mem()));
+    if (!certBio || !keyBio || !PEM_write_bio_X509(certBio.get(), cert.get()) ||
+        !PEM_write_bio_PrivateKey(keyBio.get(), key.get(), nullptr, nullptr, 0, nullptr, nullptr)) {
+        throw runtime_error(opensslError("Не удалось сохранить сертификат"));
+    }
+    certPem = bioContents(certBio.get());
+    keyPem = bioContents(keyBio.get());
+}
+
+TlsContext* TlsContext::serverFromPem(const string& certPem, const string& keyPem) {
+    ContextPtr ctx = newContext(TLS_server_method());
+
+    BioPtr certBio = memoryBio(certPem);
+    X509Ptr cert(PEM_read_bio_X509(certBio.get(), nullptr, nullptr, nullptr));
+    BioPtr keyBio = memoryBio(keyPem);
+    KeyPtr key(PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr));
+    if (!cert || !key || SSL_CTX_use_certificate(ctx.get(), cert.get()) != 1 ||
+        SSL_CTX_use_PrivateKey(ctx.get(), key.get()) != 1 || SSL_CTX_check_private_key(ctx.get()) != 1) {
+        throw runtime_error(opensslError("Некорректный сертификат или ключ сервера"));
+    }
+
+    // Возобновление: TLS 1.3 - билетами (один на соединение), TLS 1.2 - ещё и кэшем сессий
+    SSL_CTX_set_session_cache_mode(ctx.get(), SSL_SESS_CACHE_SERVER);
+    SSL_CTX_set_session_id_context(ctx.get(), reinterpret_cast<const unsigned char*>(SESSION_ID_CONTEXT),
+                                   sizeof(SESSION_ID_CONTEXT) - 1);
+    SSL_CTX_set_timeout(ctx.get(), SESSION_LIFETIME_SECONDS);
+    SSL_CTX_set_num_tickets(ctx.get(), 1);
+
+    return new TlsContext(ctx.release(), true);
+}
+
+TlsContext* TlsContext::clientFromPem(const string& caPem) {
+    ContextPtr ctx = newContext(TLS_client_method());
+
+    X509_STORE* store = SSL_CTX_get_cert_store(ctx.get());
+    BioPtr bio = memoryBio(caPem);
+    int trusted = 0;
+    while (X509* cert = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr)) {
+        X509_STORE_add_cert(store, cert);
+        X509_free(cert);
+        trusted++;
+    }
+    ERR_clear_error();  // конец файла читается как ошибка PEM
+    if (trusted == 0) {
+        throw runtime_error("В файле нет сертификатов");
+    }
+    SSL_CTX_set_verify(ctx.get(), SSL_VERIFY_PEER, nullptr);
+
+    // Сессии хранит сам контекст (последнюю): кэш OpenSSL клиенту не нужен
+    SSL_CTX_set_session_cache_mode(ctx.get(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx.get(), onNewSession);
+
+    return new TlsContext(ctx.release(), false);
+}
+
+TlsContext* TlsContext::createServer(const string& certPath, const string& keyPath) {
+    string certPem;
+    string keyPem;
+    ifstream existing(certPath);
+    if (existing.good()) {
+        existing.close();
+        certPem = readFile(certPath);
+        keyPem = readFile(keyPath);
+    } else {
+        generateSelfSigned(certPem, keyPem);
+        writeFile(keyPath, keyPem, 0600);
+        writeFile(certPath, certPem, 0644);
+    }
+    return serverFromPem(certPem, keyPem);
+}
+
+TlsContext* TlsContext::createClient(const string& caPath) {
+    return clientFromPem(readFile(caPath));
+}
+
+int TlsContext::onNewSession(SSL* ssl, SSL_SESSION* newSession) {
+    TlsContext* self = static_cast<TlsContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    lock_guard<mutex> lock(self->sessionMutex);
+    if (self->session) {
+        SSL_SESSION_free(self->session);
+    }
+    self->session = newSession;
+    return 1;  // ссылка остаётся у контекста
+}
+
+SSL_SESSION* TlsContext::resumableSession() {
+    lock_guard<mutex> lock(sessionMutex);
+    if (!session) {
+        return nullptr;
+    }
+    SSL_SESSION_up_ref(session);
+    return session;
+}
+
+TlsChannel::TlsChannel(TlsContext& context, int socket)
+    : Channel(socket), context(context), ssl(SSL_new(context.handle())), established(false) {
+    if (ssl) {
+        BIO* bio = BIO_new(socketMethod());
+        BIO_set_data(bio, static_cast<Channel*>(this));
+        BIO_set_init(bio, 1);
+        SSL_set_bio(ssl, bio, bio);
+    }
+}
+
+TlsChannel::~TlsChannel() {
+    if (ssl) {
+        if (established) {
+            SSL_shutdown(ssl);  // close_notify, ответ не ждём
+        }
+        SSL_free(ssl);
+    }
+}
+
+bool TlsChannel::finishHandshake(int result) {
+    if (result == 1) {
+        established = true;
+        return true;
+    }
+    const long verify = SSL_get_verify_result(ssl);
+    if (verify != X509_V_OK) {
+        ERR_clear_error();
+        lastError = string("Сертификат не принят: ") + X509_verify_cert_error_string(verify);
+    } else {
+        lastError = opensslError("Рукопожатие TLS не удалось");
+    }
+    return false;
+}
+
+bool TlsChannel::accept() {
+    if (!ssl) {
+        lastError = "SSL_new";
+        return false;
+    }
+    ERR_clear_error();
+    return finishHandshake(SSL_accept(ssl));
+}
+
+bool TlsChannel::connect(const string& host) {
+    if (!ssl) {
+        lastError = "SSL_new";
+        return false;
+    }
+    in_addr address;
+    if (inet_pton(AF_INET, host.c_str(), &address) == 1) {
+        X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), host.c_str());
+    } else {
+        SSL_set_tlsext_host_name(ssl, host.c_str());
+        SSL_set1_host(ssl, host.c_str());
+    }
+
+    if (SSL_SESSION* session = context.resumableSession()) {
+        SSL_set_session(ssl, session);
+        SSL_SESSION_free(session);
+    }
+    ERR_clear_error();
+    return finishHandshake(SSL_connect(ssl));
+}
+
+bool TlsChannel::resumed() const {
+    return ssl && SSL_session_reused(ssl) == 1;
+}
+
+ssize_t TlsChannel::receive(char* buffer, size_t length) {
+    if (!established) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    ERR_clear_error();
+    const int n = SSL_read(ssl, buffer, static_cast<int>(min<size_t>(length, INT_MAX)));
+    if (n > 0) {
+        return n;
+    }
+    const int savedErrno = errno;
+    const int error = SSL_get_error(ssl, n);
+    if (error == SSL_ERROR_ZERO_RETURN) {
+        return 0;
+    }
+    ERR_clear_error();
+    established = false;
+    if (error == SSL_ERROR_SYSCALL && (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK)) {
+        errno = savedErrno;  // таймаут сокета
+        return -1;
+    }
+    errno = ECONNRESET;
+    return -1;
+}
+
+bool TlsChannel::sendAll(const char* data, size_t length) {
+    if (!established) {
+        return false;
+    }
+    size_t sent = 0;
+    while (sent < length) {
+        ERR_clear_error();
+        const int n = SSL_write(ssl, data + sent, static_cast<int>(min<size_t>(length - sent, INT_MAX)));
+        if (n <= 0) {
+            ERR_clear_error();
+            established = false;
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
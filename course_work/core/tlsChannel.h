@@ -0,0 +1,80 @@
+#ifndef COURSEWORK_TLS_CHANNEL_H
+#define COURSEWORK_TLS_CHANNEL_H
+
+#include <mutex>
+#include <string>
+#include "messageChannel.h"
+
+struct ssl_st;
+struct ssl_ctx_st;
+struct ssl_session_st;
+
+// Настройки TLS (OpenSSL): не ниже TLS 1.2, сессии возобновляются по билетам,
+// так что полное рукопожатие с подписью сертификата делается один раз на
+// клиента, а повторные соединения обходятся без него.
+// Создаётся один раз и используется из любых потоков.
+class TlsContext {
+public:
+    ~TlsContext();
+
+    // Сертификат и ключ сервера из PEM-файлов. Если их нет - создаётся
+    // самоподписанный сертификат (ECDSA P-256) на localhost и 127.0.0.1
+    // и сохраняется туда же; клиенту передаётся файл сертификата.
+    // Ошибки - runtime_error
+    static TlsContext* createServer(const std::string& certPath, const std::string& keyPath);
+    // Клиент доверяет только сертификатам из caPath (для самоподписанного - он сам)
+    static TlsContext* createClient(const std::string& caPath);
+
+    // То же без файлов (pm_bench)
+    static void generateSelfSigned(std::string& certPem, std::string& keyPem);
+    static TlsContext* serverFromPem(const std::string& certPem, const std::string& keyPem);
+    static TlsContext* clientFromPem(const std::string& caPem);
+
+    ssl_ctx_st* handle() const { return ctx; }
+    bool isServer() const { return server; }
+
+    // Клиент: последняя выданная сервером сессия для возобновления
+    // (со своей ссылкой, освобождается вызывающим) или nullptr
+    ssl_session_st* resumableSession();
+
+private:
+    ssl_ctx_st* ctx;
+    bool server;
+    std::mutex sessionMutex;
+    ssl_session_st* session;
+
+    TlsContext(ssl_ctx_st* ctx, bool server);
+    static int onNewSession(ssl_st* ssl, ssl_session_st* session);
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+};
+
+// TLS поверх сокета. Запись идёт через send с MSG_NOSIGNAL: разрыв
+// соединения не должен ронять процесс сигналом SIGPIPE
+class TlsChannel : public Channel {
+public:
+    TlsChannel(TlsContext& context, int socket);
+    ~TlsChannel() override;
+
+    // Рукопожатие: accept - на сервере, connect - на клиенте (с проверкой
+    // сертификата по имени или адресу host и попыткой возобновить сессию)
+    bool accept();
+    bool connect(const std::string& host);
+    bool resumed() const;
+    // Причина неудачного рукопожатия - для лога, без данных соединения
+    const std::string& error() const { return lastError; }
+
+    ssize_t receive(char* buffer, size_t length) override;
+    bool sendAll(const char* data, size_t length) override;
+
+private:
+    TlsContext& context;
+    ssl_st* ssl;
+    bool established;
+    std::string lastError;
+
+    bool finishHandshake(int result);
+};
+
+#endif // COURSEWORK_TLS_CHANNEL_H
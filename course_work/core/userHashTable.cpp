@@ -0,0 +1,368 @@
+#include "userHashTable.h"
+#include "vaultStream.h"
+#include "logger.h"
+#include <algorithm>
+#include <vector>
+#include <fstream>
+#include <sodium.h>
+#include <stdexcept>
+
+using namespace std;
+using json = nlohmann::json;
+
+constexpr unsigned long base = 2166136261;
+constexpr unsigned long prime = 16777619;
+const int primes[] = {5, 7, 11, 23, 47, 97, 197, 397, 797, 1597, 3203, 6421, 12853};
+// Доля занятых ячеек (живые записи и надгробия), после которой таблица перестраивается
+constexpr double MAX_LOAD = 0.75;
+
+int UserHashTable::hashFunction(const std::pair<std::string, std::string>& loginAndService) const {
+    // FNV-1a по логину и сервису подряд, без сборки общей строки
+    unsigned long hash = base;
+    for (const auto& c : loginAndService.first) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= prime;
+    }
+    for (const auto& c : loginAndService.second) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= prime;
+    }
+    return hash % capacity;
+}
+
+UserHashTable::UserHashTable(const int cap) : capacity(cap), size(0), tombstones(0), nextId(0) {
+    table = new UserHashTableNode[cap];
+    for (size_t i = 0; i < cap; i++) {
+        table[i] = UserHashTableNode();
+    }
+}
+
+// Живые записи переносятся в новую таблицу целиком, вместе с id; надгробия
+// не переносятся. Для наблюдателей записи не меняются, уведомлений нет
+void UserHashTable::rebuild(const size_t newCapacity) {
+    UserHashTableNode* oldTable = table;
+    const size_t oldCapacity = capacity;
+
+    table = new UserHashTableNode[newCapacity];
+    capacity = newCapacity;
+    tombstones = 0;
+
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (oldTable[i].isNull || oldTable[i].isDelete) {
+            continue;
+        }
+        const int h = hashFunction(make_pair(oldTable[i]._login, oldTable[i]._service));
+        for (size_t j = 0; j < capacity; j++) {
+            const size_t index = (h + j) % capacity;
+            if (table[index].isNull) {
+                table[index] = std::move(oldTable[i]);
+                idIndex[table[index]._id] = index;
+                break;
+            }
+        }
+    }
+
+    delete[] oldTable;
+}
+
+bool UserHashTable::rehash() {
+    // Если живых записей не больше половины, место занимают надгробия -
+    // достаточно их убрать
+    if (size + 1 <= capacity / 2) {
+        compact();
+        return true;
+    }
+
+    size_t newCap = 0;
+    for (const int prime1 : primes) {
+        if (prime1 > capacity) {
+            newCap = prime1;
+            break;
+        }
+    }
+
+    if (newCap == 0) {
+        newCap = capacity * 2;
+    }
+
+    rebuild(newCap);
+    return true;
+}
+
+void UserHashTable::compact() {
+    rebuild(capacity);
+}
+
+bool UserHashTable::insert(const std::string& service, const std::string& lastTime,
+                           const std::string& login, const std::string& password,
+                           const std::string& url, const std::string& note) {
+    // Сначала проверяем, существует ли уже такая запись
+    if (update(service, lastTime, login, password, url, note)) {
+        return true;
+    }
+
+    if (static_cast<double>(size + tombstones + 1) / capacity > MAX_LOAD) {
+        if (!rehash()) return false;
+    }
+
+    // Записи нет: занимаем первую свободную ячейку или надгробие на пути пробы
+    const int h = hashFunction(make_pair(login, service));
+    for (size_t i = 0; i < capacity; i++) {
+        const size_t index = (h + i) % capacity;
+        if (table[index].isDelete || table[index].isNull) {
+            if (table[index].isDelete) {
+                tombstones--;
+            }
+            table[index]._service = service;
+            table[index]._lastModifiedTime = lastTime;
+            table[index]._login = login;
+            table[index]._password = password;
+            table[index]._url = url;
+            table[index]._note = note;
+            table[index]._id = ++nextId;
+            table[index].isNull = table[index].isDelete = false;
+            idIndex[table[index]._id] = index;
+            size++;
+            for (Observer* observer : observers) observer->entryStored(table[index]);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool UserHashTable::update(const std::string& service, const std::string& lastTime,
+                           const std::string& login, const std::string& password,
+                           const std::string& url, const std::string& note) {
+    const size_t index = findIndex(service, login);
+    if (index == capacity) {
+        return false;
+    }
+
+    table[index]._lastModifiedTime = lastTime;
+    table[index]._password = password;
+    table[index]._url = url;
+    table[index]._note = note;
+    for (Observer* observer : observers) observer->entryStored(table[index]);
+    return true;
+}
+
+size_t UserHashTable::findIndex(const std::string& service, const std::string& login) const {
+    auto key = make_pair(login, service);
+    int h = hashFunction(key);
+
+    for (size_t i = 0; i < capacity; i++) {
+        const size_t index = (h + i) % capacity;
+        
+        // Если достигли пустой ячейки, записи нет; надгробия пропускаем
+        if (table[index].isNull) {
+            return capacity;
+        }
+        
+        if (!table[index].isDelete &&
+            table[index]._login == login && table[index]._service == service) {
+            return index;
+        }
+    }
+    return capacity;
+}
+
+bool UserHashTable::remove(const std::string& service, const std::string& login) {
+    const size_t index = findIndex(service, login);
+    if (index == capacity) {
+        return false;
+    }
+    
+    // Помечаем запись как удалённую
+    const size_t id = table[index]._id;
+    table[index].isDelete = true;
+    idIndex.erase(id);
+    size--;
+    tombstones++;
+    for (Observer* observer : observers) observer->entryRemoved(id);
+
+    // Длинные цепочки из надгробий замедляют поиск, в том числе отсутствующих записей
+    if (tombstones > capacity / 4) {
+        compact();
+    }
+    return true;
+}
+
+const UserHashTable::Entry* UserHashTable::find(const std::string& service, const std::string& login) const {
+    const size_t index = findIndex(service, login);
+    return index == capacity ? nullptr : &table[index];
+}
+
+const UserHashTable::Entry* UserHashTable::findById(const size_t id) const {
+    auto it = idIndex.find(id);
+    return it == idIndex.end() ? nullptr : &table[it->second];
+}
+
+std::vector<size_t> UserHashTable::probeHistogram() const {
+    std::vector<size_t> histogram;
+    for (size_t i = 0; i < capacity; i++) {
+        if (table[i].isNull || table[i].isDelete) {
+            continue;
+        }
+        const size_t home = hashFunction(make_pair(table[i]._login, table[i]._service));
+        const size_t distance = (i + capacity - home) % capacity;
+        if (distance >= histogram.size()) {
+            histogram.resize(distance + 1, 0);
+        }
+        histogram[distance]++;
+    }
+    return histogram;
+}
+
+void UserHashTable::addObserver(Observer* observer) {
+    observers.push_back(observer);
+    observer->entriesReset();
+    forEach([observer](const Entry& entry) { observer->entryStored(entry); });
+}
+
+void UserHashTable::removeObserver(Observer* observer) {
+    observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+}
+
+void UserHashTable::loadFromFile(const std::string& filename) {
+    json docs = json::array();
+    ifstream file(filename);
+    if (file.is_open()) {
+        try {
+            file >> docs;
+        } catch (...) {
+            logWarn("Файл повреждён — начинаем с нуля", {{"file", filename}});
+        }
+        file.close();
+    }
+    for (const auto& doc : docs) {
+        string service = doc["_service"];
+        string lastTime = doc["_lastModifiedTime"];
+        string login = doc["_login"];
+        string password = doc["_password"];
+        string url = doc["_url"];
+        string note = doc["_note"];
+        insert(service, lastTime, login, password, url, note);
+    }
+}
+
+void UserHashTable::saveToFile(const std::string& filename) const {
+    json data = json::array();
+    for (size_t i = 0; i < capacity; i++) {
+        if (!table[i].isNull && !table[i].isDelete) {
+            json obj;
+            obj["_service"] = table[i]._service;
+            obj["_lastModifiedTime"] = table[i]._lastModifiedTime;
+            obj["_login"] = table[i]._login;
+            obj["_password"] = table[i]._password;
+            obj["_url"] = table[i]._url;
+            obj["_note"] = table[i]._note;
+            data.push_back(obj);
+        }
+    }
+
+    ofstream file(filename);
+    if (file.is_open()) {
+        file << data.dump(4);
+        file.close();
+    } else {
+        logError("Не удалось открыть файл для записи", {{"file", filename}});
+    }
+}
+
+nlohmann::json UserHashTable::toJson() const {
+    json data = json::array();
+    for (size_t i = 0; i < capacity; i++) {
+        if (!table[i].isNull && !table[i].isDelete) {
+            json obj;
+            obj["_service"] = table[i]._service;
+            obj["_lastModifiedTime"] = table[i]._lastModifiedTime;
+            obj["_login"] = table[i]._login;
+            obj["_password"] = table[i]._password;
+            obj["_url"] = table[i]._url;
+            obj["_note"] = table[i]._note;
+            data.push_back(obj);
+        }
+    }
+    return data;
+}
+
+bool UserHashTable::fromJson(const nlohmann::json& j) {
+    if (!j.is_array()) {
+        return false;
+    }
+    
+    for (const auto& item : j) {
+        string service = item["_service"];
+        string lastTime = item["_lastModifiedTime"];
+        string login = item["_login"];
+        string password = item["_password"];
+        string url = item["_url"];
+        string note = item["_note"];
+        if (!insert(service, lastTime, login, password, url, note)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Шифрование хранилища (потоковый формат, см. vaultStream.h).
+// Алгоритм выбирается по процессору: AES-256-GCM или XChaCha20-Poly1305
+std::vector<unsigned char> encrypt_aes_gcm(
+    const std::string& plaintext,
+    const VaultCipher& cipher) {
+
+    return encryptVaultBuffer(reinterpret_cast<const unsigned char*>(plaintext.data()),
+                              plaintext.size(), cipher);
+}
+
+std::vector<unsigned char> encrypt_aes_gcm(
+    const std::string& plaintext,
+    const std::vector<unsigned char>& key) {
+    
+    VaultCipher cipher(key);
+    return encrypt_aes_gcm(plaintext, cipher);
+}
+
+// Расшифровка хранилища (алгоритм берётся из заголовка)
+// Понимает и потоковый формат, и старый (nonce || ciphertext) для уже сохранённых хранилищ
+std::string decrypt_aes_gcm(
+    const std::vector<unsigned char>& blob,
+    const VaultCipher& cipher) {
+
+    if (isVaultStream(blob.data(), blob.size())) {
+        return decryptVaultBuffer(blob.data(), blob.size(), cipher);
+    }
+
+    if (blob.size() < crypto_aead_aes256gcm_NPUBBYTES + crypto_aead_aes256gcm_ABYTES) {
+        throw std::invalid_argument("Blob too small to contain nonce");
+    }
+
+    // nonce и ciphertext берутся прямо из blob, открытый текст пишется сразу в строку.
+    // Старый формат всегда AES-256-GCM; без AES-NI VaultCipher бросит исключение
+    const unsigned char* nonce = blob.data();
+    const unsigned char* ciphertext = blob.data() + crypto_aead_aes256gcm_NPUBBYTES;
+    const size_t ciphertextLen = blob.size() - crypto_aead_aes256gcm_NPUBBYTES;
+
+    std::string decrypted(ciphertextLen - crypto_aead_aes256gcm_ABYTES, '\0');
+    size_t decrypted_len = cipher.open(VaultAlgorithm::Aes256Gcm,
+                                       reinterpret_cast<unsigned char*>(&decrypted[0]),
+                                       ciphertext, ciphertextLen,
+                                       nullptr, 0,
+                                       nonce);
+
+    decrypted.resize(decrypted_len);
+
+    return decrypted;
+}
+
+std::string decrypt_aes_gcm(
+    const std::vector<unsigned char>& blob,
+    const std::vector<unsigned char>& key) {
+    
+    if (key.size() != crypto_aead_aes256gcm_KEYBYTES) {
+        throw std::invalid_argument("Invalid key size for AES-256-GCM");
+    }
+
+    VaultCipher cipher(key);
+    return decrypt_aes_gcm(blob, cipher);
+}
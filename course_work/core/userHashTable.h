@@ -0,0 +1,120 @@
+
+#ifndef COURSE_WORK_DIMAS_COPILOT_UPDATE_REGISTRATION_FLOW_USERHASHTABLE_H
+#define COURSE_WORK_DIMAS_COPILOT_UPDATE_REGISTRATION_FLOW_USERHASHTABLE_H
+
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "json.hpp"
+
+class VaultCipher;
+
+class UserHashTable {
+public:
+    // Запись хранилища. _id выдаётся при добавлении и не меняется ни при
+    // обновлении записи, ни при rehash, поэтому GUI может ссылаться на запись по нему
+    struct UserHashTableNode {
+        std::string _service;
+        std::string _lastModifiedTime;
+        std::string _login;
+        std::string _password;
+        std::string _url;
+        std::string _note;
+        size_t _id;
+
+        bool isDelete;
+        bool isNull;
+
+        UserHashTableNode() : _id(0), isDelete(false), isNull(true) {}
+    };
+    using Entry = UserHashTableNode;
+
+    // Получает изменения таблицы (например, поисковый индекс)
+    class Observer {
+    public:
+        virtual ~Observer() = default;
+        virtual void entriesReset() {}  // прежние записи больше не действительны, далее придут все текущие
+        virtual void entryStored(const Entry& entry) = 0;  // новая или обновлённая запись
+        virtual void entryRemoved(size_t id) = 0;
+    };
+
+private:
+    // Открытая адресация с линейным пробированием. Удалённая запись остаётся
+    // надгробием (isDelete), чтобы не рвать цепочки проб; надгробия считаются
+    // и убираются перестройкой таблицы, когда их становится много
+    UserHashTableNode* table;
+    size_t capacity;
+    size_t size;        // живые записи
+    size_t tombstones;  // ячейки с isDelete
+    size_t nextId;
+    std::unordered_map<size_t, size_t> idIndex;  // id записи -> ячейка таблицы
+    std::vector<Observer*> observers;
+    [[nodiscard]] int hashFunction(const std::pair<std::string, std::string>& loginAndService) const;
+    [[nodiscard]] size_t findIndex(const std::string& service, const std::string& login) const;
+    void rebuild(size_t newCapacity);
+    bool rehash();   // перед вставкой новой записи в заполненную таблицу
+    void compact();  // убрать надгробия, не меняя размер таблицы
+public:
+    explicit UserHashTable (int cap = 101);
+    ~UserHashTable() {delete[] table;}
+
+    bool insert(const std::string& service, const std::string& lastTime, const std::string& login,
+                const std::string& password, const std::string& url, const std::string& note);
+
+    // Только существующая запись; false, если её нет
+    bool update(const std::string& service, const std::string& lastTime, const std::string& login,
+                const std::string& password, const std::string& url, const std::string& note);
+
+    bool remove(const std::string& service, const std::string& login);
+
+    // Поиск без копирования; указатель действителен до следующего изменения таблицы
+    const Entry* find(const std::string& service, const std::string& login) const;
+    const Entry* findById(size_t id) const;
+
+    // Обход живых записей без сборки JSON
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (size_t i = 0; i < capacity; i++) {
+            if (!table[i].isNull && !table[i].isDelete) {
+                visit(table[i]);
+            }
+        }
+    }
+
+    size_t count() const { return size; }
+    size_t deletedCount() const { return tombstones; }
+    size_t bucketCount() const { return capacity; }
+
+    // [d] - число записей, лежащих в d ячейках от своей начальной (d = 0 - без коллизии)
+    std::vector<size_t> probeHistogram() const;
+
+    // Новый наблюдатель получает entriesReset и сразу все имеющиеся записи
+    void addObserver(Observer* observer);
+    void removeObserver(Observer* observer);
+
+    void loadFromFile(const std::string& filename);
+    void saveToFile(const std::string& filename) const;
+
+    nlohmann::json toJson() const;
+    bool fromJson(const nlohmann::json& j);
+};
+
+std::vector<unsigned char> encrypt_aes_gcm(
+    const std::string& plaintext,
+    const std::vector<unsigned char>& key);
+
+std::string decrypt_aes_gcm(
+    const std::vector<unsigned char>& blob,
+    const std::vector<unsigned char>& key);
+
+// То же с заранее подготовленным ключом сессии (без повторного beforenm)
+std::vector<unsigned char> encrypt_aes_gcm(
+    const std::string& plaintext,
+    const VaultCipher& cipher);
+
+std::string decrypt_aes_gcm(
+    const std::vector<unsigned char>& blob,
+    const VaultCipher& cipher);
+
+#endif //COURSE_WORK_DIMAS_COPILOT_UPDATE_REGISTRATION_FLOW_USERHASHTABLE_H
\ No newline at end of file
@@ -0,0 +1,597 @@
+#include "vaultStream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const unsigned char VAULT_MAGIC[4] = {'P', 'M', 'V', 'S'};
+// сигнатура (4) + версия (1) + алгоритм (1) + размер блока (4)
+constexpr size_t FIXED_HEADER_SIZE = 10;
+// Оба алгоритма используют 256-битный ключ и 16-байтовый тег
+constexpr size_t ABYTES = crypto_aead_aes256gcm_ABYTES;
+constexpr size_t MAX_NPUBBYTES = crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+static_assert(crypto_aead_xchacha20poly1305_ietf_ABYTES == ABYTES, "AEAD tag sizes must match");
+static_assert(crypto_aead_aes256gcm_KEYBYTES == VAULT_KEY_BYTES &&
+              crypto_aead_xchacha20poly1305_ietf_KEYBYTES == VAULT_KEY_BYTES, "AEAD key sizes must match");
+
+struct VaultHeader {
+    VaultAlgorithm alg;
+    size_t chunkSize;
+    size_t size;
+};
+
+size_t nonceSize(VaultAlgorithm alg) {
+    switch (alg) {
+        case VaultAlgorithm::Aes256Gcm:
+            return crypto_aead_aes256gcm_NPUBBYTES;
+        case VaultAlgorithm::XChaCha20Poly1305:
+            return crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+    }
+    throw invalid_argument("Unsupported vault algorithm");
+}
+
+// nonce = префикс + 4 байта счётчика + 1 байт флага:
+// 7 байт префикса для AES-256-GCM, 19 байт для XChaCha20-Poly1305
+size_t noncePrefixSize(VaultAlgorithm alg) {
+    return nonceSize(alg) - 5;
+}
+
+VaultAlgorithm checkedAlgorithm(unsigned char id) {
+    const auto alg = static_cast<VaultAlgorithm>(id);
+    if (alg != VaultAlgorithm::Aes256Gcm && alg != VaultAlgorithm::XChaCha20Poly1305) {
+        throw runtime_error("Unsupported vault algorithm");
+    }
+    if (!isVaultAlgorithmAvailable(alg)) {
+        throw runtime_error(string(vaultAlgorithmName(alg)) + " is not available on this CPU");
+    }
+    return alg;
+}
+
+vector<unsigned char> makeHeader(VaultAlgorithm alg, size_t chunkSize) {
+    vector<unsigned char> header(vaultStreamHeaderSize(alg));
+    memcpy(header.data(), VAULT_MAGIC, sizeof(VAULT_MAGIC));
+    header[4] = VAULT_STREAM_VERSION;
+    header[5] = static_cast<unsigned char>(alg);
+    header[6] = static_cast<unsigned char>(chunkSize >> 24);
+    header[7] = static_cast<unsigned char>(chunkSize >> 16);
+    header[8] = static_cast<unsigned char>(chunkSize >> 8);
+    header[9] = static_cast<unsigned char>(chunkSize);
+    randombytes_buf(header.data() + FIXED_HEADER_SIZE, header.size() - FIXED_HEADER_SIZE);
+    return header;
+}
+
+// Разбирает фиксированную часть заголовка; полный размер заголовка зависит от алгоритма
+VaultHeader parseFixedHeader(const unsigned char* data, size_t len) {
+    if (len < FIXED_HEADER_SIZE || !isVaultStream(data, len)) {
+        throw runtime_error("Invalid vault stream header");
+    }
+    VaultHeader header;
+    header.alg = checkedAlgorithm(data[5]);
+    header.chunkSize = (static_cast<size_t>(data[6]) << 24) | (static_cast<size_t>(data[7]) << 16) |
+                       (static_cast<size_t>(data[8]) << 8) | static_cast<size_t>(data[9]);
+    if (header.chunkSize == 0 || header.chunkSize > VAULT_STREAM_MAX_CHUNK_SIZE) {
+        throw runtime_error("Invalid vault chunk size");
+    }
+    header.size = vaultStreamHeaderSize(header.alg);
+    return header;
+}
+
+void chunkNonce(unsigned char* nonce, const unsigned char* header, size_t headerSize,
+                uint32_t counter, bool last) {
+    const size_t prefixSize = headerSize - FIXED_HEADER_SIZE;
+    memcpy(nonce, header + FIXED_HEADER_SIZE, prefixSize);
+    nonce[prefixSize] = static_cast<unsigned char>(counter >> 24);
+    nonce[prefixSize + 1] = static_cast<unsigned char>(counter >> 16);
+    nonce[prefixSize + 2] = static_cast<unsigned char>(counter >> 8);
+    nonce[prefixSize + 3] = static_cast<unsigned char>(counter);
+    nonce[prefixSize + 4] = last ? 1 : 0;
+}
+
+size_t sealChunkInto(const VaultCipher& cipher, VaultAlgorithm alg, unsigned char* out,
+                     const unsigned char* in, size_t len, const unsigned char* header, size_t headerSize,
+                     uint32_t counter, bool last) {
+    unsigned char nonce[MAX_NPUBBYTES];
+    chunkNonce(nonce, header, headerSize, counter, last);
+    return cipher.seal(alg, out, in, len, header, headerSize, nonce);
+}
+
+size_t openChunkInto(const VaultCipher& cipher, VaultAlgorithm alg, unsigned char* out,
+                     const unsigned char* in, size_t len, const unsigned char* header, size_t headerSize,
+                     uint32_t counter, bool last) {
+    if (len < ABYTES) {
+        throw runtime_error("Truncated vault chunk");
+    }
+
+    unsigned char nonce[MAX_NPUBBYTES];
+    chunkNonce(nonce, header, headerSize, counter, last);
+    return cipher.open(alg, out, in, len, header, headerSize, nonce);
+}
+
+} // namespace
+
+VaultAlgorithm defaultVaultAlgorithm() {
+    return isVaultAlgorithmAvailable(VaultAlgorithm::Aes256Gcm)
+               ? VaultAlgorithm::Aes256Gcm
+               : VaultAlgorithm::XChaCha20Poly1305;
+}
+
+bool isVaultAlgorithmAvailable(VaultAlgorithm alg) {
+    switch (alg) {
+        case VaultAlgorithm::Aes256Gcm:
+            return crypto_aead_aes256gcm_is_available() != 0;
+        case VaultAlgorithm::XChaCha20Poly1305:
+            return true;
+    }
+    return false;
+}
+
+const char* vaultAlgorithmName(VaultAlgorithm alg) {
+    switch (alg) {
+        case VaultAlgorithm::Aes256Gcm:
+            return "AES-256-GCM";
+        case VaultAlgorithm::XChaCha20Poly1305:
+            return "XChaCha20-Poly1305";
+    }
+    return "unknown";
+}
+
+// ---------------------------------------------------------------------------
+// VaultCipher
+// ---------------------------------------------------------------------------
+
+// Размер кратен 16, поэтому sodium_malloc вернёт выровненный адрес,
+// которого требует crypto_aead_aes256gcm_state
+struct alignas(16) VaultCipher::State {
+    crypto_aead_aes256gcm_state aes;
+    unsigned char key[VAULT_KEY_BYTES];
+};
+
+VaultCipher::VaultCipher(const vector<unsigned char>& key) : state(nullptr), aesReady(false) {
+    if (key.size() != VAULT_KEY_BYTES) {
+        throw invalid_argument("Invalid vault key size");
+    }
+
+    state = static_cast<State*>(sodium_malloc(sizeof(State)));
+    if (state == nullptr) {
+        throw bad_alloc();
+    }
+    memcpy(state->key, key.data(), VAULT_KEY_BYTES);
+
+    if (isVaultAlgorithmAvailable(VaultAlgorithm::Aes256Gcm)) {
+        crypto_aead_aes256gcm_beforenm(&state->aes, state->key);
+        aesReady = true;
+    }
+}
+
+VaultCipher::~VaultCipher() {
+    wipe();
+}
+
+void VaultCipher::wipe() {
+    if (state != nullptr) {
+        // sodium_free сам затирает память перед освобождением
+        sodium_free(state);
+        state = nullptr;
+    }
+    aesReady = false;
+}
+
+size_t VaultCipher::seal(VaultAlgorithm alg, unsigned char* out, const unsigned char* in, size_t len,
+                         const unsigned char* ad, size_t adLen, const unsigned char* nonce) const {
+    if (state == nullptr) {
+        throw logic_error("Vault key has been wiped");
+    }
+
+    unsigned long long outLen = 0;
+    int rc = -1;
+    switch (alg) {
+        case VaultAlgorithm::Aes256Gcm:
+            if (!aesReady) {
+                throw runtime_error("AES-256-GCM is not available on this CPU");
+            }
+            rc = crypto_aead_aes256gcm_encrypt_afternm(out, &outLen, in, len, ad, adLen,
+                                                       nullptr, nonce, &state->aes);
+            break;
+        case VaultAlgorithm::XChaCha20Poly1305:
+            rc = crypto_aead_xchacha20poly1305_ietf_encrypt(out, &outLen, in, len, ad, adLen,
+                                                            nullptr, nonce, state->key);
+            break;
+    }
+    if (rc != 0) {
+        throw runtime_error("Encryption failed");
+    }
+    return static_cast<size_t>(outLen);
+}
+
+size_t VaultCipher::open(VaultAlgorithm alg, unsigned char* out, const unsigned char* in, size_t len,
+                         const unsigned char* ad, size_t adLen, const unsigned char* nonce) const {
+    if (state == nullptr) {
+        throw logic_error("Vault key has been wiped");
+    }
+
+    unsigned long long outLen = 0;
+    int rc = -1;
+    switch (alg) {
+        case VaultAlgorithm::Aes256Gcm:
+            if (!aesReady) {
+                throw runtime_error("AES-256-GCM is not available on this CPU");
+            }
+            rc = crypto_aead_aes256gcm_decrypt_afternm(out, &outLen, nullptr, in, len, ad, adLen,
+                                                       nonce, &state->aes);
+            break;
+        case VaultAlgorithm::XChaCha20Poly1305:
+            rc = crypto_aead_xchacha20poly1305_ietf_decrypt(out, &outLen, nullptr, in, len,
+                                                            ad, adLen, nonce, state->key);
+            break;
+    }
+    if (rc != 0) {
+        throw runtime_error("Decryption failed");
+    }
+    return static_cast<size_t>(outLen);
+}
+
+size_t vaultStreamHeaderSize(VaultAlgorithm alg) {
+    return FIXED_HEADER_SIZE + noncePrefixSize(alg);
+}
+
+size_t vaultStreamEncryptedSize(size_t plainLen, size_t chunkSize, VaultAlgorithm alg) {
+    const size_t chunks = plainLen == 0 ? 1 : (plainLen + chunkSize - 1) / chunkSize;
+    return vaultStreamHeaderSize(alg) + plainLen + chunks * ABYTES;
+}
+
+bool isVaultStream(const unsigned char* data, size_t len) {
+    return len >= sizeof(VAULT_MAGIC) + 1 &&
+           memcmp(data, VAULT_MAGIC, sizeof(VAULT_MAGIC)) == 0 &&
+           data[4] == VAULT_STREAM_VERSION;
+}
+
+// ---------------------------------------------------------------------------
+// VaultStreamEncryptor
+// ---------------------------------------------------------------------------
+
+VaultStreamEncryptor::VaultStreamEncryptor(const VaultCipher& c, VaultSink s, size_t cs,
+                                           VaultAlgorithm a)
+    : cipher(c), alg(a), sink(std::move(s)), chunkSize(cs), plainLen(0), counter(0), headerSent(false), finished(false) {
+    if (chunkSize == 0 || chunkSize > VAULT_STREAM_MAX_CHUNK_SIZE) {
+        throw invalid_argument("Invalid vault chunk size");
+    }
+    checkedAlgorithm(static_cast<unsigned char>(alg));
+    header = makeHeader(alg, chunkSize);
+    plainBuf.resize(chunkSize);
+    cipherBuf.resize(chunkSize + ABYTES);
+}
+
+VaultStreamEncryptor::~VaultStreamEncryptor() {
+    sodium_memzero(plainBuf.data(), plainBuf.size());
+}
+
+void VaultStreamEncryptor::sealChunk(const unsigned char* data, size_t len, bool last) {
+    if (!headerSent) {
+        sink(header.data(), header.size());
+        headerSent = true;
+    }
+    if (!last && counter == UINT32_MAX) {
+        throw runtime_error("Vault stream is too long");
+    }
+
+    size_t outLen = sealChunkInto(cipher, alg, cipherBuf.data(), data, len, header.data(), header.size(),
+                                  counter, last);
+    counter++;
+    sink(cipherBuf.data(), outLen);
+}
+
+void VaultStreamEncryptor::update(const void* data, size_t len) {
+    if (finished) {
+        throw logic_error("Vault stream is already finished");
+    }
+
+    auto p = static_cast<const unsigned char*>(data);
+
+    // Блок запечатывается только когда за ним точно есть данные:
+    // флаг последнего блока ставится в finish()
+    while (plainLen + len > chunkSize) {
+        if (plainLen == 0) {
+            sealChunk(p, chunkSize, false);
+            p += chunkSize;
+            len -= chunkSize;
+        } else {
+            const size_t take = chunkSize - plainLen;
+            memcpy(plainBuf.data() + plainLen, p, take);
+            p += take;
+            len -= take;
+            sealChunk(plainBuf.data(), chunkSize, false);
+            plainLen = 0;
+        }
+    }
+
+    if (len > 0) {
+        memcpy(plainBuf.data() + plainLen, p, len);
+        plainLen += len;
+    }
+}
+
+void VaultStreamEncryptor::finish() {
+    if (finished) {
+        return;
+    }
+    sealChunk(plainBuf.data(), plainLen, true);
+    sodium_memzero(plainBuf.data(), plainBuf.size());
+    plainLen = 0;
+    finished = true;
+}
+
+// ---------------------------------------------------------------------------
+// VaultStreamDecryptor
+// ---------------------------------------------------------------------------
+
+VaultStreamDecryptor::VaultStreamDecryptor(const VaultCipher& c, VaultSink s)
+    : cipher(c), alg(VaultAlgorithm::Aes256Gcm), sink(std::move(s)), headerSize(FIXED_HEADER_SIZE),
+      chunkSize(0), cipherLen(0), counter(0), finished(false) {
+    header.reserve(FIXED_HEADER_SIZE);
+}
+
+VaultStreamDecryptor::~VaultStreamDecryptor() {
+    sodium_memzero(plainBuf.data(), plainBuf.size());
+}
+
+void VaultStreamDecryptor::parseHeader() {
+    VaultHeader parsed = parseFixedHeader(header.data(), header.size());
+    alg = parsed.alg;
+    headerSize = parsed.size;
+    chunkSize = parsed.chunkSize;
+}
+
+void VaultStreamDecryptor::openChunk(bool last) {
+    size_t outLen = openChunkInto(cipher, alg, plainBuf.data(), cipherBuf.data(), cipherLen,
+                                  header.data(), header.size(), counter, last);
+    counter++;
+    cipherLen = 0;
+    sink(plainBuf.data(), outLen);
+}
+
+void VaultStreamDecryptor::update(const void* data, size_t len) {
+    if (finished) {
+        throw runtime_error("Unexpected data after final vault chunk");
+    }
+
+    auto p = static_cast<const unsigned char*>(data);
+
+    // Сначала собираем заголовок: фиксированная часть, затем префикс nonce
+    while (len > 0 && (chunkSize == 0 || header.size() < headerSize)) {
+        const size_t take = min(len, headerSize - header.size());
+        header.insert(header.end(), p, p + take);
+        p += take;
+        len -= take;
+
+        if (chunkSize == 0 && header.size() == FIXED_HEADER_SIZE) {
+            parseHeader();
+        }
+        if (chunkSize != 0 && header.size() == headerSize && cipherBuf.empty()) {
+            cipherBuf.resize(chunkSize + ABYTES);
+            plainBuf.resize(chunkSize);
+        }
+    }
+
+    const size_t full = chunkSize + ABYTES;
+    while (len > 0) {
+        // Полный блок расшифровывается только когда за ним есть данные,
+        // иначе он может оказаться последним
+        if (cipherLen == full) {
+            openChunk(false);
+        }
+        const size_t take = min(len, full - cipherLen);
+        memcpy(cipherBuf.data() + cipherLen, p, take);
+        cipherLen += take;
+        p += take;
+        len -= take;
+    }
+}
+
+void VaultStreamDecryptor::finish() {
+    if (finished) {
+        return;
+    }
+    if (chunkSize == 0 || header.size() < headerSize) {
+        throw runtime_error("Truncated vault stream header");
+    }
+    openChunk(true);
+    finished = true;
+}
+
+// ---------------------------------------------------------------------------
+// Адаптеры std::streambuf
+// ---------------------------------------------------------------------------
+
+VaultEncryptBuf::VaultEncryptBuf(const VaultCipher& cipher, VaultSink sink)
+    : encryptor(cipher, std::move(sink)), buffer(4096) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+int VaultEncryptBuf::sync() {
+    const ptrdiff_t pending = pptr() - pbase();
+    if (pending > 0) {
+        encryptor.update(pbase(), static_cast<size_t>(pending));
+    }
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return 0;
+}
+
+VaultEncryptBuf::int_type VaultEncryptBuf::overflow(int_type ch) {
+    sync();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+streamsize VaultEncryptBuf::xsputn(const char* s, streamsize n) {
+    if (n > epptr() - pptr()) {
+        // Крупные записи уходят в шифратор напрямую, минуя промежуточный буфер
+        sync();
+        encryptor.update(s, static_cast<size_t>(n));
+        return n;
+    }
+    memcpy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+}
+
+void VaultEncryptBuf::finish() {
+    sync();
+    encryptor.finish();
+    sodium_memzero(buffer.data(), buffer.size());
+}
+
+VaultDecryptBuf::VaultDecryptBuf(const VaultCipher& cipher, Source src)
+    : source(std::move(src)), inBuf(16 * 1024),
+      decryptor(cipher, [this](const unsigned char* data, size_t len) {
+          pending.insert(pending.end(), data, data + len);
+      }),
+      sourceDone(false) {
+    setg(nullptr, nullptr, nullptr);
+}
+
+VaultDecryptBuf::~VaultDecryptBuf() {
+    sodium_memzero(pending.data(), pending.size());
+}
+
+VaultDecryptBuf::int_type VaultDecryptBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    sodium_memzero(pending.data(), pending.size());
+    pending.clear();
+    while (pending.empty()) {
+        if (sourceDone) {
+            return traits_type::eof();
+        }
+        const size_t n = source(inBuf.data(), inBuf.size());
+        if (n == 0) {
+            sourceDone = true;
+            decryptor.finish();
+        } else {
+            decryptor.update(inBuf.data(), n);
+        }
+    }
+
+    setg(pending.data(), pending.data(), pending.data() + pending.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+// ---------------------------------------------------------------------------
+// Потоки и буферы целиком
+// ---------------------------------------------------------------------------
+
+void encryptVaultStream(istream& in, ostream& out, const VaultCipher& cipher) {
+    VaultStreamEncryptor encryptor(cipher, [&out](const unsigned char* data, size_t len) {
+        out.write(reinterpret_cast<const char*>(data), static_cast<streamsize>(len));
+        if (!out) {
+            throw runtime_error("Failed to write encrypted vault");
+        }
+    });
+
+    vector<char> buffer(VAULT_STREAM_CHUNK_SIZE);
+    while (in) {
+        in.read(buffer.data(), static_cast<streamsize>(buffer.size()));
+        const streamsize n = in.gcount();
+        if (n > 0) {
+            encryptor.update(buffer.data(), static_cast<size_t>(n));
+        }
+    }
+    sodium_memzero(buffer.data(), buffer.size());
+
+    if (in.bad()) {
+        throw runtime_error("Failed to read vault plaintext");
+    }
+    encryptor.finish();
+    out.flush();
+}
+
+void decryptVaultStream(istream& in, ostream& out, const VaultCipher& cipher) {
+    VaultStreamDecryptor decryptor(cipher, [&out](const unsigned char* data, size_t len) {
+        out.write(reinterpret_cast<const char*>(data), static_cast<streamsize>(len));
+        if (!out) {
+            throw runtime_error("Failed to write decrypted vault");
+        }
+    });
+
+    vector<char> buffer(VAULT_STREAM_CHUNK_SIZE);
+    while (in) {
+        in.read(buffer.data(), static_cast<streamsize>(buffer.size()));
+        const streamsize n = in.gcount();
+        if (n > 0) {
+            decryptor.update(buffer.data(), static_cast<size_t>(n));
+        }
+    }
+
+    if (in.bad()) {
+        throw runtime_error("Failed to read encrypted vault");
+    }
+    decryptor.finish();
+    out.flush();
+}
+
+vector<unsigned char> encryptVaultBuffer(const unsigned char* data, size_t len,
+                                         const VaultCipher& cipher, VaultAlgorithm alg) {
+    checkedAlgorithm(static_cast<unsigned char>(alg));
+
+    const vector<unsigned char> header = makeHeader(alg, VAULT_STREAM_CHUNK_SIZE);
+    vector<unsigned char> out(vaultStreamEncryptedSize(len, VAULT_STREAM_CHUNK_SIZE, alg));
+    memcpy(out.data(), header.data(), header.size());
+
+    // Каждый блок шифруется сразу на своё место в выходном буфере
+    size_t inPos = 0;
+    size_t outPos = header.size();
+    uint32_t counter = 0;
+    do {
+        const size_t chunk = min(VAULT_STREAM_CHUNK_SIZE, len - inPos);
+        const bool last = inPos + chunk == len;
+        outPos += sealChunkInto(cipher, alg, out.data() + outPos, data + inPos, chunk,
+                                header.data(), header.size(), counter++, last);
+        inPos += chunk;
+    } while (inPos < len);
+
+    return out;
+}
+
+string decryptVaultBuffer(const unsigned char* blob, size_t len, const VaultCipher& cipher) {
+    const VaultHeader header = parseFixedHeader(blob, len);
+    if (len < header.size + ABYTES) {
+        throw runtime_error("Truncated vault stream");
+    }
+
+    const size_t payload = len - header.size;
+    const size_t fullChunk = header.chunkSize + ABYTES;
+    const size_t chunks = (payload + fullChunk - 1) / fullChunk;
+    if (payload % fullChunk != 0 && payload % fullChunk < ABYTES) {
+        throw runtime_error("Truncated vault chunk");
+    }
+
+    // Открытый текст расшифровывается сразу в результирующую строку
+    string result(payload - chunks * ABYTES, '\0');
+    auto out = reinterpret_cast<unsigned char*>(&result[0]);
+    size_t inPos = header.size;
+    size_t outPos = 0;
+    try {
+        for (size_t i = 0; i < chunks; i++) {
+            const size_t chunk = min(fullChunk, len - inPos);
+            const bool last = i + 1 == chunks;
+            outPos += openChunkInto(cipher, header.alg, out + outPos, blob + inPos, chunk, blob, header.size,
+                                    static_cast<uint32_t>(i), last);
+            inPos += chunk;
+        }
+    } catch (...) {
+        sodium_memzero(&result[0], result.size());
+        throw;
+    }
+
+    return result;
+}
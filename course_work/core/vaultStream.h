@@ -0,0 +1,185 @@
+#ifndef COURSEWORK_VAULT_STREAM_H
+#define COURSEWORK_VAULT_STREAM_H
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <sodium.h>
+
+// Потоковый формат зашифрованного хранилища.
+//
+//   заголовок: "PMVS" | версия (1) | алгоритм (1) | размер блока (4, BE) | префикс nonce
+//   блоки:     шифротекст блока + тег; последний блок может быть короче (или пустым)
+//
+// Nonce блока = префикс | номер блока (4, BE) | флаг последнего блока (1).
+// Заголовок передаётся как associated data каждого блока, поэтому перестановка,
+// обрезка хвоста или подмена параметров обнаруживаются при расшифровке.
+// Память при шифровании/расшифровке ограничена одним-двумя блоками
+// независимо от размера хранилища.
+
+constexpr size_t VAULT_STREAM_CHUNK_SIZE = 64 * 1024;
+constexpr size_t VAULT_STREAM_MAX_CHUNK_SIZE = 16 * 1024 * 1024;
+constexpr unsigned char VAULT_STREAM_VERSION = 1;
+
+// Идентификатор алгоритма хранится в заголовке, поэтому хранилище, зашифрованное
+// на машине с AES-NI, читается и там, где доступен только XChaCha20-Poly1305
+enum class VaultAlgorithm : uint8_t {
+    Aes256Gcm = 1,          // требует аппаратного AES (AES-NI + PCLMUL)
+    XChaCha20Poly1305 = 2   // программная реализация, доступна везде
+};
+
+constexpr size_t VAULT_KEY_BYTES = 32;
+
+// AES-256-GCM, если процессор его поддерживает, иначе XChaCha20-Poly1305
+VaultAlgorithm defaultVaultAlgorithm();
+bool isVaultAlgorithmAvailable(VaultAlgorithm alg);
+const char* vaultAlgorithmName(VaultAlgorithm alg);
+
+// Ключ хранилища вместе с заранее подготовленным состоянием AEAD.
+// Создаётся один раз на сессию: для AES-256-GCM расписание ключа раскладывается
+// один раз (crypto_aead_aes256gcm_beforenm) и переиспользуется всеми операциями.
+// Ключ и состояние лежат в защищённой памяти libsodium (sodium_malloc: mlock +
+// guard-страницы) и затираются в wipe()/деструкторе.
+class VaultCipher {
+private:
+    struct State;
+    State* state;
+    bool aesReady;
+
+public:
+    explicit VaultCipher(const std::vector<unsigned char>& key);
+    ~VaultCipher();
+
+    VaultCipher(const VaultCipher&) = delete;
+    VaultCipher& operator=(const VaultCipher&) = delete;
+
+    // Затирает ключ; после этого любые операции бросают исключение
+    void wipe();
+    bool isValid() const { return state != nullptr; }
+
+    size_t seal(VaultAlgorithm alg, unsigned char* out, const unsigned char* in, size_t len,
+                const unsigned char* ad, size_t adLen, const unsigned char* nonce) const;
+    size_t open(VaultAlgorithm alg, unsigned char* out, const unsigned char* in, size_t len,
+                const unsigned char* ad, size_t adLen, const unsigned char* nonce) const;
+};
+
+// Куда отдаются готовые байты (шифротекст при шифровании, открытый текст при расшифровке)
+using VaultSink = std::function<void(const unsigned char* data, size_t len)>;
+
+size_t vaultStreamHeaderSize(VaultAlgorithm alg);
+size_t vaultStreamEncryptedSize(size_t plainLen, size_t chunkSize = VAULT_STREAM_CHUNK_SIZE,
+                                VaultAlgorithm alg = defaultVaultAlgorithm());
+
+// Похож ли буфер на хранилище в потоковом формате (по сигнатуре и версии)
+bool isVaultStream(const unsigned char* data, size_t len);
+
+class VaultStreamEncryptor {
+private:
+    const VaultCipher& cipher;
+    VaultAlgorithm alg;
+    VaultSink sink;
+    size_t chunkSize;
+    std::vector<unsigned char> header;
+    std::vector<unsigned char> plainBuf;
+    size_t plainLen;
+    std::vector<unsigned char> cipherBuf;
+    uint32_t counter;
+    bool headerSent;
+    bool finished;
+
+    void sealChunk(const unsigned char* data, size_t len, bool last);
+
+public:
+    VaultStreamEncryptor(const VaultCipher& cipher, VaultSink sink,
+                         size_t chunkSize = VAULT_STREAM_CHUNK_SIZE,
+                         VaultAlgorithm alg = defaultVaultAlgorithm());
+    ~VaultStreamEncryptor();
+
+    VaultStreamEncryptor(const VaultStreamEncryptor&) = delete;
+    VaultStreamEncryptor& operator=(const VaultStreamEncryptor&) = delete;
+
+    void update(const void* data, size_t len);
+    void finish();
+};
+
+class VaultStreamDecryptor {
+private:
+    const VaultCipher& cipher;
+    VaultAlgorithm alg;
+    VaultSink sink;
+    std::vector<unsigned char> header;
+    size_t headerSize;
+    size_t chunkSize;
+    std::vector<unsigned char> cipherBuf;
+    size_t cipherLen;
+    std::vector<unsigned char> plainBuf;
+    uint32_t counter;
+    bool finished;
+
+    void parseHeader();
+    void openChunk(bool last);
+
+public:
+    VaultStreamDecryptor(const VaultCipher& cipher, VaultSink sink);
+    ~VaultStreamDecryptor();
+
+    VaultStreamDecryptor(const VaultStreamDecryptor&) = delete;
+    VaultStreamDecryptor& operator=(const VaultStreamDecryptor&) = delete;
+
+    void update(const void* data, size_t len);
+    // Бросает исключение, если поток обрезан (не получен последний блок)
+    void finish();
+};
+
+// std::ostream поверх шифратора: всё, что записано в поток, уходит блоками в sink.
+// После записи нужно вызвать finish(), иначе последний блок не будет сформирован.
+class VaultEncryptBuf : public std::streambuf {
+private:
+    VaultStreamEncryptor encryptor;
+    std::vector<char> buffer;
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+public:
+    VaultEncryptBuf(const VaultCipher& cipher, VaultSink sink);
+    void finish();
+};
+
+// std::istream поверх дешифратора: шифротекст подтягивается из source по мере чтения.
+// source заполняет буфер и возвращает число байт (0 — конец данных).
+class VaultDecryptBuf : public std::streambuf {
+public:
+    using Source = std::function<size_t(unsigned char* buf, size_t maxLen)>;
+
+private:
+    Source source;
+    std::vector<char> pending;
+    std::vector<unsigned char> inBuf;
+    VaultStreamDecryptor decryptor;
+    bool sourceDone;
+
+protected:
+    int_type underflow() override;
+
+public:
+    VaultDecryptBuf(const VaultCipher& cipher, Source source);
+    ~VaultDecryptBuf() override;
+};
+
+// Шифрование/расшифровка между потоками (файл, сокет) с постоянным расходом памяти
+void encryptVaultStream(std::istream& in, std::ostream& out, const VaultCipher& cipher);
+void decryptVaultStream(std::istream& in, std::ostream& out, const VaultCipher& cipher);
+
+// Шифрование/расшифровка целого буфера без промежуточных копий
+std::vector<unsigned char> encryptVaultBuffer(const unsigned char* data, size_t len,
+                                              const VaultCipher& cipher,
+                                              VaultAlgorithm alg = defaultVaultAlgorithm());
+std::string decryptVaultBuffer(const unsigned char* blob, size_t len, const VaultCipher& cipher);
+
+#endif // COURSEWORK_VAULT_STREAM_H
@@ -0,0 +1,841 @@
+#include "wireCodec.h"
+#include "common_utils.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace {
+
+constexpr uint64_t ONES = 0x0101010101010101ULL;
+constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+constexpr int MAX_DEPTH = 64;
+
+// Номера действий и полей бинарного протокола - часть формата, не менять.
+// Номер 0 - действие или поле передано по имени
+const char* const ACTION_NAMES[] = {
+    nullptr, "register", "login", "changePassword", "recoverPassword", "getVault",
+    "getVaultWithSeedPhrase", "updateVault", "checkUser", "stats"
+};
+
+struct BinaryField {
+    const char* name;
+    bool bytes;  // hex-строка в JSON, сырые байты на проводе
+};
+
+const BinaryField BINARY_FIELDS[] = {
+    {nullptr, false},
+    {"username", false}, {"password", false}, {"seedPhrase", false}, {"newPassword", false},
+    {"vaultData", true}, {"baseVersion", false}, {"histograms", false}, {"status", false},
+    {"message", false}, {"exists", false}, {"seedWords", false}, {"vaultSalt", true},
+    {"vaultVersion", false}, {"newSeedWords", false}, {"oldVaultSalt", true}, {"newVaultSalt", true},
+    {"stats", false}
+};
+
+constexpr size_t ACTION_COUNT = sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]);
+constexpr size_t BINARY_FIELD_COUNT = sizeof(BINARY_FIELDS) / sizeof(BINARY_FIELDS[0]);
+
+template <typename Table, size_t N, typename Name>
+unsigned char indexByName(const Table (&table)[N], string_view name, Name nameOf) {
+    for (size_t i = 1; i < N; i++) {
+        if (name == nameOf(table[i])) {
+            return static_cast<unsigned char>(i);
+        }
+    }
+    return 0;
+}
+
+void appendVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Ненулевой результат, если в слове есть байт, требующий внимания:
+// кавычка, обратная косая черта, управляющий символ или не-ASCII
+inline uint64_t specialBytes(uint64_t word, bool withNonAscii) {
+    const uint64_t quote = word ^ (ONES * '"');
+    const uint64_t backslash = word ^ (ONES * '\\');
+    uint64_t mask = ((quote - ONES) & ~quote) | ((backslash - ONES) & ~backslash) | (word - ONES * 0x20);
+    mask &= ~word;
+    if (withNonAscii) {
+        mask |= word;
+    }
+    return mask & HIGHS;
+}
+
+// Длина участка без спецсимволов
+inline size_t plainRun(const char* p, const char* end, bool withNonAscii) {
+    const char* start = p;
+    while (end - p >= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        if (specialBytes(word, withNonAscii)) {
+            break;
+        }
+        p += 8;
+    }
+    while (p < end) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\' || c < 0x20 || (withNonAscii && c >= 0x80)) {
+            break;
+        }
+        p++;
+    }
+    return static_cast<size_t>(p - start);
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+char* appendUtf8(char* out, uint32_t code) {
+    if (code < 0x80) {
+        *out++ = static_cast<char>(code);
+    } else if (code < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (code >> 6));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (code >> 12));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (code >> 18));
+        *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    }
+    return out;
+}
+
+// Длина корректной последовательности UTF-8, 0 - некорректная
+size_t utf8Length(const unsigned char* p, const unsigned char* end) {
+    const unsigned char c = p[0];
+    size_t length;
+    uint32_t min;
+    uint32_t code;
+    if (c >= 0xC2 && c <= 0xDF) {
+        length = 2; min = 0x80; code = c & 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        length = 3; min = 0x800; code = c & 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        length = 4; min = 0x10000; code = c & 0x07;
+    } else {
+        return 0;
+    }
+    if (static_cast<size_t>(end - p) < length) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        code = (code << 6) | (p[i] & 0x3F);
+    }
+    if (code < min || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+        return 0;
+    }
+    return length;
+}
+
+// Разбор одного документа. Ошибка - исключение с текстом без данных запроса
+class Parser {
+private:
+    char* p;
+    char* end;
+
+    [[noreturn]] void fail(const char* what) const {
+        throw runtime_error(what);
+    }
+
+    void skipWhitespace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+            p++;
+        }
+    }
+
+    void expect(char c, const char* what) {
+        if (p >= end || *p != c) {
+            fail(what);
+        }
+        p++;
+    }
+
+    uint32_t readHex4() {
+        if (end - p < 4) {
+            fail("Обрывается \\u-последовательность");
+        }
+        uint32_t code = 0;
+        for (int i = 0; i < 4; i++) {
+            const int digit = hexValue(p[i]);
+            if (digit < 0) {
+                fail("Некорректная \\u-последовательность");
+            }
+            code = (code << 4) | static_cast<uint32_t>(digit);
+        }
+        p += 4;
+        return code;
+    }
+
+public:
+    Parser(char* data, size_t length) : p(data), end(data + length) {}
+
+    // p - после открывающей кавычки. decode = false - только проверка, буфер не меняется
+    string_view parseString(bool decode) {
+        char* out = p;
+        char* const start = p;
+        while (true) {
+            const size_t run = plainRun(p, end, true);
+            if (decode && out != p) {
+                memmove(out, p, run);
+            }
+            out += run;
+            p += run;
+            if (p >= end) {
+                fail("Незакрытая строка");
+            }
+
+            const unsigned char c = static_cast<unsigned char>(*p);
+            if (c == '"') {
+                p++;
+                return decode ? string_view(start, static_cast<size_t>(out - start)) : string_view();
+            }
+            if (c < 0x20) {
+                fail("Управляющий символ в строке");
+            }
+            if (c >= 0x80) {
+                const size_t length = utf8Length(reinterpret_cast<unsigned char*>(p),
+                                                 reinterpret_cast<unsigned char*>(end));
+                if (length == 0) {
+                    fail("Некорректный UTF-8 в строке");
+                }
+                if (decode && out != p) {
+                    memmove(out, p, length);
+                }
+                out += length;
+                p += length;
+                continue;
+            }
+
+            // Экранирование: результат не длиннее исходной записи, пишем на место
+            p++;
+            if (p >= end) {
+                fail("Незакрытая строка");
+            }
+            const char escaped = *p++;
+            char scratch[4];
+            char* written = decode ? out : scratch;
+            switch (escaped) {
+                case '"':  *written++ = '"'; break;
+                case '\\': *written++ = '\\'; break;
+                case '/':  *written++ = '/'; break;
+                case 'b':  *written++ = '\b'; break;
+                case 'f':  *written++ = '\f'; break;
+                case 'n':  *written++ = '\n'; break;
+                case 'r':  *written++ = '\r'; break;
+                case 't':  *written++ = '\t'; break;
+                case 'u': {
+                    uint32_t code = readHex4();
+                    if (code >= 0xD800 && code <= 0xDBFF) {
+                        if (end - p < 2 || p[0] != '\\' || p[1] != 'u') {
+                            fail("Непарный суррогат в строке");
+                        }
+                        p += 2;
+                        const uint32_t low = readHex4();
+                        if (low < 0xDC00 || low > 0xDFFF) {
+                            fail("Непарный суррогат в строке");
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                        fail("Непарный суррогат в строке");
+                    }
+                    written = appendUtf8(written, code);
+                    break;
+                }
+                default:
+                    fail("Некорректное экранирование в строке");
+            }
+            if (decode) {
+                out = written;
+            }
+        }
+    }
+
+    void parseNumber() {
+        if (p < end && *p == '-') {
+            p++;
+        }
+        if (p >= end || *p < '0' || *p > '9') {
+            fail("Некорректное число");
+        }
+        if (*p == '0') {
+            p++;
+        } else {
+            while (p < end && *p >= '0' && *p <= '9') p++;
+        }
+        if (p < end && *p == '.') {
+            p++;
+            if (p >= end || *p < '0' || *p > '9') {
+                fail("Некорректное число");
+            }
+            while (p < end && *p >= '0' && *p <= '9') p++;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            p++;
+            if (p < end && (*p == '+' || *p == '-')) {
+                p++;
+            }
+            if (p >= end || *p < '0' || *p > '9') {
+                fail("Некорректное число");
+            }
+            while (p < end && *p >= '0' && *p <= '9') p++;
+        }
+    }
+
+    void parseLiteral(const char* literal) {
+        const size_t length = strlen(literal);
+        if (static_cast<size_t>(end - p) < length || memcmp(p, literal, length) != 0) {
+            fail("Некорректное значение");
+        }
+        p += length;
+    }
+
+    // Значение внутри вложенного объекта или массива: только проверка
+    void skipValue(int depth) {
+        if (depth > MAX_DEPTH) {
+            fail("Слишком глубокая вложенность");
+        }
+        skipWhitespace();
+        if (p >= end) {
+            fail("Неожиданный конец запроса");
+        }
+        switch (*p) {
+            case '"': p++; parseString(false); break;
+            case '{': {
+                p++;
+                skipWhitespace();
+                if (p < end && *p == '}') { p++; break; }
+                while (true) {
+                    skipWhitespace();
+                    expect('"', "Ожидался ключ");
+                    parseString(false);
+                    skipWhitespace();
+                    expect(':', "Ожидалось ':'");
+                    skipValue(depth + 1);
+                    skipWhitespace();
+                    if (p < end && *p == ',') { p++; continue; }
+                    expect('}', "Ожидалось ',' или '}'");
+                    break;
+                }
+                break;
+            }
+            case '[': {
+                p++;
+                skipWhitespace();
+                if (p < end && *p == ']') { p++; break; }
+                while (true) {
+                    skipValue(depth + 1);
+                    skipWhitespace();
+                    if (p < end && *p == ',') { p++; continue; }
+                    expect(']', "Ожидалось ',' или ']'");
+                    break;
+                }
+                break;
+            }
+            case 't': parseLiteral("true"); break;
+            case 'f': parseLiteral("false"); break;
+            case 'n': parseLiteral("null"); break;
+            default: parseNumber(); break;
+        }
+    }
+
+    void parseObject(vector<WireObject::Member>& fields) {
+        skipWhitespace();
+        expect('{', "Запрос должен быть JSON-объектом");
+        skipWhitespace();
+        if (p < end && *p == '}') {
+            p++;
+        } else {
+            while (true) {
+                skipWhitespace();
+                expect('"', "Ожидался ключ");
+                WireObject::Member member;
+                member.key = parseString(true);
+                skipWhitespace();
+                expect(':', "Ожидалось ':'");
+                skipWhitespace();
+                if (p >= end) {
+                    fail("Неожиданный конец запроса");
+                }
+
+                char* const valueStart = p;
+                switch (*p) {
+                    case '"':
+                        p++;
+                        member.kind = WireObject::Kind::String;
+                        member.value = parseString(true);
+                        break;
+                    case '{': member.kind = WireObject::Kind::Object; skipValue(1); break;
+                    case '[': member.kind = WireObject::Kind::Array; skipValue(1); break;
+                    case 't': member.kind = WireObject::Kind::True; parseLiteral("true"); break;
+                    case 'f': member.kind = WireObject::Kind::False; parseLiteral("false"); break;
+                    case 'n': member.kind = WireObject::Kind::Null; parseLiteral("null"); break;
+                    default: member.kind = WireObject::Kind::Number; parseNumber(); break;
+                }
+                if (member.kind != WireObject::Kind::String) {
+                    member.value = string_view(valueStart, static_cast<size_t>(p - valueStart));
+                }
+                fields.push_back(member);
+
+                skipWhitespace();
+                if (p < end && *p == ',') {
+                    p++;
+                    continue;
+                }
+                expect('}', "Ожидалось ',' или '}'");
+                break;
+            }
+        }
+        skipWhitespace();
+        if (p != end) {
+            fail("Лишние данные после объекта");
+        }
+    }
+};
+
+bool validUtf8(string_view text) {
+    const char* p = text.data();
+    const char* const end = p + text.size();
+    while (p < end) {
+        // Быстрый проход по ASCII, как в разборе строк JSON
+        while (end - p >= 8) {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            if (word & HIGHS) {
+                break;
+            }
+            p += 8;
+        }
+        if (p >= end) {
+            break;
+        }
+        if (static_cast<unsigned char>(*p) < 0x80) {
+            p++;
+            continue;
+        }
+        const size_t length = utf8Length(reinterpret_cast<const unsigned char*>(p),
+                                         reinterpret_cast<const unsigned char*>(end));
+        if (length == 0) {
+            return false;
+        }
+        p += length;
+    }
+    return true;
+}
+
+// Чтение тела кадра с проверкой границ
+class BinaryReader {
+private:
+    const char* p;
+    const char* end;
+
+public:
+    BinaryReader(const char* data, size_t length) : p(data), end(data + length) {}
+
+    bool atEnd() const { return p >= end; }
+
+    unsigned char byte() {
+        if (p >= end) {
+            throw runtime_error("Обрывается кадр");
+        }
+        return static_cast<unsigned char>(*p++);
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const unsigned char b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                if (shift == 63 && b > 1) {
+                    break;
+                }
+                return value;
+            }
+        }
+        throw runtime_error("Некорректный varint");
+    }
+
+    string_view bytes(uint64_t length) {
+        if (length > static_cast<uint64_t>(end - p)) {
+            throw runtime_error("Обрывается кадр");
+        }
+        string_view result(p, static_cast<size_t>(length));
+        p += length;
+        return result;
+    }
+};
+
+} // namespace
+
+// ---------- WireObject ----------
+
+string WireObject::parse(char* data, size_t length) {
+    fields.clear();
+    try {
+        Parser parser(data, length);
+        parser.parseObject(fields);
+    } catch (const runtime_error& e) {
+        fields.clear();
+        return e.what();
+    }
+    return "";
+}
+
+const WireObject::Member* WireObject::find(string_view key) const {
+    for (auto it = fields.rbegin(); it != fields.rend(); ++it) {
+        if (it->key == key) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+bool WireObject::toUInt(const Member& member, uint64_t& value) {
+    if (member.kind == Kind::UInt) {
+        value = member.number;
+        return true;
+    }
+    if (member.kind != Kind::Number || member.value.empty()) {
+        return false;
+    }
+    uint64_t result = 0;
+    for (char c : member.value) {
+        if (c < '0' || c > '9') {
+            return false;  // знак, дробная часть или экспонента
+        }
+        const uint64_t digit = static_cast<uint64_t>(c - '0');
+        if (result > (UINT64_MAX - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    value = result;
+    return true;
+}
+
+json WireObject::toJson(const Member& member) {
+    uint64_t number;
+    switch (member.kind) {
+        case Kind::String: return string(member.value);
+        case Kind::Bytes:  return toHex(reinterpret_cast<const unsigned char*>(member.value.data()), member.value.size());
+        case Kind::True:   return true;
+        case Kind::False:  return false;
+        case Kind::Null:   return nullptr;
+        case Kind::UInt:   return member.number;
+        case Kind::Number:
+            if (toUInt(member, number)) {
+                return number;
+            }
+            return json::parse(member.value.begin(), member.value.end());
+        default:
+            // Вложенные значения небольшие - их разбирает nlohmann
+            return json::parse(member.value.begin(), member.value.end());
+    }
+}
+
+// ---------- Бинарный протокол ----------
+
+bool BinaryWireCodec::frameLength(const char* data, size_t available, size_t& length, bool& valid) {
+    valid = true;
+    if (available >= 1 && static_cast<unsigned char>(data[0]) != MAGIC) {
+        valid = false;
+        return false;
+    }
+    if (available < HEADER_SIZE) {
+        return false;
+    }
+    if (static_cast<unsigned char>(data[1]) != VERSION) {
+        valid = false;
+        return false;
+    }
+    uint32_t body = 0;
+    for (int i = 0; i < 4; i++) {
+        body |= static_cast<uint32_t>(static_cast<unsigned char>(data[4 + i])) << (8 * i);
+    }
+    length = HEADER_SIZE + body;
+    return true;
+}
+
+bool BinaryWireCodec::isFrame(string_view data) {
+    return !data.empty() && static_cast<unsigned char>(data[0]) == MAGIC;
+}
+
+string WireObject::parseBinary(const char* data, size_t length) {
+    fields.clear();
+    size_t frame = 0;
+    bool valid = false;
+    if (!BinaryWireCodec::frameLength(data, length, frame, valid) || frame > length) {
+        return valid ? "Обрывается кадр" : "Некорректный заголовок кадра";
+    }
+
+    const unsigned char action = static_cast<unsigned char>(data[2]);
+    if (action != 0) {
+        if (action >= ACTION_COUNT) {
+            return "Неизвестный номер действия";
+        }
+        Member member;
+        member.key = "action";
+        member.kind = Kind::String;
+        member.value = ACTION_NAMES[action];
+        fields.push_back(member);
+    }
+
+    try {
+        BinaryReader reader(data + BinaryWireCodec::HEADER_SIZE, frame - BinaryWireCodec::HEADER_SIZE);
+        while (!reader.atEnd()) {
+            Member member;
+            const unsigned char tag = reader.byte();
+            if (tag == 0) {
+                member.key = reader.bytes(reader.varint());
+                if (!validUtf8(member.key)) {
+                    return "Некорректный UTF-8 в имени поля";
+                }
+            } else if (tag < BINARY_FIELD_COUNT) {
+                member.key = BINARY_FIELDS[tag].name;
+            } else {
+                return "Неизвестный номер поля";
+            }
+
+            switch (reader.byte()) {
+                case BinaryWireCodec::TYPE_STRING:
+                    member.kind = Kind::String;
+                    member.value = reader.bytes(reader.varint());
+                    if (!validUtf8(member.value)) {
+                        return "Некорректный UTF-8 в строке";
+                    }
+                    break;
+                case BinaryWireCodec::TYPE_BYTES:
+                    member.kind = Kind::Bytes;
+                    member.value = reader.bytes(reader.varint());
+                    break;
+                case BinaryWireCodec::TYPE_UINT:
+                    member.kind = Kind::UInt;
+                    member.number = reader.varint();
+                    break;
+                case BinaryWireCodec::TYPE_BOOL: {
+                    const unsigned char value = reader.byte();
+                    if (value > 1) {
+                        return "Некорректное логическое значение";
+                    }
+                    member.kind = value ? Kind::True : Kind::False;
+                    break;
+                }
+                case BinaryWireCodec::TYPE_JSON: {
+                    // Вложенные и прочие значения - текстом JSON, как в JSON-протоколе
+                    member.value = reader.bytes(reader.varint());
+                    if (!json::accept(member.value.begin(), member.value.end())) {
+                        return "Некорректное JSON-значение поля";
+                    }
+                    const size_t first = member.value.find_first_not_of(" \t\r\n");
+                    switch (member.value[first]) {
+                        case '{': member.kind = Kind::Object; break;
+                        case '[': member.kind = Kind::Array; break;
+                        case 't': member.kind = Kind::True; break;
+                        case 'f': member.kind = Kind::False; break;
+                        case 'n': member.kind = Kind::Null; break;
+                        case '"': return "Строка должна передаваться типом string";
+                        default: member.kind = Kind::Number; break;
+                    }
+                    break;
+                }
+                default:
+                    return "Неизвестный тип поля";
+            }
+            fields.push_back(member);
+        }
+    } catch (const runtime_error& e) {
+        fields.clear();
+        return e.what();
+    }
+    return "";
+}
+
+string BinaryWireCodec::encode(const json& message) const {
+    if (!message.is_object()) {
+        throw runtime_error("Бинарный протокол передаёт только объекты");
+    }
+
+    string out(HEADER_SIZE, '\0');
+    unsigned char action = 0;
+    for (auto it = message.begin(); it != message.end(); ++it) {
+        const string& key = it.key();
+        const json& value = *it;
+        if (key == "action" && value.is_string()) {
+            action = indexByName(ACTION_NAMES, value.get_ref<const string&>(), [](const char* name) { return name; });
+            if (action != 0) {
+                continue;
+            }
+        }
+
+        const unsigned char tag = indexByName(BINARY_FIELDS, key, [](const BinaryField& field) { return field.name; });
+        out += static_cast<char>(tag);
+        if (tag == 0) {
+            appendVarint(out, key.size());
+            out += key;
+        }
+
+        if (value.is_string()) {
+            const string& text = value.get_ref<const string&>();
+            if (BINARY_FIELDS[tag].bytes && text.size() % 2 == 0) {
+                try {
+                    const auto raw = hexToBytes(text);
+                    out += static_cast<char>(TYPE_BYTES);
+                    appendVarint(out, raw.size());
+                    out.append(reinterpret_cast<const char*>(raw.data()), raw.size());
+                    continue;
+                } catch (const invalid_argument&) {
+                    // не hex - передаём строкой
+                }
+            }
+            out += static_cast<char>(TYPE_STRING);
+            appendVarint(out, text.size());
+            out += text;
+        } else if (value.is_boolean()) {
+            out += static_cast<char>(TYPE_BOOL);
+            out += static_cast<char>(value.get<bool>() ? 1 : 0);
+        } else if (value.is_number_unsigned() || (value.is_number_integer() && value.get<int64_t>() >= 0)) {
+            out += static_cast<char>(TYPE_UINT);
+            appendVarint(out, value.get<uint64_t>());
+        } else {
+            const string text = value.dump();
+            out += static_cast<char>(TYPE_JSON);
+            appendVarint(out, text.size());
+            out += text;
+        }
+    }
+
+    const size_t body = out.size() - HEADER_SIZE;
+    if (body > UINT32_MAX) {
+        throw runtime_error("Сообщение слишком большое для бинарного протокола");
+    }
+    out[0] = static_cast<char>(MAGIC);
+    out[1] = static_cast<char>(VERSION);
+    out[2] = static_cast<char>(action);
+    out[3] = 0;
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = static_cast<char>((body >> (8 * i)) & 0xFF);
+    }
+    return out;
+}
+
+json BinaryWireCodec::decode(string& buffer) const {
+    WireObject object;
+    const string error = object.parseBinary(buffer.data(), buffer.size());
+    if (!error.empty()) {
+        throw runtime_error("Некорректный ответ сервера: " + error);
+    }
+    json result = json::object();
+    for (const auto& member : object.members()) {
+        result[string(member.key)] = WireObject::toJson(member);
+    }
+    return result;
+}
+
+// ---------- Запись строк ----------
+
+void appendJsonString(string& out, string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    out.reserve(out.size() + text.size() + 2);
+    out += '"';
+    const char* p = text.data();
+    const char* const end = p + text.size();
+    while (p < end) {
+        const size_t run = plainRun(p, end, false);
+        out.append(p, run);
+        p += run;
+        if (p >= end) {
+            break;
+        }
+        const unsigned char c = static_cast<unsigned char>(*p++);
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                const char escaped[] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0x0F]};
+                out.append(escaped, sizeof(escaped));
+            }
+        }
+    }
+    out += '"';
+}
+
+// ---------- Кодеки ----------
+
+string DomJsonCodec::encode(const json& message) const {
+    return message.dump();
+}
+
+json DomJsonCodec::decode(string& buffer) const {
+    return json::parse(buffer);
+}
+
+string InSituJsonCodec::encode(const json& message) const {
+    if (!message.is_object()) {
+        return message.dump();
+    }
+    string out;
+    out += '{';
+    bool first = true;
+    for (auto it = message.begin(); it != message.end(); ++it) {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        appendJsonString(out, it.key());
+        out += ':';
+        if (it->is_string()) {
+            appendJsonString(out, it->get_ref<const string&>());
+        } else {
+            out += it->dump();
+        }
+    }
+    out += '}';
+    return out;
+}
+
+json InSituJsonCodec::decode(string& buffer) const {
+    WireObject object;
+    const string error = object.parse(buffer.data(), buffer.size());
+    if (!error.empty()) {
+        throw runtime_error("Некорректный ответ сервера: " + error);
+    }
+
+    json result = json::object();
+    for (const auto& member : object.members()) {
+        result[string(member.key)] = WireObject::toJson(member);
+    }
+    return result;
+}
+
+const WireCodec& defaultWireCodec() {
+    static const InSituJsonCodec codec;
+    return codec;
+}
+
+const WireCodec& binaryWireCodec() {
+    static const BinaryWireCodec codec;
+    return codec;
+}
@@ -0,0 +1,108 @@
+#ifndef COURSEWORK_WIRE_CODEC_H
+#define COURSEWORK_WIRE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json.hpp"
+
+// Разбор JSON-объекта верхнего уровня на месте (in-situ). Строки раскодируются
+// прямо в буфере, ключи и значения - string_view в него; DOM не строится и
+// строки в куче не создаются. Запросы протокола - плоские объекты, поэтому
+// вложенные объекты и массивы только проверяются и отдаются исходным текстом.
+// Многомегабайтный hex хранилища проходится по 8 байт за шаг.
+// Тот же объект заполняется из кадра бинарного протокола (parseBinary).
+class WireObject {
+public:
+    // Bytes и UInt бывают только в бинарном протоколе
+    enum class Kind { String, Number, True, False, Null, Object, Array, Bytes, UInt };
+
+    struct Member {
+        std::string_view key;
+        Kind kind;
+        std::string_view value;  // String - раскодированное содержимое, Bytes - сырые байты, иначе текст значения
+        uint64_t number = 0;     // UInt
+    };
+
+    // Буфер изменяется и должен жить дольше объекта. Пустая строка - успех,
+    // иначе описание ошибки (без содержимого запроса: там могут быть пароли)
+    std::string parse(char* data, size_t length);
+    // Кадр бинарного протокола целиком (заголовок и поля); действие из
+    // заголовка становится полем "action"
+    std::string parseBinary(const char* data, size_t length);
+
+    // При повторе ключа действует последнее значение, как в nlohmann::json
+    const Member* find(std::string_view key) const;
+    const std::vector<Member>& members() const { return fields; }
+
+    // Неотрицательное целое без дробной части и экспоненты
+    static bool toUInt(const Member& member, uint64_t& value);
+    // Значение как в nlohmann::json; Bytes - hex-строкой
+    static nlohmann::json toJson(const Member& member);
+
+private:
+    std::vector<Member> fields;
+};
+
+// Кодек сообщений протокола. Клиент выбирает кодек, сервер разбирает
+// запросы через WireObject и отвечает в протоколе запроса
+class WireCodec {
+public:
+    virtual ~WireCodec() = default;
+
+    virtual const char* name() const = 0;
+    virtual std::string encode(const nlohmann::json& message) const = 0;
+    // buffer может быть изменён при разборе
+    virtual nlohmann::json decode(std::string& buffer) const = 0;
+};
+
+// Полный DOM nlohmann::json - для отладки и сравнения
+class DomJsonCodec : public WireCodec {
+public:
+    const char* name() const override { return "dom"; }
+    std::string encode(const nlohmann::json& message) const override;
+    nlohmann::json decode(std::string& buffer) const override;
+};
+
+// Тот же JSON на проводе, но строки верхнего уровня пишутся и читаются
+// блоками; nlohmann разбирает только вложенные значения (seedWords, stats)
+class InSituJsonCodec : public WireCodec {
+public:
+    const char* name() const override { return "insitu"; }
+    std::string encode(const nlohmann::json& message) const override;
+    nlohmann::json decode(std::string& buffer) const override;
+};
+
+// Бинарный протокол. Кадр - заголовок из 8 байт:
+//   магический байт 0xB5, версия, номер действия, флаги (пока 0), длина тела (uint32 LE)
+// и поля TLV в теле: номер поля, [имя - если номер 0], тип, значение.
+// Длины и целые - varint (LEB128). Поля-хеши и хранилище идут сырыми байтами
+// вместо hex, так что хранилище на проводе вдвое меньше, а текст не разбирается вовсе.
+// Сервер узнаёт протокол по первому байту соединения и отвечает тем же;
+// клиент, получивший JSON в ответ на кадр (старый сервер), переходит на JSON.
+class BinaryWireCodec : public WireCodec {
+public:
+    static constexpr unsigned char MAGIC = 0xB5;
+    static constexpr unsigned char VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 8;
+
+    enum FieldType : unsigned char { TYPE_STRING = 1, TYPE_BYTES = 2, TYPE_UINT = 3, TYPE_BOOL = 4, TYPE_JSON = 5 };
+
+    // Длина всего кадра по заголовку; false - заголовка ещё нет или он некорректен (valid = false)
+    static bool frameLength(const char* data, size_t available, size_t& length, bool& valid);
+    static bool isFrame(std::string_view data);
+
+    const char* name() const override { return "binary"; }
+    std::string encode(const nlohmann::json& message) const override;
+    nlohmann::json decode(std::string& buffer) const override;
+};
+
+const WireCodec& defaultWireCodec();
+const WireCodec& binaryWireCodec();
+
+// Строка JSON в кавычках с экранированием; длинные участки без спецсимволов копируются целиком
+void appendJsonString(std::string& out, std::string_view text);
+
+#endif // COURSEWORK_WIRE_CODEC_H
@@ -0,0 +1,110 @@
+#ifndef COURSEWORK_LATENCY_HISTOGRAM_H
+#define COURSEWORK_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "json.hpp"
+
+// Гистограмма задержек в микросекундах: каждый интервал [2^k, 2^(k+1)) делится
+// на 32 ячейки, погрешность процентилей не больше ~3%.
+// Общая для сервера (ServerStats) и генератора нагрузки (pm_loadgen).
+// Не потокобезопасна: каждый поток пишет в свою или под внешним мьютексом
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr size_t MAGNITUDES = 40;
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t maxValue;
+    double sum;
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+        const int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return SUB_BUCKETS * (shift + 1) + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Наибольшее значение, попадающее в ячейку
+    static uint64_t bucketUpper(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        const int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+        const uint64_t lower = (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+        return lower + (uint64_t(1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() : counts(SUB_BUCKETS * MAGNITUDES, 0), total(0), maxValue(0), sum(0) {}
+
+    void record(uint64_t micros) {
+        const size_t bucket = std::min(bucketOf(micros), counts.size() - 1);
+        counts[bucket]++;
+        total++;
+        maxValue = std::max(maxValue, micros);
+        sum += static_cast<double>(micros);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts.size(); i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        maxValue = std::max(maxValue, other.maxValue);
+        sum += other.sum;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t maximum() const { return maxValue; }
+    double mean() const { return total ? sum / total : 0; }
+
+    uint64_t percentile(double p) const {
+        if (total == 0) {
+            return 0;
+        }
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100.0 * total + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(bucketUpper(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    // Непустые ячейки: [верхняя граница в мкс, количество]
+    nlohmann::json buckets() const {
+        nlohmann::json result = nlohmann::json::array();
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (counts[i] != 0) {
+                result.push_back({bucketUpper(i), counts[i]});
+            }
+        }
+        return result;
+    }
+
+    // count, mean, p50/p90/p99/p999, max; с withBuckets - ещё и сами ячейки
+    nlohmann::json summary(bool withBuckets = false) const {
+        nlohmann::json result = {
+            {"count", total},
+            {"mean", mean()},
+            {"p50", percentile(50)},
+            {"p90", percentile(90)},
+            {"p99", percentile(99)},
+            {"p999", percentile(99.9)},
+            {"max", maxValue},
+        };
+        if (withBuckets) {
+            result["histogram"] = buckets();
+        }
+        return result;
+    }
+};
+
+#endif // COURSEWORK_LATENCY_HISTOGRAM_H
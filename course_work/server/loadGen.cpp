@@ -0,0 +1,607 @@
+// Генератор нагрузки для сервера паролей (pm_loadgen).
+//
+// Говорит тем же протоколом, что и клиент (открытое соединение - на запрос,
+// с --tls каждый поток держит своё соединение TLS):
+// регистрирует N синтетических пользователей, затем потоки гоняют смесь
+// login/getVault/updateVault/changePassword и считают задержки.
+//
+//   Замкнутый цикл: каждый поток шлёт следующий запрос сразу после ответа
+//     pm_loadgen --concurrency 8 --duration 30
+//   Заданная интенсивность: запросы назначаются по расписанию rate в секунду,
+//   задержка считается от назначенного момента, поэтому очередь на стороне
+//   генератора тоже попадает в результат
+//     pm_loadgen --rate 2 --concurrency 16 --mix login=50,updateVault=50
+//
+// Итог: пропускная способность и p50/p90/p99/p999 по каждой операции; с --json
+// печатается JSON вместе с гистограммами для сравнения прогонов.
+#include "common_utils.h"
+#include "json.hpp"
+#include "latencyHistogram.h"
+#include "messageChannel.h"
+#include "tlsChannel.h"
+#include "wireCodec.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+enum Operation { OP_LOGIN, OP_GET_VAULT, OP_UPDATE_VAULT, OP_CHANGE_PASSWORD, OP_COUNT };
+
+const char* const OPERATION_NAMES[OP_COUNT] = {"login", "getVault", "updateVault", "changePassword"};
+
+struct Options {
+    string host = "127.0.0.1";
+    int port = 8080;
+    int users = 16;
+    int concurrency = 4;
+    double rate = 0;          // запросов в секунду; 0 - замкнутый цикл
+    double duration = 30;     // секунд
+    uint64_t requests = 0;    // 0 - ограничение только по времени
+    size_t vaultBytes = 1024; // сервер читает запрос одним recv до 4 КиБ, hex вдвое длиннее
+    int timeoutSeconds = 120;
+    int mix[OP_COUNT] = {40, 40, 15, 5};
+    const WireCodec* codec = &binaryWireCodec();
+    TlsContext* tls = nullptr;  // --tls: доверенный сертификат сервера
+    bool jsonOutput = false;
+};
+
+struct OperationStats {
+    LatencyHistogram latency;
+    uint64_t ok = 0;
+    uint64_t conflict = 0;  // updateVault поверх устаревшей версии - штатный ответ
+    uint64_t error = 0;     // status "error" от сервера
+    uint64_t failed = 0;    // нет соединения, таймаут, неразборчивый ответ
+
+    void merge(const OperationStats& other) {
+        latency.merge(other.latency);
+        ok += other.ok;
+        conflict += other.conflict;
+        error += other.error;
+        failed += other.failed;
+    }
+};
+
+struct SyntheticUser {
+    string username;
+    string password;
+    string seedPhrase;
+    uint64_t vaultVersion = 0;
+    bool busy = false;
+};
+
+// Пользователь за раз занят одним потоком: changePassword меняет и пароль,
+// и фразу, параллельный запрос с прежними данными получил бы отказ
+class UserPool {
+private:
+    vector<SyntheticUser> users;
+    mutex poolMutex;
+    condition_variable released;
+
+public:
+    explicit UserPool(vector<SyntheticUser> registered) : users(move(registered)) {}
+
+    SyntheticUser* acquire(mt19937& rng) {
+        unique_lock<mutex> lock(poolMutex);
+        while (true) {
+            const size_t start = uniform_int_distribution<size_t>(0, users.size() - 1)(rng);
+            for (size_t i = 0; i < users.size(); i++) {
+                SyntheticUser& user = users[(start + i) % users.size()];
+                if (!user.busy) {
+                    user.busy = true;
+                    return &user;
+                }
+            }
+            released.wait(lock);
+        }
+    }
+
+    void release(SyntheticUser* user) {
+        {
+            lock_guard<mutex> lock(poolMutex);
+            user->busy = false;
+        }
+        released.notify_one();
+    }
+};
+
+// Рукопожатия TLS за прогон: полные и с возобновлением сессии
+atomic<uint64_t> fullHandshakes{0};
+atomic<uint64_t> resumedHandshakes{0};
+
+// Соединение TLS потока между запросами
+thread_local unique_ptr<Channel> keptChannel;
+
+int connectSocket(const Options& options) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        throw runtime_error("Ошибка создания сокета");
+    }
+
+    timeval timeout{};
+    timeout.tv_sec = options.timeoutSeconds;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in serverAddr{};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.host.c_str(), &serverAddr.sin_addr) <= 0) {
+        close(sock);
+        throw runtime_error("Неверный адрес сервера");
+    }
+
+    if (connect(sock, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        close(sock);
+        throw runtime_error("Не удалось подключиться к серверу");
+    }
+    return sock;
+}
+
+unique_ptr<Channel> openChannel(const Options& options) {
+    const int sock = connectSocket(options);
+    if (!options.tls) {
+        return unique_ptr<Channel>(new Channel(sock));
+    }
+    unique_ptr<TlsChannel> channel(new TlsChannel(*options.tls, sock));
+    if (!channel->connect(options.host)) {
+        throw runtime_error(channel->error());
+    }
+    (channel->resumed() ? resumedHandshakes : fullHandshakes)++;
+    return unique_ptr<Channel>(channel.release());
+}
+
+// Ответ читается как в клиенте: кадр по длине, JSON - до конца объекта
+string roundTrip(const Options& options, const string& request) {
+    for (int attempt = 0; ; attempt++) {
+        const bool reused = keptChannel != nullptr;
+        unique_ptr<Channel> channel = reused ? move(keptChannel) : openChannel(options);
+
+        string response;
+        bool binary = false;
+        ReadStatus status = ReadStatus::Closed;
+        if (channel->sendAll(request.data(), request.size())) {
+            status = readMessage(*channel, response, binary, 4 * MAX_MESSAGE_BYTES);
+        }
+        if (status == ReadStatus::Ok) {
+            if (options.tls) {
+                keptChannel = move(channel);
+            }
+            return response;
+        }
+        // Простаивающее соединение сервер закрывает, не читая запрос
+        if (reused && status == ReadStatus::Closed && attempt == 0) {
+            continue;
+        }
+        throw runtime_error(status == ReadStatus::Timeout ? "Нет ответа от сервера" : "Не получен ответ от сервера");
+    }
+}
+
+// Запрос и ответ кодируются так же, как в клиенте
+json call(const Options& options, const json& request) {
+    string response = roundTrip(options, options.codec->encode(request));
+    return options.codec->decode(response);
+}
+
+string joinWords(const json& words) {
+    string phrase;
+    for (const auto& word : words) {
+        if (!phrase.empty()) {
+            phrase += " ";
+        }
+        phrase += word.get<string>();
+    }
+    return phrase;
+}
+
+// generate_password может обойтись без какого-то класса символов, а сервер требует все
+string syntheticPassword() {
+    return generate_password(16) + "Aa1!";
+}
+
+vector<SyntheticUser> registerUsers(const Options& options) {
+    // Префикс прогона, чтобы повторные запуски против того же сервера не сталкивались
+    const string prefix = "lg" + toHex(generateSaltRaw(4)) + "_";
+
+    vector<SyntheticUser> users(options.users);
+    atomic<int> next(0);
+    atomic<int> done(0);
+    atomic<bool> failed(false);
+    string firstError;
+    mutex errorMutex;
+
+    auto worker = [&]() {
+        for (int i = next++; i < options.users && !failed; i = next++) {
+            SyntheticUser& user = users[i];
+            user.username = prefix + to_string(i);
+            user.password = syntheticPassword();
+
+            json request;
+            request["action"] = "register";
+            request["username"] = user.username;
+            request["password"] = user.password;
+            try {
+                json response = call(options, request);
+                if (response.value("status", "") != "success") {
+                    throw runtime_error(response.value("message", "отказ сервера"));
+                }
+                user.seedPhrase = joinWords(response["seedWords"]);
+            } catch (const exception& e) {
+                lock_guard<mutex> lock(errorMutex);
+                if (!failed.exchange(true)) {
+                    firstError = user.username + ": " + e.what();
+                }
+                return;
+            }
+            cerr << "\rРегистрация: " << ++done << "/" << options.users << flush;
+        }
+    };
+
+    vector<thread> threads;
+    for (int t = 0; t < min(options.concurrency, options.users); t++) {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    cerr << endl;
+
+    if (failed) {
+        throw runtime_error("Регистрация не удалась: " + firstError);
+    }
+    return users;
+}
+
+class LoadRunner {
+private:
+    const Options& options;
+    UserPool& pool;
+    vector<int> mixTable;  // операция на каждый процент смеси
+    Clock::time_point start;
+    Clock::time_point deadline;
+    atomic<uint64_t> tickets;
+    mutex statsMutex;
+    OperationStats totals[OP_COUNT];
+
+    // Возвращает false, если прогон закончен; иначе момент, с которого считать задержку
+    bool nextSlot(Clock::time_point& scheduled) {
+        const uint64_t ticket = tickets++;
+        if (options.requests != 0 && ticket >= options.requests) {
+            return false;
+        }
+        if (options.rate > 0) {
+            scheduled = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(ticket / options.rate));
+            if (scheduled >= deadline) {
+                return false;
+            }
+            this_thread::sleep_until(scheduled);
+            return true;
+        }
+        scheduled = Clock::now();
+        return scheduled < deadline;
+    }
+
+    void execute(Operation op, SyntheticUser& user, const string& vaultHex, OperationStats& stats) {
+        json request;
+        request["action"] = OPERATION_NAMES[op];
+        request["username"] = user.username;
+
+        string newPassword;
+        switch (op) {
+            case OP_LOGIN:
+            case OP_GET_VAULT:
+                request["password"] = user.password;
+                break;
+            case OP_UPDATE_VAULT:
+                request["password"] = user.password;
+                request["vaultData"] = vaultHex;
+                request["baseVersion"] = user.vaultVersion;
+                break;
+            case OP_CHANGE_PASSWORD:
+                newPassword = syntheticPassword();
+                request["seedPhrase"] = user.seedPhrase;
+                request["newPassword"] = newPassword;
+                break;
+            default:
+                break;
+        }
+
+        json response;
+        try {
+            response = call(options, request);
+        } catch (const exception& e) {
+            stats.failed++;
+            return;
+        }
+
+        const string status = response.value("status", "");
+        if (status == "conflict") {
+            user.vaultVersion = response.value("vaultVersion", user.vaultVersion);
+            stats.conflict++;
+            return;
+        }
+        if (status != "success") {
+            stats.error++;
+            return;
+        }
+
+        stats.ok++;
+        if (op == OP_UPDATE_VAULT || op == OP_LOGIN || op == OP_GET_VAULT) {
+            user.vaultVersion = response.value("vaultVersion", user.vaultVersion);
+        } else if (op == OP_CHANGE_PASSWORD) {
+            user.password = newPassword;
+            user.seedPhrase = joinWords(response["newSeedWords"]);
+        }
+    }
+
+    void worker(unsigned seed) {
+        mt19937 rng(seed);
+        OperationStats local[OP_COUNT];
+        const string vaultHex = toHex(generateSaltRaw(options.vaultBytes));
+
+        Clock::time_point scheduled;
+        while (nextSlot(scheduled)) {
+            const auto op = static_cast<Operation>(mixTable[uniform_int_distribution<size_t>(0, mixTable.size() - 1)(rng)]);
+            SyntheticUser* user = pool.acquire(rng);
+            execute(op, *user, vaultHex, local[op]);
+            pool.release(user);
+
+            const auto micros = chrono::duration_cast<chrono::microseconds>(Clock::now() - scheduled).count();
+            local[op].latency.record(static_cast<uint64_t>(max<int64_t>(micros, 0)));
+        }
+
+        lock_guard<mutex> lock(statsMutex);
+        for (int op = 0; op < OP_COUNT; op++) {
+            totals[op].merge(local[op]);
+        }
+    }
+
+public:
+    LoadRunner(const Options& options, UserPool& pool) : options(options), pool(pool), tickets(0) {
+        for (int op = 0; op < OP_COUNT; op++) {
+            mixTable.insert(mixTable.end(), options.mix[op], op);
+        }
+    }
+
+    // Возвращает фактическую длительность прогона в секундах
+    double run() {
+        start = Clock::now();
+        deadline = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(options.duration));
+
+        random_device rd;
+        vector<thread> threads;
+        for (int t = 0; t < options.concurrency; t++) {
+            threads.emplace_back(&LoadRunner::worker, this, rd());
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        return chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const OperationStats& stats(int op) const { return totals[op]; }
+};
+
+json statsToJson(const OperationStats& stats, double seconds) {
+    json result;
+    result["count"] = stats.latency.count();
+    result["ok"] = stats.ok;
+    result["conflict"] = stats.conflict;
+    result["error"] = stats.error;
+    result["failed"] = stats.failed;
+    result["throughput_rps"] = seconds > 0 ? stats.latency.count() / seconds : 0;
+    result["latency_us"] = stats.latency.summary(true);
+    return result;
+}
+
+void printStatsRow(const string& name, const OperationStats& stats, double seconds) {
+    const auto& h = stats.latency;
+    printf("%-16s %8llu %8llu %8llu %6llu %6llu %9.2f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name.c_str(),
+           (unsigned long long)h.count(), (unsigned long long)stats.ok, (unsigned long long)stats.conflict,
+           (unsigned long long)stats.error, (unsigned long long)stats.failed, seconds > 0 ? h.count() / seconds : 0,
+           h.percentile(50) / 1000.0, h.percentile(90) / 1000.0, h.percentile(99) / 1000.0,
+           h.percentile(99.9) / 1000.0, h.maximum() / 1000.0);
+}
+
+bool parseMix(const string& spec, int mix[OP_COUNT]) {
+    int parsed[OP_COUNT] = {0, 0, 0, 0};
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == string::npos) {
+            comma = spec.size();
+        }
+        const string item = spec.substr(pos, comma - pos);
+        const size_t eq = item.find('=');
+        if (eq == string::npos) {
+            return false;
+        }
+        const string name = item.substr(0, eq);
+        const int weight = atoi(item.c_str() + eq + 1);
+        auto it = find(begin(OPERATION_NAMES), end(OPERATION_NAMES), name);
+        if (it == end(OPERATION_NAMES) || weight < 0) {
+            return false;
+        }
+        parsed[it - begin(OPERATION_NAMES)] = weight;
+        pos = comma + 1;
+    }
+    int sum = 0;
+    for (int op = 0; op < OP_COUNT; op++) {
+        sum += parsed[op];
+    }
+    if (sum == 0) {
+        return false;
+    }
+    copy(begin(parsed), end(parsed), mix);
+    return true;
+}
+
+void printUsage(const char* program) {
+    cerr << "Использование: " << program << " [опции]\n"
+         << "  --host <адрес>        сервер (127.0.0.1)\n"
+         << "  --port <порт>         порт сервера (8080)\n"
+         << "  --users <N>           число синтетических пользователей (16)\n"
+         << "  --concurrency <N>     число потоков (4)\n"
+         << "  --rate <r/s>          интенсивность запросов; 0 - замкнутый цикл (0)\n"
+         << "  --duration <сек>      длительность прогона (30)\n"
+         << "  --requests <N>        остановиться после N запросов (без ограничения)\n"
+         << "  --mix <смесь>         веса операций (login=40,getVault=40,updateVault=15,changePassword=5)\n"
+         << "  --vault-bytes <N>     размер выгружаемого хранилища в байтах (1024)\n"
+         << "  --timeout <сек>       таймаут ответа сервера (120)\n"
+         << "  --protocol <протокол> binary или json (binary)\n"
+         << "  --tls <сертификат>    соединение по TLS, сервер проверяется по файлу (server.crt)\n"
+         << "  --json                вывести результат в JSON\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (!initCryptoRuntime()) {
+        cerr << "Ошибка инициализации libsodium" << endl;
+        return 1;
+    }
+
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--json") {
+            options.jsonOutput = true;
+        } else if (arg == "--host" && hasValue) {
+            options.host = argv[++i];
+        } else if (arg == "--port" && hasValue) {
+            options.port = atoi(argv[++i]);
+        } else if (arg == "--users" && hasValue) {
+            options.users = atoi(argv[++i]);
+        } else if (arg == "--concurrency" && hasValue) {
+            options.concurrency = atoi(argv[++i]);
+        } else if (arg == "--rate" && hasValue) {
+            options.rate = atof(argv[++i]);
+        } else if (arg == "--duration" && hasValue) {
+            options.duration = atof(argv[++i]);
+        } else if (arg == "--requests" && hasValue) {
+            options.requests = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--vault-bytes" && hasValue) {
+            options.vaultBytes = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--timeout" && hasValue) {
+            options.timeoutSeconds = atoi(argv[++i]);
+        } else if (arg == "--protocol" && hasValue) {
+            string protocol = argv[++i];
+            if (protocol == "json") {
+                options.codec = &defaultWireCodec();
+            } else if (protocol == "binary") {
+                options.codec = &binaryWireCodec();
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--tls" && hasValue) {
+            try {
+                options.tls = TlsContext::createClient(argv[++i]);
+            } catch (const exception& e) {
+                cerr << "Ошибка настройки TLS: " << e.what() << endl;
+                return 1;
+            }
+        } else if (arg == "--mix" && hasValue) {
+            if (!parseMix(argv[++i], options.mix)) {
+                cerr << "Некорректная смесь операций: " << argv[i] << endl;
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.users <= 0 || options.concurrency <= 0 || options.duration <= 0 || options.rate < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        cerr << "Регистрация " << options.users << " пользователей на " << options.host << ":" << options.port
+             << "..." << endl;
+        UserPool pool(registerUsers(options));
+
+        LoadRunner runner(options, pool);
+        cerr << "Нагрузка: " << options.concurrency << " потоков, "
+             << (options.rate > 0 ? to_string(options.rate) + " запросов/с" : string("замкнутый цикл")) << ", до "
+             << options.duration << " с" << endl;
+        const double seconds = runner.run();
+
+        OperationStats total;
+        for (int op = 0; op < OP_COUNT; op++) {
+            total.merge(runner.stats(op));
+        }
+
+        if (options.jsonOutput) {
+            json report;
+            report["config"] = {
+                {"host", options.host},
+                {"port", options.port},
+                {"users", options.users},
+                {"concurrency", options.concurrency},
+                {"rate", options.rate},
+                {"duration", options.duration},
+                {"requests", options.requests},
+                {"vault_bytes", options.vaultBytes},
+                {"protocol", options.codec == &binaryWireCodec() ? "binary" : "json"},
+                {"tls", options.tls != nullptr},
+            };
+            for (int op = 0; op < OP_COUNT; op++) {
+                report["config"]["mix"][OPERATION_NAMES[op]] = options.mix[op];
+            }
+            report["elapsed_s"] = seconds;
+            for (int op = 0; op < OP_COUNT; op++) {
+                if (runner.stats(op).latency.count() != 0) {
+                    report["operations"][OPERATION_NAMES[op]] = statsToJson(runner.stats(op), seconds);
+                }
+            }
+            report["total"] = statsToJson(total, seconds);
+            if (options.tls) {
+                report["tls"] = {{"full_handshakes", fullHandshakes.load()}, {"resumed_handshakes", resumedHandshakes.load()}};
+            }
+            cout << report.dump(2) << endl;
+        } else {
+            printf("\n%-16s %8s %8s %8s %6s %6s %9s %9s %9s %9s %9s %9s\n", "operation", "count", "ok", "conflict",
+                   "error", "failed", "req/s", "p50 ms", "p90 ms", "p99 ms", "p999 ms", "max ms");
+            for (int op = 0; op < OP_COUNT; op++) {
+                if (runner.stats(op).latency.count() != 0) {
+                    printStatsRow(OPERATION_NAMES[op], runner.stats(op), seconds);
+                }
+            }
+            printStatsRow("total", total, seconds);
+            printf("\nДлительность: %.1f с\n", seconds);
+            if (options.tls) {
+                printf("Рукопожатия TLS: полных %llu, с возобновлением %llu\n",
+                       static_cast<unsigned long long>(fullHandshakes.load()),
+                       static_cast<unsigned long long>(resumedHandshakes.load()));
+            }
+        }
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "rateLimiter.h"
+
+#include <algorithm>
+#include <sodium.h>
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace {
+
+int64_t nowNanoseconds() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+RateLimiter::RateLimiter(uint32_t burst, chrono::nanoseconds interval, size_t capacity)
+    : interval(interval.count()), burstWindow(static_cast<int64_t>(burst) * interval.count()),
+      shardSize(max(PROBE_WINDOW, capacity / SHARD_COUNT)), slots(new Slot[SHARD_COUNT * shardSize]),
+      checks(0), rejected(0), overflowed(0), nextSweep(0) {
+    randombytes_buf(hashKey, sizeof(hashKey));
+}
+
+RateLimiter::~RateLimiter() {
+    delete[] slots;
+}
+
+uint64_t RateLimiter::hash(string_view key) const {
+    static_assert(sizeof(hashKey) == crypto_shorthash_KEYBYTES, "ключ SipHash");
+    uint64_t hashed = 0;
+    crypto_shorthash(reinterpret_cast<unsigned char*>(&hashed), reinterpret_cast<const unsigned char*>(key.data()),
+                     key.size(), hashKey);
+    return hashed == 0 ? 1 : hashed;  // 0 обозначает свободную запись
+}
+
+RateLimiter::Slot* RateLimiter::find(uint64_t hashed, int64_t now, bool claim) {
+    const size_t shard = hashed % SHARD_COUNT;
+    Slot* base = slots + shard * shardSize;
+    const size_t start = (hashed / SHARD_COUNT) % shardSize;
+
+    // Сначала ищем ключ во всём окне, попутно запоминая свободную или истёкшую запись
+    Slot* reusable = nullptr;
+    uint64_t reusableKey = 0;
+    for (size_t i = 0; i < PROBE_WINDOW; i++) {
+        Slot* slot = base + (start + i) % shardSize;
+        const uint64_t key = slot->key.load(memory_order_acquire);
+        if (key == hashed) {
+            return slot;
+        }
+        if (!reusable && (key == 0 || slot->fullAt.load(memory_order_relaxed) <= now)) {
+            reusable = slot;
+            reusableKey = key;
+        }
+    }
+    if (!claim) {
+        return nullptr;
+    }
+
+    // Истёкшее ведро полное - новый ключ наследует его как есть
+    if (reusable && reusable->key.compare_exchange_strong(reusableKey, hashed, memory_order_acq_rel)) {
+        return reusable;
+    }
+    overflowed.fetch_add(1, memory_order_relaxed);
+    return &overflow[shard];
+}
+
+void RateLimiter::sweep(size_t shard, int64_t now) {
+    Slot* base = slots + shard * shardSize;
+    for (size_t i = 0; i < shardSize; i++) {
+        uint64_t key = base[i].key.load(memory_order_relaxed);
+        if (key != 0 && base[i].fullAt.load(memory_order_relaxed) <= now) {
+            base[i].key.compare_exchange_strong(key, 0, memory_order_relaxed);
+        }
+    }
+}
+
+bool RateLimiter::acquire(string_view key, chrono::nanoseconds& retryAfter) {
+    const int64_t now = nowNanoseconds();
+    if (checks.fetch_add(1, memory_order_relaxed) % SWEEP_EVERY == SWEEP_EVERY - 1) {
+        sweep(nextSweep.fetch_add(1, memory_order_relaxed) % SHARD_COUNT, now);
+    }
+
+    Slot* slot = find(hash(key), now, true);
+    int64_t fullAt = slot->fullAt.load(memory_order_relaxed);
+    while (true) {
+        // Попытка сдвигает момент полного ведра на interval; дальше burst попыток от now - отказ
+        const int64_t next = max(fullAt, now) + interval;
+        if (next - now > burstWindow) {
+            rejected.fetch_add(1, memory_order_relaxed);
+            retryAfter = chrono::nanoseconds(next - now - burstWindow);
+            return false;
+        }
+        if (slot->fullAt.compare_exchange_weak(fullAt, next, memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+void RateLimiter::refund(string_view key) {
+    const int64_t now = nowNanoseconds();
+    const uint64_t hashed = hash(key);
+    Slot* slot = find(hashed, now, false);
+    if (!slot) {
+        // Как и в acquire: ключа нет в окне - попытка ушла в общее ведро сегмента.
+        // Если же запись просто истекла, общее ведро получает лишний токен; это
+        // поблажка, а не обход: возврат бывает только после успешной проверки
+        slot = &overflow[hashed % SHARD_COUNT];
+    }
+    int64_t fullAt = slot->fullAt.load(memory_order_relaxed);
+    while (fullAt > now && !slot->fullAt.compare_exchange_weak(fullAt, max(fullAt - interval, now), memory_order_relaxed)) {
+    }
+}
+
+json RateLimiter::snapshot() const {
+    const int64_t now = nowNanoseconds();
+    size_t active = 0;
+    for (size_t i = 0; i < SHARD_COUNT * shardSize; i++) {
+        if (slots[i].key.load(memory_order_relaxed) != 0 && slots[i].fullAt.load(memory_order_relaxed) > now) {
+            active++;
+        }
+    }
+
+    json result;
+    result["checks"] = checks.load(memory_order_relaxed);
+    result["rejected"] = rejected.load(memory_order_relaxed);
+    result["overflowed"] = overflowed.load(memory_order_relaxed);
+    result["active_keys"] = active;
+    result["capacity"] = SHARD_COUNT * shardSize;
+    return result;
+}
@@ -0,0 +1,69 @@
+#ifndef COURSEWORK_RATE_LIMITER_H
+#define COURSEWORK_RATE_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "json.hpp"
+
+// Ограничение частоты попыток по ключу (адрес клиента, имя пользователя)
+// до любой работы KDF. Ведро токенов в форме GCRA: состояние ключа - одно
+// атомарное время, к которому ведро снова станет полным, так что проверка -
+// хеш ключа, несколько чтений и один CAS, без блокировок и выделения памяти.
+//
+// Таблица разбита на сегменты с открытой адресацией в коротком окне. Ключ
+// хранится 64-битным SipHash со случайным ключом процесса: подобрать
+// коллизии извне нельзя. Полное ведро не отличается от отсутствующего,
+// поэтому истёкшие записи просто занимаются новыми ключами, а сегменты по
+// очереди вычищаются по ходу проверок. Если окно забито живыми ключами
+// (поток случайных адресов или имён), ключ попадает в общее ведро сегмента:
+// такой поток ограничивается целиком, а не проходит мимо лимита.
+// Гонки при занятии записи могут изредка засчитать попытку соседнему ключу -
+// это неточность лимита, но не обход.
+class RateLimiter {
+public:
+    // burst попыток подряд, дальше по одной за interval
+    RateLimiter(uint32_t burst, std::chrono::nanoseconds interval, size_t capacity = 1 << 16);
+    ~RateLimiter();
+
+    // false - попытка отклонена, retryAfter - когда появится следующая
+    bool acquire(std::string_view key, std::chrono::nanoseconds& retryAfter);
+    // Вернуть токен: попытка не должна тратить этот лимит
+    void refund(std::string_view key);
+
+    nlohmann::json snapshot() const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 64;
+    static constexpr size_t PROBE_WINDOW = 8;
+    static constexpr uint64_t SWEEP_EVERY = 1024;  // проверок на очистку одного сегмента
+
+    struct Slot {
+        std::atomic<uint64_t> key{0};   // 0 - свободна
+        std::atomic<int64_t> fullAt{0}; // нс steady_clock, когда ведро снова полное
+    };
+
+    int64_t interval;
+    int64_t burstWindow;  // burst * interval
+    size_t shardSize;
+    Slot* slots;                        // SHARD_COUNT сегментов по shardSize
+    Slot overflow[SHARD_COUNT];         // общие вёдра переполненных сегментов
+    unsigned char hashKey[16];
+
+    std::atomic<uint64_t> checks;
+    std::atomic<uint64_t> rejected;
+    std::atomic<uint64_t> overflowed;
+    std::atomic<size_t> nextSweep;
+
+    uint64_t hash(std::string_view key) const;
+    Slot* find(uint64_t hashed, int64_t now, bool claim);
+    void sweep(size_t shard, int64_t now);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+};
+
+#endif // COURSEWORK_RATE_LIMITER_H
@@ -0,0 +1,79 @@
+#include "requestLane.h"
+#include "logger.h"
+
+using namespace std;
+
+RequestLane::RequestLane(const string& name, int workers, size_t capacity)
+    : laneName(name), workerCount(workers), maxQueued(capacity), rejectedCount(0), stopping(false) {
+}
+
+RequestLane::~RequestLane() {
+    stop();
+}
+
+void RequestLane::start() {
+    lock_guard<mutex> lock(queueMutex);
+    if (!workers.empty()) {
+        return;
+    }
+    stopping = false;
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&RequestLane::run, this);
+    }
+}
+
+bool RequestLane::push(Task task) {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (tasks.size() >= maxQueued) {
+            rejectedCount++;
+            return false;
+        }
+        tasks.push_back(move(task));
+    }
+    ready.notify_one();
+    return true;
+}
+
+void RequestLane::stop() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+size_t RequestLane::queued() const {
+    lock_guard<mutex> lock(queueMutex);
+    return tasks.size();
+}
+
+void RequestLane::run() {
+    while (true) {
+        Task task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;  // остановка, очередь пуста
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+
+        // Исключение из задачи не должно останавливать рабочий поток
+        try {
+            task();
+        } catch (const exception& e) {
+            logError("Необработанное исключение в очереди запросов", {{"lane", laneName}, {"error", e.what()}});
+        } catch (...) {
+            logError("Необработанное исключение в очереди запросов", {{"lane", laneName}});
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef COURSEWORK_REQUEST_LANE_H
+#define COURSEWORK_REQUEST_LANE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Очередь запросов со своими рабочими потоками. Сервер держит две такие
+// очереди: для дорогих (Argon2id) и изменяющих данные запросов и быструю -
+// для дешёвых запросов только на чтение, чтобы они не ждали за KDF.
+// Длина очереди ограничена: при перегрузке запрос сразу получает отказ,
+// а не ждёт дольше, чем клиент готов ждать ответа.
+class RequestLane {
+public:
+    using Task = std::function<void()>;
+
+    RequestLane(const std::string& name, int workers, size_t capacity);
+    ~RequestLane();
+
+    void start();
+    // false - очередь полна, задача не поставлена
+    bool push(Task task);
+    // Дорабатывает уже поставленные задачи и ждёт рабочие потоки
+    void stop();
+
+    size_t queued() const;
+    size_t capacity() const { return maxQueued; }
+    uint64_t rejected() const { return rejectedCount; }
+    const std::string& name() const { return laneName; }
+
+private:
+    std::string laneName;
+    int workerCount;
+    size_t maxQueued;
+    std::atomic<uint64_t> rejectedCount;
+
+    mutable std::mutex queueMutex;
+    std::condition_variable ready;
+    std::deque<Task> tasks;
+    bool stopping;
+    std::vector<std::thread> workers;
+
+    void run();
+
+    RequestLane(const RequestLane&) = delete;
+    RequestLane& operator=(const RequestLane&) = delete;
+};
+
+#endif // COURSEWORK_REQUEST_LANE_H
@@ -0,0 +1,120 @@
+#include "requestSchema.h"
+#include "common_utils.h"
+
+#include <array>
+#include <stdexcept>
+
+using namespace std;
+namespace {
+
+bool isHexString(string_view text) {
+    static const auto table = [] {
+        array<bool, 256> digits{};
+        for (unsigned char c : string_view("0123456789abcdefABCDEF")) {
+            digits[c] = true;
+        }
+        return digits;
+    }();
+    for (unsigned char c : text) {
+        if (!table[c]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+string RequestView::bind(const RequestSchema& schema, const WireObject& document) {
+    count = 0;
+
+    for (const FieldSpec& spec : schema) {
+        if (spec.name.empty()) {
+            break;
+        }
+        Field& field = fields[count++];
+        field = Field();
+        field.name = spec.name;
+
+        const WireObject::Member* member = document.find(spec.name);
+        if (!member || member->kind == WireObject::Kind::Null) {
+            if (spec.required) {
+                return "Отсутствует обязательное поле: " + string(spec.name);
+            }
+            continue;
+        }
+
+        switch (spec.type) {
+            case FieldType::String:
+            case FieldType::Hex: {
+                if (spec.type == FieldType::Hex && member->kind == WireObject::Kind::Bytes) {
+                    if (member->value.size() * 2 > spec.maxLength) {
+                        return "Поле " + string(spec.name) + " слишком длинное";
+                    }
+                    field.text = member->value;
+                    field.raw = true;
+                    break;
+                }
+                if (member->kind != WireObject::Kind::String) {
+                    return "Поле " + string(spec.name) + " должно быть строкой";
+                }
+                if (member->value.size() > spec.maxLength) {
+                    return "Поле " + string(spec.name) + " слишком длинное";
+                }
+                if (spec.type == FieldType::Hex && (member->value.size() % 2 != 0 || !isHexString(member->value))) {
+                    return "Поле " + string(spec.name) + " должно быть hex-строкой";
+                }
+                field.text = member->value;
+                break;
+            }
+            case FieldType::UInt:
+                if (!WireObject::toUInt(*member, field.number)) {
+                    return "Поле " + string(spec.name) + " должно быть неотрицательным целым";
+                }
+                break;
+            case FieldType::Bool:
+                if (member->kind != WireObject::Kind::True && member->kind != WireObject::Kind::False) {
+                    return "Поле " + string(spec.name) + " должно быть true или false";
+                }
+                field.boolean = member->kind == WireObject::Kind::True;
+                break;
+        }
+        field.present = true;
+    }
+    return "";
+}
+
+const RequestView::Field* RequestView::find(string_view name) const {
+    for (size_t i = 0; i < count; i++) {
+        if (fields[i].name == name) {
+            return &fields[i];
+        }
+    }
+    throw runtime_error("Поле " + string(name) + " не описано в схеме действия");
+}
+
+bool RequestView::has(string_view name) const {
+    return find(name)->present;
+}
+
+string_view RequestView::str(string_view name) const {
+    return find(name)->text;
+}
+
+vector<unsigned char> RequestView::bytes(string_view name) const {
+    const Field* field = find(name);
+    if (field->raw) {
+        return vector<unsigned char>(field->text.begin(), field->text.end());
+    }
+    return hexToBytes(field->text);
+}
+
+uint64_t RequestView::uint(string_view name, uint64_t fallback) const {
+    const Field* field = find(name);
+    return field->present ? field->number : fallback;
+}
+
+bool RequestView::flag(string_view name, bool fallback) const {
+    const Field* field = find(name);
+    return field->present ? field->boolean : fallback;
+}
@@ -0,0 +1,57 @@
+#ifndef COURSEWORK_REQUEST_SCHEMA_H
+#define COURSEWORK_REQUEST_SCHEMA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "wireCodec.h"
+
+// Схема полей запроса: тип, обязательность и предельная длина строки.
+// Проверяется один раз сразу после разбора, до постановки в очередь, так что
+// обработчики получают уже проверенные поля и не ловят type_error.
+enum class FieldType { String, Hex, UInt, Bool };
+
+struct FieldSpec {
+    std::string_view name;
+    FieldType type = FieldType::String;
+    bool required = false;
+    size_t maxLength = 0;  // только для строк
+};
+
+constexpr size_t MAX_REQUEST_FIELDS = 4;
+using RequestSchema = std::array<FieldSpec, MAX_REQUEST_FIELDS>;  // пустое имя - конец списка
+
+// Проверенные поля запроса. Строки - string_view в буфер запроса, разобранный
+// на месте, поэтому буфер должен жить дольше представления
+class RequestView {
+public:
+    // Пустая строка - запрос соответствует схеме, иначе текст ошибки для клиента
+    std::string bind(const RequestSchema& schema, const WireObject& document);
+
+    bool has(std::string_view name) const;
+    std::string_view str(std::string_view name) const;
+    // Значение Hex-поля: из hex-строки JSON или сырыми байтами бинарного протокола
+    std::vector<unsigned char> bytes(std::string_view name) const;
+    uint64_t uint(std::string_view name, uint64_t fallback = 0) const;
+    bool flag(std::string_view name, bool fallback = false) const;
+
+private:
+    struct Field {
+        std::string_view name;
+        bool present = false;
+        std::string_view text;
+        bool raw = false;  // text - сырые байты, а не hex
+        uint64_t number = 0;
+        bool boolean = false;
+    };
+
+    std::array<Field, MAX_REQUEST_FIELDS> fields{};
+    size_t count = 0;
+
+    const Field* find(std::string_view name) const;
+};
+
+#endif // COURSEWORK_REQUEST_SCHEMA_H
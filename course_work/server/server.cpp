@@ -4,43 +4,304 @@
 #include "log_in.h"
 #include "common_utils.h"
 #include "userHashTable.h"
+#include "serverStats.h"
+#include "logger.h"
+#include "messageChannel.h"
+#include "tlsChannel.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <mutex>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstring>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <thread>
 
 using namespace std;
 using json = nlohmann::json;
+using PhaseTimer = ServerStats::PhaseTimer;
+
+namespace {
+
+// Обёртки над функциями ядра, засекающие фазу запроса для статистики
+
+bool findUser(const string& username, HashTableUsers& users) {
+    PhaseTimer timer(ServerStats::PHASE_USERS);
+    return existUser(username, users);
+}
+
+bool verifyPassword(const string& username, const string& password, const HashTableUsers& users) {
+    PhaseTimer timer(ServerStats::PHASE_KDF);
+    return checkPasswordUser(username, password, users);
+}
+
+bool verifyPhrase(const string& username, HashTableUsers& users, const string& seedPhrase) {
+    PhaseTimer timer(ServerStats::PHASE_KDF);
+    return checkPhrase(username, users, seedPhrase);
+}
+
+// Argon2id пароля и генерация фразы восстановления
+vector<string> createUser(const string& username, const string& password, HashTableUsers& users) {
+    PhaseTimer timer(ServerStats::PHASE_KDF);
+    return loginExist(username, password, &users);
+}
+
+vector<string> rotateUserSecrets(const string& username, const string& newPassword, HashTableUsers& users) {
+    PhaseTimer timer(ServerStats::PHASE_KDF);
+    return switchDataUsers(username, newPassword, users);
+}
+
+// Файл хранилища на сервере: "PMSV", версия (8 байт, старший байт первым),
+// затем данные клиента как есть. Версия лежит в том же файле, что и данные,
+// и заменяется вместе с ними. У файлов старого формата заголовка нет,
+// их версия - в соседнем файле .version
+const char VAULT_FILE_MAGIC[4] = {'P', 'M', 'S', 'V'};
+constexpr size_t VAULT_FILE_HEADER_SIZE = 12;
+
+bool parseVaultFileHeader(const char* header, uint64_t& version) {
+    if (memcmp(header, VAULT_FILE_MAGIC, sizeof(VAULT_FILE_MAGIC)) != 0) {
+        return false;
+    }
+    version = 0;
+    for (size_t i = sizeof(VAULT_FILE_MAGIC); i < VAULT_FILE_HEADER_SIZE; i++) {
+        version = (version << 8) | static_cast<unsigned char>(header[i]);
+    }
+    return true;
+}
+
+uint64_t readLegacyVaultVersion(const string& vaultPath) {
+    ifstream file(vaultPath + ".version");
+    uint64_t version = 0;
+    if (!(file >> version)) {
+        return 0;
+    }
+    return version;
+}
+
+bool writeAll(int fd, const void* data, size_t length) {
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+        const ssize_t n = write(fd, bytes, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+string vaultToHex(const vector<unsigned char>& vaultData) {
+    PhaseTimer timer(ServerStats::PHASE_SERIALIZE);
+    return toHex(vaultData);
+}
+
+vector<unsigned char> vaultFromRequest(const RequestView& request) {
+    PhaseTimer timer(ServerStats::PHASE_SERIALIZE);
+    return request.bytes("vaultData");
+}
+
+// IPv4-адрес клиента в порядке байтов хоста, 0 - не IPv4
+uint32_t peerAddress(int clientSocket) {
+    sockaddr_in peer{};
+    socklen_t peerLen = sizeof(peer);
+    if (getpeername(clientSocket, (struct sockaddr*)&peer, &peerLen) < 0 || peer.sin_family != AF_INET) {
+        return 0;
+    }
+    return ntohl(peer.sin_addr.s_addr);
+}
+
+bool isLoopback(uint32_t address) {
+    return (address >> 24) == 127;
+}
+
+string_view addressKey(const uint32_t& address) {
+    return string_view(reinterpret_cast<const char*>(&address), sizeof(address));
+}
+
+// Поля запросов. Пределы длины с запасом над правилами validateUsername и
+// validatePassword: подробную ошибку по содержимому даёт обработчик
+constexpr size_t MAX_SECRET_LENGTH = 1024;
+constexpr int CLIENT_READ_TIMEOUT_SECONDS = 10;  // на запрос целиком, как бы медленно ни шли байты
+constexpr int KEEPALIVE_IDLE_SECONDS = 30;       // простой соединения TLS между запросами
+constexpr size_t MAX_CONNECTIONS = 128;          // по потоку на соединение
+constexpr unsigned char TLS_HANDSHAKE_RECORD = 0x16;
+
+// Пределы очередей: в очереди KDF один поток, и запрос в её конце ждёт
+// десятки вычислений Argon2id - дальше клиент ждать уже не станет
+constexpr size_t KDF_QUEUE_CAPACITY = 32;
+constexpr size_t FAST_QUEUE_CAPACITY = 256;
+constexpr int BUSY_RETRY_AFTER_SECONDS = 1;
+
+// Лимиты попыток действий с KDF. С одного адреса - после 30 подряд одна в 3 с,
+// успешные попытки (и регистрация) тоже считаются: каждая стоит Argon2id.
+// Подбор пароля к учётной записи - после 10 неудачных подряд одна в 30 с;
+// успешные попытки учётной записи идут по отдельному, более щедрому лимиту
+constexpr uint32_t ACCOUNT_BURST = 10;
+constexpr chrono::seconds ACCOUNT_INTERVAL(30);
+constexpr uint32_t ACCOUNT_SUCCESS_BURST = 30;
+constexpr chrono::seconds ACCOUNT_SUCCESS_INTERVAL(5);
+constexpr uint32_t ADDRESS_BURST = 30;
+constexpr chrono::seconds ADDRESS_INTERVAL(3);
+constexpr FieldSpec USERNAME{"username", FieldType::String, true, 64};
+constexpr FieldSpec PASSWORD{"password", FieldType::String, true, MAX_SECRET_LENGTH};
+constexpr FieldSpec NEW_PASSWORD{"newPassword", FieldType::String, true, MAX_SECRET_LENGTH};
+constexpr FieldSpec SEED_PHRASE{"seedPhrase", FieldType::String, true, MAX_SECRET_LENGTH};
+constexpr FieldSpec VAULT_DATA{"vaultData", FieldType::Hex, true, MAX_MESSAGE_BYTES};
+constexpr FieldSpec BASE_VERSION{"baseVersion", FieldType::UInt, false};
+constexpr FieldSpec HISTOGRAMS{"histograms", FieldType::Bool, false};
+
+// Ответ на запрос, не дошедший до обработчика
+json errorResponse(const string& message) {
+    json response;
+    response["status"] = "error";
+    response["message"] = message;
+    return response;
+}
+
+} // namespace
+
+// Таблица действий протокола, отсортированная по имени: поиск - двоичный,
+// новое действие - одна строка здесь. Server объявляет её другом, чтобы
+// брать адреса закрытых обработчиков
+struct ActionTable {
+    using Cost = Server::CostClass;
+
+    static constexpr Server::ActionSpec entries[] = {
+        {"changePassword",         &Server::handleChangePassword,         {USERNAME, SEED_PHRASE, NEW_PASSWORD},             Cost::Kdf,   true,  false},
+        {"checkUser",              &Server::handleCheckUser,              {USERNAME},                                        Cost::Cheap, false, false},
+        {"getVault",               &Server::handleGetVault,               {USERNAME, PASSWORD},                              Cost::Kdf,   false, false},
+        {"getVaultWithSeedPhrase", &Server::handleGetVaultWithSeedPhrase, {USERNAME, SEED_PHRASE},                           Cost::Kdf,   false, false},
+        {"login",                  &Server::handleLogin,                  {USERNAME, PASSWORD},                              Cost::Kdf,   false, false},
+        {"recoverPassword",        &Server::handleRecoverPassword,        {USERNAME, SEED_PHRASE, NEW_PASSWORD},             Cost::Kdf,   true,  false},
+        {"register",               &Server::handleRegister,               {USERNAME, PASSWORD},                              Cost::Kdf,   true,  false},
+        {"stats",                  &Server::handleStats,                  {HISTOGRAMS},                                      Cost::Cheap, false, true},
+        {"updateVault",            &Server::handleUpdateVault,            {USERNAME, PASSWORD, VAULT_DATA, BASE_VERSION},    Cost::Kdf,   true,  false},
+    };
+
+    static constexpr bool sorted() {
+        for (size_t i = 1; i < size(entries); i++) {
+            if (!(entries[i - 1].name < entries[i].name)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static_assert(ActionTable::sorted(), "ActionTable::entries должна быть отсортирована по имени без повторов");
+
+const Server::ActionSpec* Server::findAction(string_view name) {
+    const auto* begin = std::begin(ActionTable::entries);
+    const auto* end = std::end(ActionTable::entries);
+    const auto* it = lower_bound(begin, end, name, [](const ActionSpec& spec, string_view key) {
+        return spec.name < key;
+    });
+    return it != end && it->name == name ? it : nullptr;
+}
+
+vector<string> Server::actionNames() {
+    vector<string> names;
+    for (const auto& spec : ActionTable::entries) {
+        names.emplace_back(spec.name);
+    }
+    return names;
+}
 
 Server::Server(int port, const string& usersFile, const string& vaultDir) 
-    : port(port), usersFilePath(usersFile), vaultDirectory(vaultDir), serverSocket(-1) {
+    : usersFilePath(usersFile), vaultDirectory(vaultDir), port(port), serverSocket(-1),
+      stats(actionNames()), kdfLane("kdf", 1, KDF_QUEUE_CAPACITY), fastLane("fast", 2, FAST_QUEUE_CAPACITY),
+      addressLimiter(ADDRESS_BURST, ADDRESS_INTERVAL), accountLimiter(ACCOUNT_BURST, ACCOUNT_INTERVAL),
+      accountSuccessLimiter(ACCOUNT_SUCCESS_BURST, ACCOUNT_SUCCESS_INTERVAL),
+      tlsCertPath("server.crt"), tlsKeyPath("server.key"), requireTls(false), tlsContext(nullptr),
+      connectionThreads(0), connectionsRejected(0), tlsHandshakes(0), tlsResumed(0), tlsFailed(0) {
 }
 
 Server::~Server() {
     stop();
+    delete tlsContext;
 }
 
 string Server::getUserVaultPath(const string& username) {
     return vaultDirectory + "/" + username + ".vault";
 }
 
-bool Server::createUserVault(const string& username, const vector<unsigned char>& encryptedData) {
+// Нет файла - версия 0
+uint64_t Server::readVaultVersion(const string& username) {
+    PhaseTimer timer(ServerStats::PHASE_VAULT_IO);
+    shared_lock<shared_mutex> lock(storageMutex);
     string vaultPath = getUserVaultPath(username);
-    ofstream file(vaultPath, ios::binary);
+    ifstream file(vaultPath, ios::binary);
     if (!file.is_open()) {
+        return 0;
+    }
+    char header[VAULT_FILE_HEADER_SIZE];
+    uint64_t version = 0;
+    if (file.read(header, sizeof(header)) && parseVaultFileHeader(header, version)) {
+        return version;
+    }
+    return readLegacyVaultVersion(vaultPath);
+}
+
+// Вызывается под блокировкой createUserVault/updateUserVault. Запись идёт во
+// временный файл, который затем заменяет хранилище (rename): при сбое на диске
+// остаётся старое хранилище или новое целиком, а версия всегда от тех же данных
+bool Server::writeVaultFile(const string& username, const vector<unsigned char>& encryptedData, uint64_t version) {
+    string vaultPath = getUserVaultPath(username);
+    string tempPath = vaultPath + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
         return false;
     }
     
-    file.write(reinterpret_cast<const char*>(encryptedData.data()), encryptedData.size());
-    file.close();
+    char header[VAULT_FILE_HEADER_SIZE];
+    memcpy(header, VAULT_FILE_MAGIC, sizeof(VAULT_FILE_MAGIC));
+    for (size_t i = sizeof(VAULT_FILE_MAGIC); i < VAULT_FILE_HEADER_SIZE; i++) {
+        header[i] = static_cast<char>(version >> (8 * (VAULT_FILE_HEADER_SIZE - 1 - i)));
+    }
+    bool written = writeAll(fd, header, sizeof(header)) &&
+                   writeAll(fd, encryptedData.data(), encryptedData.size()) &&
+                   fsync(fd) == 0;
+    written = close(fd) == 0 && written;
+    if (!written || rename(tempPath.c_str(), vaultPath.c_str()) != 0) {
+        unlink(tempPath.c_str());
+        return false;
+    }
+    
+    // Сама замена тоже должна пережить сбой питания
+    int dir = open(vaultDirectory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir >= 0) {
+        fsync(dir);
+        close(dir);
+    }
+    // Версия теперь в файле хранилища, старый файл версии не нужен
+    unlink((vaultPath + ".version").c_str());
     return true;
 }
 
+bool Server::createUserVault(const string& username, const vector<unsigned char>& encryptedData) {
+    PhaseTimer timer(ServerStats::PHASE_VAULT_IO);
+    unique_lock<shared_mutex> lock(storageMutex);
+    return writeVaultFile(username, encryptedData, 0);
+}
+
 vector<unsigned char> Server::readUserVault(const string& username) {
+    uint64_t version = 0;
+    return readUserVault(username, version);
+}
+
+vector<unsigned char> Server::readUserVault(const string& username, uint64_t& version) {
+    PhaseTimer timer(ServerStats::PHASE_VAULT_IO);
+    shared_lock<shared_mutex> lock(storageMutex);
     string vaultPath = getUserVaultPath(username);
     ifstream file(vaultPath, ios::binary | ios::ate);
     
@@ -51,6 +312,17 @@ vector<unsigned char> Server::readUserVault(const string& username) {
     streamsize size = file.tellg();
     file.seekg(0, ios::beg);
     
+    // Данные и версия читаются из одного файла под одной блокировкой
+    char header[VAULT_FILE_HEADER_SIZE];
+    if (size >= static_cast<streamsize>(sizeof(header)) && file.read(header, sizeof(header)) &&
+        parseVaultFileHeader(header, version)) {
+        size -= sizeof(header);
+    } else {
+        file.clear();
+        file.seekg(0, ios::beg);
+        version = readLegacyVaultVersion(vaultPath);
+    }
+    
     vector<unsigned char> data(size);
     if (!file.read(reinterpret_cast<char*>(data.data()), size)) {
         throw runtime_error("Ошибка чтения хранилища пользователя");
@@ -60,25 +332,30 @@ vector<unsigned char> Server::readUserVault(const string& username) {
     return data;
 }
 
-bool Server::updateUserVault(const string& username, const vector<unsigned char>& encryptedData) {
-    string vaultPath = getUserVaultPath(username);
-    ofstream file(vaultPath, ios::binary);
-    
-    if (!file.is_open()) {
-        return false;
-    }
-    
-    file.write(reinterpret_cast<const char*>(encryptedData.data()), encryptedData.size());
-    file.close();
-    return true;
+bool Server::updateUserVault(const string& username, const vector<unsigned char>& encryptedData, uint64_t version) {
+    PhaseTimer timer(ServerStats::PHASE_VAULT_IO);
+    unique_lock<shared_mutex> lock(storageMutex);
+    return writeVaultFile(username, encryptedData, version);
 }
 
-json Server::handleRegister(const json& request) {
+void Server::loadUsers(HashTableUsers& users) {
+    PhaseTimer timer(ServerStats::PHASE_USERS);
+    shared_lock<shared_mutex> lock(storageMutex);
+    users.loadFromFile(usersFilePath);
+}
+
+void Server::saveUsers(const HashTableUsers& users) {
+    PhaseTimer timer(ServerStats::PHASE_USERS);
+    unique_lock<shared_mutex> lock(storageMutex);
+    users.saveToFile(usersFilePath);
+}
+
+json Server::handleRegister(const RequestView& request) {
     json response;
     
     try {
-        string username = request["username"];
-        string password = request["password"];
+        string username(request.str("username"));
+        string password(request.str("password"));
         
         // Валидация
         string errorMessage;
@@ -96,10 +373,10 @@ json Server::handleRegister(const json& request) {
         
         // Загружаем таблицу пользователей
         HashTableUsers users;
-        users.loadFromFile(usersFilePath);
+        loadUsers(users);
         
         // Регистрируем пользователя
-        auto seedWords = loginExist(username, password, &users);
+        auto seedWords = createUser(username, password, users);
         
         if (seedWords.empty()) {
             response["status"] = "error";
@@ -108,7 +385,8 @@ json Server::handleRegister(const json& request) {
         }
         
         // Сохраняем пользователей
-        users.saveToFile(usersFilePath);
+        saveUsers(users);
+        usernames.insert(username);
         
         // Получаем vaultSalt для возврата клиенту
         string vaultSaltHex = users.getVaultSalt(username);
@@ -131,33 +409,34 @@ json Server::handleRegister(const json& request) {
     return response;
 }
 
-json Server::handleLogin(const json& request) {
+json Server::handleLogin(const RequestView& request) {
     json response;
     
     try {
-        string username = request["username"];
-        string password = request["password"];
+        string username(request.str("username"));
+        string password(request.str("password"));
         
         // Загружаем таблицу пользователей
         HashTableUsers users;
-        users.loadFromFile(usersFilePath);
+        loadUsers(users);
         
         // Проверяем существование пользователя
-        if (!existUser(username, users)) {
+        if (!findUser(username, users)) {
             response["status"] = "error";
             response["message"] = "Пользователь не найден";
             return response;
         }
         
         // Проверяем пароль
-        if (!checkPasswordUser(username, password, users)) {
+        if (!verifyPassword(username, password, users)) {
             response["status"] = "error";
             response["message"] = "Неверный пароль";
             return response;
         }
         
         // Читаем зашифрованное хранилище пользователя
-        auto vaultData = readUserVault(username);
+        uint64_t vaultVersion = 0;
+        auto vaultData = readUserVault(username, vaultVersion);
         
         // Получаем vaultSalt для клиента
         string vaultSalt = users.getVaultSalt(username);
@@ -167,9 +446,10 @@ json Server::handleLogin(const json& request) {
         response["message"] = "Вход выполнен успешно";
         
         // Конвертируем вектор в base64 или hex для передачи
-        string vaultHex = toHex(vaultData);
+        string vaultHex = vaultToHex(vaultData);
         response["vaultData"] = vaultHex;
         response["vaultSalt"] = vaultSalt;
+        response["vaultVersion"] = vaultVersion;
         
     } catch (const exception& e) {
         response["status"] = "error";
@@ -179,13 +459,13 @@ json Server::handleLogin(const json& request) {
     return response;
 }
 
-json Server::handleChangePassword(const json& request) {
+json Server::handleChangePassword(const RequestView& request) {
     json response;
     
     try {
-        string username = request["username"];
-        string seedPhrase = request["seedPhrase"];
-        string newPassword = request["newPassword"];
+        string username(request.str("username"));
+        string seedPhrase(request.str("seedPhrase"));
+        string newPassword(request.str("newPassword"));
         
         // Валидация нового пароля
         string errorMessage;
@@ -197,17 +477,17 @@ json Server::handleChangePassword(const json& request) {
         
         // Загружаем таблицу пользователей
         HashTableUsers users;
-        users.loadFromFile(usersFilePath);
+        loadUsers(users);
         
         // Проверяем существование пользователя
-        if (!existUser(username, users)) {
+        if (!findUser(username, users)) {
             response["status"] = "error";
             response["message"] = "Пользователь не найден";
             return response;
         }
         
         // Проверяем seed phrase
-        if (!checkPhrase(username, users, seedPhrase)) {
+        if (!verifyPhrase(username, users, seedPhrase)) {
             response["status"] = "error";
             response["message"] = "Неверная фраза восстановления";
             return response;
@@ -224,14 +504,14 @@ json Server::handleChangePassword(const json& request) {
             // Если хранилища нет, создаем пустое
             vaultData.clear();
         }
-        string vaultDataHex = toHex(vaultData);
+        string vaultDataHex = vaultToHex(vaultData);
         
         // Меняем пароль и получаем новую vaultSalt
-        auto newSeedWords = switchDataUsers(username, newPassword, users);
+        auto newSeedWords = rotateUserSecrets(username, newPassword, users);
         string newVaultSalt = users.getVaultSalt(username);
         
         // Сохраняем изменения
-        users.saveToFile(usersFilePath);
+        saveUsers(users);
         
         response["status"] = "success";
         response["message"] = "Пароль успешно изменен";
@@ -248,13 +528,13 @@ json Server::handleChangePassword(const json& request) {
     return response;
 }
 
-json Server::handleRecoverPassword(const json& request) {
+json Server::handleRecoverPassword(const RequestView& request) {
     json response;
     
     try {
-        string username = request["username"];
-        string seedPhrase = request["seedPhrase"];
-        string newPassword = request["newPassword"];
+        string username(request.str("username"));
+        string seedPhrase(request.str("seedPhrase"));
+        string newPassword(request.str("newPassword"));
         
         // Валидация нового пароля
         string errorMessage;
@@ -266,17 +546,17 @@ json Server::handleRecoverPassword(const json& request) {
         
         // Загружаем таблицу пользователей
         HashTableUsers users;
-        users.loadFromFile(usersFilePath);
+        loadUsers(users);
         
         // Проверяем существование пользователя
-        if (!existUser(username, users)) {
+        if (!findUser(username, users)) {
             response["status"] = "error";
             response["message"] = "Пользователь не найден";
             return response;
         }
         
         // Проверяем seed phrase
-        if (!checkPhrase(username, users, seedPhrase)) {
+        if (!verifyPhrase(username, users, seedPhrase)) {
             response["status"] = "error";
             response["message"] = "Неверная фраза восстановления";
             return response;
@@ -293,14 +573,14 @@ json Server::handleRecoverPassword(const json& request) {
             // Если хранилища нет, создаем пустое
             vaultData.clear();
         }
-        string vaultDataHex = toHex(vaultData);
+        string vaultDataHex = vaultToHex(vaultData);
         
         // Меняем пароль и получаем новую vaultSalt
-        auto newSeedWords = switchDataUsers(username, newPassword, users);
+        auto newSeedWords = rotateUserSecrets(username, newPassword, users);
         string newVaultSalt = users.getVaultSalt(username);
         
         // Сохраняем изменения
-        users.saveToFile(usersFilePath);
+        saveUsers(users);
         
         response["status"] = "success";
         response["message"] = "Пароль успешно восстановлен";
@@ -317,26 +597,27 @@ json Server::handleRecoverPassword(const json& request) {
     return response;
 }
 
-json Server::handleGetVault(const json& request) {
+json Server::handleGetVault(const RequestView& request) {
     json response;
     
     try {
-        string username = request["username"];
-        string password = request["password"];
+        string username(request.str("username"));
+        string password(request.str("password"));
         
         // Аутентификация
         HashTableUsers users;
-        users.loadFromFile(usersFilePath);
+        loadUsers(users);
         
-        if (!existUser(username, users) || !checkPasswordUser(username, password, users)) {
+        if (!findUser(username, users) || !verifyPassword(username, password, users)) {
             response["status"] = "error";
             response["message"] = "Ошибка аутентификации";
             return response;
         }
         
         // Читаем зашифрованное хранилище
-        auto vaultData = readUserVault(username);
-        string vaultHex = toHex(vaultData);
+        uint64_t vaultVersion = 0;
+        auto vaultData = readUserVault(username, vaultVersion);
+        string vaultHex = vaultToHex(vaultData);
         
         // Получаем vaultSalt для клиента
         string vaultSalt = users.getVaultSalt(username);
@@ -344,6 +625,7 @@ json Server::handleGetVault(const json& request) {
         response["status"] = "success";
         response["vaultData"] = vaultHex;
         response["vaultSalt"] = vaultSalt;
+        response["vaultVersion"] = vaultVersion;
         
     } catch (const exception& e) {
         response["status"] = "error";
@@ -353,19 +635,12 @@ json Server::handleGetVault(const json& request) {
     return response;
 }
 
-json Server::handleGetVaultWithSeedPhrase(const json& request) {
+json Server::handleGetVaultWithSeedPhrase(const RequestView& request) {
     json response;
     
     try {
-        // Проверяем наличие обязательных полей
-        if (!request.contains("username") || !request.contains("seedPhrase")) {
-            response["status"] = "error";
-            response["message"] = "Отсутствуют обязательные поля";
-            return response;
-        }
-        
-        string username = request["username"];
-        string seedPhrase = request["seedPhrase"];
+        string username(request.str("username"));
+        string seedPhrase(request.str("seedPhrase"));
         
         // Валидация имени пользователя
         string errorMessage;
@@ -377,25 +652,26 @@ json Server::handleGetVaultWithSeedPhrase(const json& request) {
         
         // Загружаем таблицу пользователей
         HashTableUsers users;
-        users.loadFromFile(usersFilePath);
+        loadUsers(users);
         
         // Проверяем существование пользователя
-        if (!existUser(username, users)) {
+        if (!findUser(username, users)) {
             response["status"] = "error";
             response["message"] = "Пользователь не найден";
             return response;
         }
         
         // Аутентификация по seed phrase
-        if (!checkPhrase(username, users, seedPhrase)) {
+        if (!verifyPhrase(username, users, seedPhrase)) {
             response["status"] = "error";
             response["message"] = "Неверная фраза восстановления";
             return response;
         }
         
         // Читаем зашифрованное хранилище
-        auto vaultData = readUserVault(username);
-        string vaultHex = toHex(vaultData);
+        uint64_t vaultVersion = 0;
+        auto vaultData = readUserVault(username, vaultVersion);
+        string vaultHex = vaultToHex(vaultData);
         
         // Получаем vaultSalt для клиента
         string vaultSalt = users.getVaultSalt(username);
@@ -403,6 +679,7 @@ json Server::handleGetVaultWithSeedPhrase(const json& request) {
         response["status"] = "success";
         response["vaultData"] = vaultHex;
         response["vaultSalt"] = vaultSalt;
+        response["vaultVersion"] = vaultVersion;
         
     } catch (const exception& e) {
         response["status"] = "error";
@@ -412,29 +689,42 @@ json Server::handleGetVaultWithSeedPhrase(const json& request) {
     return response;
 }
 
-json Server::handleUpdateVault(const json& request) {
+json Server::handleUpdateVault(const RequestView& request) {
     json response;
     
     try {
-        string username = request["username"];
-        string password = request["password"];
-        string vaultHex = request["vaultData"];
+        string username(request.str("username"));
+        string password(request.str("password"));
         
         // Аутентификация
         HashTableUsers users;
-        users.loadFromFile(usersFilePath);
+        loadUsers(users);
         
-        if (!existUser(username, users) || !checkPasswordUser(username, password, users)) {
+        if (!findUser(username, users) || !verifyPassword(username, password, users)) {
             response["status"] = "error";
             response["message"] = "Ошибка аутентификации";
             return response;
         }
         
+        // Compare-and-swap по версии: клиент, выгружающий правки поверх устаревшей
+        // копии, получает текущее хранилище и сливает его со своими правками.
+        // Запрос без baseVersion (старые клиенты) перезаписывает хранилище как раньше
+        uint64_t currentVersion = readVaultVersion(username);
+        if (request.has("baseVersion") && request.uint("baseVersion") != currentVersion) {
+            response["status"] = "conflict";
+            response["message"] = "Хранилище изменено с другого устройства";
+            uint64_t vaultVersion = 0;
+            response["vaultData"] = vaultToHex(readUserVault(username, vaultVersion));
+            response["vaultSalt"] = users.getVaultSalt(username);
+            response["vaultVersion"] = vaultVersion;
+            return response;
+        }
+        
         // Конвертируем hex обратно в вектор
-        auto vaultData = hexToBytes(vaultHex);
+        auto vaultData = vaultFromRequest(request);
         
         // Обновляем хранилище
-        if (!updateUserVault(username, vaultData)) {
+        if (!updateUserVault(username, vaultData, currentVersion + 1)) {
             response["status"] = "error";
             response["message"] = "Не удалось обновить хранилище";
             return response;
@@ -442,6 +732,7 @@ json Server::handleUpdateVault(const json& request) {
         
         response["status"] = "success";
         response["message"] = "Данные успешно обновлены";
+        response["vaultVersion"] = currentVersion + 1;
         
     } catch (const exception& e) {
         response["status"] = "error";
@@ -451,63 +742,322 @@ json Server::handleUpdateVault(const json& request) {
     return response;
 }
 
-json Server::processRequest(const json& request) {
-    string action = request["action"];
-    
-    if (action == "register") {
-        return handleRegister(request);
-    } else if (action == "login") {
-        return handleLogin(request);
-    } else if (action == "changePassword") {
-        return handleChangePassword(request);
-    } else if (action == "recoverPassword") {
-        return handleRecoverPassword(request);
-    } else if (action == "getVault") {
-        return handleGetVault(request);
-    } else if (action == "getVaultWithSeedPhrase") {
-        return handleGetVaultWithSeedPhrase(request);
-    } else if (action == "updateVault") {
-        return handleUpdateVault(request);
+json Server::processRequest(const PendingRequest& pending) {
+    const ActionSpec* spec = pending.spec;
+    if (!spec) {
+        return errorResponse("Неизвестное действие");
+    }
+    // Статистику отдаём только локальным клиентам
+    if (spec->localOnly && !pending.fromLoopback) {
+        return errorResponse("Действие доступно только локально");
+    }
+    return (this->*spec->handler)(pending.fields);
+}
+
+// Проверка занятости имени перед регистрацией: только индекс в памяти
+json Server::handleCheckUser(const RequestView& request) {
+    json response;
+    response["status"] = "success";
+    response["exists"] = usernames.contains(request.str("username"));
+    return response;
+}
+
+json Server::handleStats(const RequestView& request) {
+    json response;
+    response["status"] = "success";
+    response["stats"] = stats.snapshot(request.flag("histograms"));
+    for (const RequestLane* lane : {&kdfLane, &fastLane}) {
+        response["stats"]["lanes"][lane->name()]["queued"] = lane->queued();
+        response["stats"]["lanes"][lane->name()]["capacity"] = lane->capacity();
+        response["stats"]["lanes"][lane->name()]["rejected"] = lane->rejected();
+    }
+    response["stats"]["username_index"] = usernames.snapshot();
+    {
+        lock_guard<mutex> lock(connectionsMutex);
+        response["stats"]["connections"]["open"] = connectionSockets.size();
+    }
+    response["stats"]["connections"]["rejected"] = connectionsRejected.load();
+    response["stats"]["tls"]["full_handshakes"] = tlsHandshakes.load();
+    response["stats"]["tls"]["resumed_handshakes"] = tlsResumed.load();
+    response["stats"]["tls"]["failed_handshakes"] = tlsFailed.load();
+    response["stats"]["rate_limit"]["address"] = addressLimiter.snapshot();
+    response["stats"]["rate_limit"]["account"] = accountLimiter.snapshot();
+    response["stats"]["rate_limit"]["account_success"] = accountSuccessLimiter.snapshot();
+    return response;
+}
+
+RequestLane& Server::laneFor(const ActionSpec* spec) {
+    // Неизвестные и неразобранные запросы - дешёвая ошибка без доступа к данным
+    if (spec && (spec->cost == CostClass::Kdf || spec->mutates)) {
+        return kdfLane;
+    }
+    return fastLane;
+}
+
+void Server::enqueue(PendingRequest* pending) {
+    if (laneFor(pending->spec).push([this, pending] { serveRequest(pending); })) {
+        return;
+    }
+    // Очередь полна - отказ сразу из потока соединения. Попытка входа
+    // не проверялась, поэтому лимит попыток не тратит
+    if (pending->attemptCharged) {
+        refundAttempt(*pending);
+        pending->attemptCharged = false;
+    }
+    pending->response = errorResponse("Сервер перегружен, повторите позже");
+    pending->response["retryAfter"] = BUSY_RETRY_AFTER_SECONDS;
+    serveRequest(pending);
+}
+
+void Server::startConnection(int clientSocket) {
+    {
+        lock_guard<mutex> lock(connectionsMutex);
+        if (connectionSockets.size() >= MAX_CONNECTIONS) {
+            connectionsRejected++;
+            close(clientSocket);
+            logWarn("Слишком много соединений", {{"limit", MAX_CONNECTIONS}});
+            return;
+        }
+        connectionSockets.insert(clientSocket);
+        connectionThreads++;
+    }
+    // Определение протокола, рукопожатие и чтение запросов - в своём потоке
+    thread(&Server::serveConnection, this, clientSocket).detach();
+}
+
+void Server::serveConnection(int clientSocket) {
+    // Определение протокола, рукопожатие TLS и первый запрос укладываются в один
+    // срок: таймаут сокета отсчитывался бы заново на каждый полученный байт
+    const auto deadline = chrono::steady_clock::now() + chrono::seconds(CLIENT_READ_TIMEOUT_SECONDS);
+    
+    // TLS начинается с записи рукопожатия, JSON и бинарный протокол - иначе
+    unsigned char first = 0;
+    const bool readable = waitReadable(clientSocket, deadline) && recv(clientSocket, &first, 1, MSG_PEEK) > 0;
+    
+    Channel* channel;
+    PendingRequest* pending = nullptr;
+    if (readable && first == TLS_HANDSHAKE_RECORD && tlsContext) {
+        TlsChannel* tlsChannel = new TlsChannel(*tlsContext, clientSocket);
+        tlsChannel->setReadDeadline(deadline);
+        serveTlsConnection(tlsChannel);
+        channel = tlsChannel;
     } else {
-        json response;
-        response["status"] = "error";
-        response["message"] = "Неизвестное действие";
-        return response;
+        // Открытое соединение - один запрос: ответ и закрытие
+        channel = new Channel(clientSocket);
+        channel->setReadDeadline(deadline);
+        pending = readable ? receiveRequest(channel) : nullptr;
+    }
+    
+    // Сокет убирается из списка до закрытия: его номер может сразу занять другое соединение
+    {
+        lock_guard<mutex> lock(connectionsMutex);
+        connectionSockets.erase(clientSocket);
     }
+    if (pending) {
+        // Запрос дочитан, иначе закрытие сокета сбросит соединение вместе с ответом
+        if (requireTls && !pending->fromLoopback) {
+            // Попытка входа не выполняется - лимит попыток не тратит
+            if (pending->attemptCharged) {
+                refundAttempt(*pending);
+                pending->attemptCharged = false;
+            }
+            pending->response = errorResponse("Сервер принимает соединения только по TLS");
+            pending->spec = nullptr;
+        }
+        enqueue(pending);
+    } else {
+        delete channel;
+    }
+    
+    lock_guard<mutex> lock(connectionsMutex);
+    connectionThreads--;
+    connectionsClosed.notify_all();
 }
 
-void Server::handleClient(int clientSocket) {
-    char buffer[4096];
-    memset(buffer, 0, sizeof(buffer));
+void Server::serveTlsConnection(TlsChannel* channel) {
+    if (!channel->accept()) {
+        tlsFailed++;
+        logWarn("Рукопожатие TLS не удалось", {{"error", channel->error()}});
+        return;
+    }
+    (channel->resumed() ? tlsResumed : tlsHandshakes)++;
     
+    // Запросы одного соединения обрабатываются по очереди: следующий
+    // читается после отправки ответа на предыдущий. Между запросами клиент
+    // может молчать дольше, чем длится чтение запроса
+    while (true) {
+        channel->setReadDeadline(chrono::steady_clock::now() + chrono::seconds(KEEPALIVE_IDLE_SECONDS));
+        PendingRequest* pending = receiveRequest(channel);
+        if (!pending) {
+            break;
+        }
+        promise<bool> done;
+        future<bool> sent = done.get_future();
+        pending->done = &done;
+        enqueue(pending);
+        if (!sent.get()) {
+            break;
+        }
+    }
+}
+
+void Server::closeConnections() {
+    unique_lock<mutex> lock(connectionsMutex);
+    for (int socket : connectionSockets) {
+        shutdown(socket, SHUT_RDWR);  // поток соединения выйдет из чтения
+    }
+    connectionsClosed.wait(lock, [this] { return connectionThreads == 0; });
+}
+
+Server::PendingRequest* Server::receiveRequest(Channel* channel) {
     // Читаем запрос
-    int bytesRead = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
-    if (bytesRead <= 0) {
-        close(clientSocket);
+    PendingRequest* pending = new PendingRequest;
+    pending->channel = channel;
+    ReadStatus readStatus = readMessage(*channel, pending->body, pending->binary, MAX_MESSAGE_BYTES,
+                                        chrono::seconds(CLIENT_READ_TIMEOUT_SECONDS));
+    if (readStatus == ReadStatus::Closed || readStatus == ReadStatus::Timeout) {
+        delete pending;
+        return nullptr;
+    }
+    
+    // Время запроса считается от получения данных до отправки ответа
+    stats.beginRequest(pending->trace);
+    pending->peerAddress = peerAddress(channel->socket());
+    pending->fromLoopback = isLoopback(pending->peerAddress);
+    
+    if (readStatus == ReadStatus::TooLarge) {
+        pending->response = errorResponse("Запрос слишком большой");
+    } else if (readStatus == ReadStatus::Malformed) {
+        pending->response = errorResponse(pending->binary ? "Некорректный заголовок кадра" : "Запрос должен быть JSON-объектом");
+    } else {
+        pending->keepAlive = true;
+        ServerStats::TraceScope scope(pending->trace);
+        PhaseTimer timer(ServerStats::PHASE_PARSE);
+        // Текст ошибки разбора не содержит данных запроса, его можно логировать
+        string error = pending->binary ? pending->message.parseBinary(pending->body.data(), pending->body.size())
+                                       : pending->message.parse(pending->body.data(), pending->body.size());
+        if (!error.empty()) {
+            pending->response = errorResponse("Ошибка обработки запроса: " + error);
+            logWarn("Ошибка обработки запроса", {{"action", pending->action}, {"error", error}});
+        }
+        
+        const WireObject::Member* action = pending->message.find("action");
+        if (action && action->kind == WireObject::Kind::String) {
+            pending->action = string(action->value);
+            pending->spec = findAction(action->value);
+        }
+        
+        // Схема проверяется здесь, чтобы некорректный запрос не ждал в очереди KDF
+        if (pending->spec) {
+            error = pending->fields.bind(pending->spec->schema, pending->message);
+            if (!error.empty()) {
+                pending->response = errorResponse(error);
+                pending->spec = nullptr;
+            }
+        }
+        if (pending->spec && pending->spec->cost == CostClass::Kdf) {
+            chargeAttempt(*pending);
+        }
+    }
+    pending->queuedAt = chrono::steady_clock::now();
+    return pending;
+}
+
+// Лимит попыток проверяется до очереди KDF: отказ не стоит ни Argon2id,
+// ни места в очереди. Локальные клиенты ограничиваются только по имени
+void Server::chargeAttempt(PendingRequest& pending) {
+    chrono::nanoseconds retryAfter(0);
+    const string_view address = addressKey(pending.peerAddress);
+    const string_view username = pending.fields.str("username");
+    // Исход попытки ещё неизвестен, поэтому токен берётся из обоих лимитов
+    // учётной записи; после ответа лишний возвращается (см. settleAttempt)
+    bool allowed = pending.fromLoopback || addressLimiter.acquire(address, retryAfter);
+    if (allowed) {
+        if (!accountLimiter.acquire(username, retryAfter)) {
+            allowed = false;
+        } else if (!accountSuccessLimiter.acquire(username, retryAfter)) {
+            allowed = false;
+            accountLimiter.refund(username);
+        }
+        if (!allowed && !pending.fromLoopback) {
+            addressLimiter.refund(address);  // отказ по имени не тратит лимит адреса
+        }
+    }
+    if (allowed) {
+        pending.attemptCharged = true;
         return;
     }
     
+    const auto seconds = chrono::duration_cast<chrono::seconds>(retryAfter + chrono::seconds(1) - chrono::nanoseconds(1)).count();
+    pending.response = errorResponse("Слишком много попыток, повторите через " + to_string(seconds) + " с");
+    pending.response["retryAfter"] = seconds;
+    pending.spec = nullptr;
+}
+
+void Server::refundAttempt(const PendingRequest& pending) {
+    if (!pending.fromLoopback) {
+        addressLimiter.refund(addressKey(pending.peerAddress));
+    }
+    accountLimiter.refund(pending.fields.str("username"));
+    accountSuccessLimiter.refund(pending.fields.str("username"));
+}
+
+// Попытка выполнена: лимит адреса остаётся потраченным при любом исходе,
+// из лимитов учётной записи - только тот, что соответствует исходу
+void Server::settleAttempt(const PendingRequest& pending, bool succeeded) {
+    if (succeeded) {
+        accountLimiter.refund(pending.fields.str("username"));
+    } else {
+        accountSuccessLimiter.refund(pending.fields.str("username"));
+    }
+}
+
+void Server::serveRequest(PendingRequest* pending) {
+    ServerStats::TraceScope scope(pending->trace);
+    ServerStats::addPhase(pending->trace, ServerStats::PHASE_QUEUE, chrono::steady_clock::now() - pending->queuedAt);
+    Channel* channel = pending->channel;
+    string status = "error";
+    bool sent = false;
+    
     try {
-        // Парсим JSON запрос
-        json request = json::parse(buffer);
-        
         // Обрабатываем запрос
-        json response = processRequest(request);
+        json response = pending->response.is_null() ? processRequest(*pending) : pending->response;
+        status = response.value("status", "error");
+        if (pending->attemptCharged) {
+            settleAttempt(*pending, status != "error");
+        }
         
         // Отправляем ответ
-        string responseStr = response.dump();
-        send(clientSocket, responseStr.c_str(), responseStr.length(), 0);
+        string responseStr;
+        {
+            PhaseTimer timer(ServerStats::PHASE_SERIALIZE);
+            responseStr = (pending->binary ? binaryWireCodec() : defaultWireCodec()).encode(response);
+        }
+        PhaseTimer timer(ServerStats::PHASE_SEND);
+        sent = channel->sendAll(responseStr.data(), responseStr.size());
         
     } catch (const exception& e) {
-        json errorResponse;
-        errorResponse["status"] = "error";
-        errorResponse["message"] = string("Ошибка обработки запроса: ") + e.what();
-        
-        string responseStr = errorResponse.dump();
-        send(clientSocket, responseStr.c_str(), responseStr.length(), 0);
+        json response = errorResponse(string("Ошибка обработки запроса: ") + e.what());
+        string responseStr = pending->binary ? binaryWireCodec().encode(response) : response.dump();
+        sent = channel->sendAll(responseStr.data(), responseStr.size());
+        status = "error";
+        if (const auto* jsonError = dynamic_cast<const json::exception*>(&e)) {
+            logWarn("Ошибка обработки запроса", {{"action", pending->action}, {"json_error", jsonError->id}});
+        } else {
+            logWarn("Ошибка обработки запроса", {{"action", pending->action}, {"error", e.what()}});
+        }
     }
     
-    close(clientSocket);
+    stats.endRequest(pending->trace, pending->action, status);
+    promise<bool>* done = pending->done;
+    const bool keepAlive = sent && pending->keepAlive;
+    delete pending;
+    if (done) {
+        // Соединение TLS читает следующий запрос в своём потоке
+        done->set_value(keepAlive);
+    } else {
+        delete channel;
+    }
 }
 
 bool Server::initialize() {
@@ -523,17 +1073,35 @@ bool Server::initialize() {
     }
     testFile.close();
     
+    // Индекс имён для checkUser
+    {
+        HashTableUsers users;
+        loadUsers(users);
+        for (const auto& item : users.items()) {
+            usernames.insert(get<0>(item));
+        }
+    }
+    
+    // Сертификат TLS: самоподписанный создаётся при первом запуске,
+    // клиенты получают файл сертификата как доверенный
+    try {
+        tlsContext = TlsContext::createServer(tlsCertPath, tlsKeyPath);
+    } catch (const exception& e) {
+        logError("Не удалось настроить TLS", {{"error", e.what()}});
+        return false;
+    }
+    
     // Создаем сокет
     serverSocket = socket(AF_INET, SOCK_STREAM, 0);
     if (serverSocket < 0) {
-        cerr << "Ошибка: не удалось создать сокет" << endl;
+        logError("Не удалось создать сокет", {{"error", strerror(errno)}});
         return false;
     }
     
     // Настраиваем опции сокета
     int opt = 1;
     if (setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        cerr << "Ошибка: не удалось установить опции сокета" << endl;
+        logError("Не удалось установить опции сокета", {{"error", strerror(errno)}});
         return false;
     }
     
@@ -544,25 +1112,31 @@ bool Server::initialize() {
     serverAddr.sin_port = htons(port);
     
     if (bind(serverSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
-        cerr << "Ошибка: не удалось привязать сокет к порту " << port << endl;
-        cerr << "Возможно, порт уже используется другим процессом" << endl;
+        // Чаще всего порт уже занят другим процессом
+        logError("Не удалось привязать сокет к порту", {{"port", port}, {"error", strerror(errno)}});
         return false;
     }
     
     // Начинаем прослушивание
     if (listen(serverSocket, 5) < 0) {
-        cerr << "Ошибка: не удалось начать прослушивание сокета" << endl;
+        logError("Не удалось начать прослушивание сокета", {{"error", strerror(errno)}});
         return false;
     }
     
-    cout << "Сервер инициализирован на порту " << port << endl;
+    logInfo("Сервер инициализирован", {{"port", port}, {"tls_certificate", tlsCertPath}, {"require_tls", requireTls}});
+    if (!requireTls) {
+        // Пароли по открытому протоколу идут без шифрования
+        logWarn("Открытый протокол принимается с любых адресов", {{"hint", "--require-tls"}});
+    }
     return true;
 }
 
 void Server::start() {
-    cout << "Сервер запущен и ожидает подключений..." << endl;
+    kdfLane.start();
+    fastLane.start();
+    logInfo("Сервер запущен и ожидает подключений");
     
-    while (true) {
+    while (serverSocket >= 0) {
         sockaddr_in clientAddr;
         socklen_t clientLen = sizeof(clientAddr);
         
@@ -571,9 +1145,14 @@ void Server::start() {
             continue;
         }
         
-        // Обрабатываем клиента
-        handleClient(clientSocket);
+        // Запрос читается в потоке соединения и встаёт в очередь по цене обработки
+        startConnection(clientSocket);
     }
+    
+    // Уже принятые запросы дорабатываются до остановки очередей
+    closeConnections();
+    kdfLane.stop();
+    fastLane.stop();
 }
 
 void Server::stop() {
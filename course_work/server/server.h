@@ -1,42 +1,154 @@
 #ifndef SERVER_H
 #define SERVER_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include "json.hpp"
+#include "serverStats.h"
+#include "requestLane.h"
+#include "usernameIndex.h"
+#include "rateLimiter.h"
+#include "requestSchema.h"
+
+class HashTableUsers;
+class Channel;
+class TlsContext;
+class TlsChannel;
+struct ActionTable;
 
 class Server {
+public:
+    // Цена обработки: Kdf - Argon2id или SHA-512 секрета, Cheap - без них
+    enum class CostClass { Cheap, Kdf };
+
+    // Действие протокола. Поля запроса проверяются по схеме сразу после
+    // разбора, обработчик получает их готовыми. Изменяющие и дорогие действия
+    // идут в очередь KDF, дешёвые только на чтение - в быструю очередь
+    struct ActionSpec {
+        std::string_view name;
+        nlohmann::json (Server::*handler)(const RequestView&);
+        RequestSchema schema;
+        CostClass cost;
+        bool mutates;
+        bool localOnly;  // только с 127.0.0.0/8
+    };
+
+    static const ActionSpec* findAction(std::string_view name);
+    static std::vector<std::string> actionNames();
+
 private:
+    friend struct ActionTable;
+
+    // Запрос, прочитанный из соединения и ждущий обработки в очереди
+    struct PendingRequest {
+        Channel* channel = nullptr;        // закрывается после ответа, если done == nullptr
+        std::promise<bool>* done = nullptr; // соединение TLS ждёт ответа, чтобы читать следующий запрос
+        bool keepAlive = false;            // границы запроса известны - соединение можно продолжать
+        uint32_t peerAddress = 0;          // IPv4 клиента, 0 - не IPv4
+        bool fromLoopback = false;
+        bool attemptCharged = false;       // взят токен лимита попыток
+        bool binary = false;               // запрос и ответ - в бинарном протоколе
+        std::string action = "invalid";
+        const ActionSpec* spec = nullptr;  // nullptr - неизвестное действие
+        std::string body;                  // запрос из сокета, разбирается на месте
+        WireObject message;                // ключи и значения ссылаются на body
+        RequestView fields;                // поля по схеме spec, тоже ссылаются на body
+        nlohmann::json response;           // заполнен, если запрос не разобран
+        ServerStats::RequestTrace trace;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
     std::string usersFilePath;
     std::string vaultDirectory;
     int port;
     int serverSocket;
+    ServerStats stats;
+    
+    // Очередь KDF - один поток: последовательное выполнение изменяющих запросов
+    // заменяет блокировку read-modify-write users.json и CAS версии хранилища.
+    // Быстрая очередь выполняет дешёвые запросы только на чтение
+    RequestLane kdfLane;
+    RequestLane fastLane;
+    // Согласованное чтение файлов из быстрой очереди, пока очередь KDF их пишет
+    std::shared_mutex storageMutex;
+    // Имена пользователей для checkUser без обращения к диску
+    UsernameIndex usernames;
+    // Лимиты попыток действий с KDF: по адресу клиента (все попытки) и по имени
+    // пользователя (неудачные и успешные отдельно)
+    RateLimiter addressLimiter;
+    RateLimiter accountLimiter;
+    RateLimiter accountSuccessLimiter;
+    
+    // Соединение читается в своём потоке, а не в потоке приёма: медленный
+    // клиент не задерживает остальных. TLS на том же порту узнаётся по первому
+    // байту, сертификат создаётся при первом запуске. Соединение TLS обслуживает
+    // запросы одно за другим, чтобы рукопожатие не повторялось на каждый запрос
+    std::string tlsCertPath;
+    std::string tlsKeyPath;
+    bool requireTls;  // открытый протокол - только с 127.0.0.0/8
+    TlsContext* tlsContext;
+    std::mutex connectionsMutex;
+    std::condition_variable connectionsClosed;
+    std::set<int> connectionSockets;  // читаемые соединения - для закрытия при остановке
+    int connectionThreads;
+    std::atomic<uint64_t> connectionsRejected;
+    std::atomic<uint64_t> tlsHandshakes;
+    std::atomic<uint64_t> tlsResumed;
+    std::atomic<uint64_t> tlsFailed;
     
     // Вспомогательные функции
+    void loadUsers(HashTableUsers& users);
+    void saveUsers(const HashTableUsers& users);
     std::string getUserVaultPath(const std::string& username);
     bool createUserVault(const std::string& username, const std::vector<unsigned char>& encryptedData);
     std::vector<unsigned char> readUserVault(const std::string& username);
-    bool updateUserVault(const std::string& username, const std::vector<unsigned char>& encryptedData);
+    std::vector<unsigned char> readUserVault(const std::string& username, uint64_t& version);
+    bool updateUserVault(const std::string& username, const std::vector<unsigned char>& encryptedData, uint64_t version);
+    uint64_t readVaultVersion(const std::string& username);
+    bool writeVaultFile(const std::string& username, const std::vector<unsigned char>& encryptedData, uint64_t version);
     
     // Обработчики запросов
-    nlohmann::json handleRegister(const nlohmann::json& request);
-    nlohmann::json handleLogin(const nlohmann::json& request);
-    nlohmann::json handleChangePassword(const nlohmann::json& request);
-    nlohmann::json handleRecoverPassword(const nlohmann::json& request);
-    nlohmann::json handleGetVault(const nlohmann::json& request);
-    nlohmann::json handleGetVaultWithSeedPhrase(const nlohmann::json& request);
-    nlohmann::json handleUpdateVault(const nlohmann::json& request);
+    nlohmann::json handleRegister(const RequestView& request);
+    nlohmann::json handleLogin(const RequestView& request);
+    nlohmann::json handleChangePassword(const RequestView& request);
+    nlohmann::json handleRecoverPassword(const RequestView& request);
+    nlohmann::json handleGetVault(const RequestView& request);
+    nlohmann::json handleGetVaultWithSeedPhrase(const RequestView& request);
+    nlohmann::json handleUpdateVault(const RequestView& request);
+    nlohmann::json handleCheckUser(const RequestView& request);
+    nlohmann::json handleStats(const RequestView& request);
     
     // Обработка клиентских соединений
-    void handleClient(int clientSocket);
-    nlohmann::json processRequest(const nlohmann::json& request);
+    void startConnection(int clientSocket);
+    void serveConnection(int clientSocket);
+    void serveTlsConnection(TlsChannel* channel);
+    void closeConnections();
+    PendingRequest* receiveRequest(Channel* channel);
+    void chargeAttempt(PendingRequest& pending);
+    void refundAttempt(const PendingRequest& pending);
+    void settleAttempt(const PendingRequest& pending, bool succeeded);
+    RequestLane& laneFor(const ActionSpec* spec);
+    void enqueue(PendingRequest* pending);
+    void serveRequest(PendingRequest* pending);
+    nlohmann::json processRequest(const PendingRequest& pending);
     
 public:
     Server(int port = 8080, const std::string& usersFile = "users.json", 
            const std::string& vaultDir = "server_vaults");
     ~Server();
     
+    void setRequireTls(bool required) { requireTls = required; }
+    
     bool initialize();
     void start();
     void stop();
@@ -0,0 +1,126 @@
+#include "serverStats.h"
+
+using namespace std;
+using json = nlohmann::json;
+using Clock = chrono::steady_clock;
+
+namespace {
+
+const char* const PHASE_NAMES[ServerStats::PHASE_COUNT] = {
+    "parse", "queue", "users", "kdf", "vault_io", "serialize", "send"
+};
+
+thread_local ServerStats::RequestTrace* currentTrace = nullptr;
+
+uint64_t toMicros(Clock::duration d) {
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(d).count());
+}
+
+} // namespace
+
+ServerStats::TraceScope::TraceScope(RequestTrace& trace) : previous(currentTrace) {
+    currentTrace = &trace;
+}
+
+ServerStats::TraceScope::~TraceScope() {
+    currentTrace = previous;
+}
+
+ServerStats::PhaseTimer::PhaseTimer(Phase phase) : trace(currentTrace), phase(phase), outermost(false) {
+    if (trace) {
+        outermost = trace->activeTimers++ == 0;
+        if (outermost) {
+            start = Clock::now();
+        }
+    }
+}
+
+ServerStats::PhaseTimer::~PhaseTimer() {
+    if (!trace) {
+        return;
+    }
+    trace->activeTimers--;
+    if (outermost) {
+        trace->phases[phase] += Clock::now() - start;
+        trace->seen[phase] = true;
+    }
+}
+
+// Чужие значения action не должны раздувать таблицу, поэтому набор ключей фиксирован
+ServerStats::ServerStats(const vector<string>& trackedActions) : inFlight(0), startedAt(Clock::now()) {
+    for (const auto& action : trackedActions) {
+        actions[action];
+    }
+    actions["unknown"];
+    actions["invalid"];
+}
+
+void ServerStats::beginRequest(RequestTrace& trace) {
+    trace.start = Clock::now();
+    inFlight++;
+}
+
+void ServerStats::addPhase(RequestTrace& trace, Phase phase, Clock::duration elapsed) {
+    trace.phases[phase] += elapsed;
+    trace.seen[phase] = true;
+}
+
+void ServerStats::endRequest(const RequestTrace& trace, const string& action, const string& status) {
+    inFlight--;
+    const auto elapsed = Clock::now() - trace.start;
+
+    lock_guard<mutex> lock(statsMutex);
+    auto it = actions.find(action);
+    if (it == actions.end()) {
+        it = actions.find("unknown");
+    }
+    ActionStats& stats = it->second;
+    stats.requests++;
+    if (status == "conflict") {
+        stats.conflicts++;
+    } else if (status != "success") {
+        stats.errors++;
+    }
+    stats.total.record(toMicros(elapsed));
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        if (trace.seen[phase]) {
+            stats.phases[phase].record(toMicros(trace.phases[phase]));
+        }
+    }
+}
+
+json ServerStats::snapshot(bool withHistograms) const {
+    json result;
+    result["uptime_s"] = chrono::duration<double>(Clock::now() - startedAt).count();
+    result["in_flight"] = inFlight.load();
+
+    lock_guard<mutex> lock(statsMutex);
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    json byAction = json::object();
+    for (const auto& [name, stats] : actions) {
+        requests += stats.requests;
+        errors += stats.errors;
+        if (stats.requests == 0) {
+            continue;
+        }
+
+        json entry;
+        entry["requests"] = stats.requests;
+        entry["errors"] = stats.errors;
+        entry["conflicts"] = stats.conflicts;
+        entry["latency_us"] = stats.total.summary(withHistograms);
+        json phases = json::object();
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            if (stats.phases[phase].count() != 0) {
+                phases[PHASE_NAMES[phase]] = stats.phases[phase].summary(withHistograms);
+            }
+        }
+        entry["phases_us"] = phases;
+        byAction[name] = entry;
+    }
+    result["requests"] = requests;
+    result["errors"] = errors;
+    result["actions"] = byAction;
+    return result;
+}
@@ -0,0 +1,98 @@
+#ifndef COURSEWORK_SERVER_STATS_H
+#define COURSEWORK_SERVER_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "latencyHistogram.h"
+
+// Счётчики и гистограммы задержек сервера: по каждому действию - число запросов,
+// ошибок и конфликтов, полное время обработки и время по фазам; плюс число
+// запросов в обработке. Снимок отдаёт действие "stats" (только с loopback).
+class ServerStats {
+public:
+    enum Phase {
+        PHASE_PARSE,      // разбор JSON запроса
+        PHASE_QUEUE,      // ожидание в очереди планировщика
+        PHASE_USERS,      // загрузка, поиск и сохранение таблицы пользователей
+        PHASE_KDF,        // Argon2id пароля, SHA-512 фразы восстановления
+        PHASE_VAULT_IO,   // чтение и запись файлов хранилища и версии
+        PHASE_SERIALIZE,  // hex хранилища и JSON ответа
+        PHASE_SEND,       // отправка ответа клиенту
+        PHASE_COUNT
+    };
+
+    // Время фаз одного запроса. Фаза может встретиться несколько раз
+    // (смена пароля: SHA-512 фразы и Argon2id нового пароля) - время суммируется
+    struct RequestTrace {
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::duration phases[PHASE_COUNT] = {};
+        bool seen[PHASE_COUNT] = {};
+        int activeTimers = 0;
+    };
+
+    // Делает trace текущим запросом этого потока на время своей жизни:
+    // запрос читается в потоке приёма, а обрабатывается в рабочем потоке очереди
+    class TraceScope {
+    private:
+        RequestTrace* previous;
+
+    public:
+        explicit TraceScope(RequestTrace& trace);
+        ~TraceScope();
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+    };
+
+    // Засекает фазу текущего запроса этого потока. Вложенный таймер ничего
+    // не делает (время уже идёт внешнему), вне запроса - тоже
+    class PhaseTimer {
+    private:
+        RequestTrace* trace;
+        Phase phase;
+        bool outermost;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        explicit PhaseTimer(Phase phase);
+        ~PhaseTimer();
+
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+    };
+
+    // Учитываемые действия; всё незнакомое идёт в "unknown", неразобранное - в "invalid"
+    explicit ServerStats(const std::vector<std::string>& trackedActions);
+
+    // Начало запроса - после чтения из сокета, конец - после отправки ответа.
+    // status - поле status ответа ("success", "error", "conflict")
+    void beginRequest(RequestTrace& trace);
+    void endRequest(const RequestTrace& trace, const std::string& action, const std::string& status);
+
+    // Время фазы, замеренное не PhaseTimer (например, ожидание в очереди)
+    static void addPhase(RequestTrace& trace, Phase phase, std::chrono::steady_clock::duration elapsed);
+
+    nlohmann::json snapshot(bool withHistograms) const;
+
+private:
+    struct ActionStats {
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+        uint64_t conflicts = 0;
+        LatencyHistogram total;
+        LatencyHistogram phases[PHASE_COUNT];
+    };
+
+    mutable std::mutex statsMutex;
+    std::map<std::string, ActionStats> actions;  // набор ключей фиксирован в конструкторе
+    std::atomic<int64_t> inFlight;
+    std::chrono::steady_clock::time_point startedAt;
+};
+
+#endif // COURSEWORK_SERVER_STATS_H
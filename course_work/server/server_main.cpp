@@ -1,5 +1,6 @@
 #include "server.h"
-#include <iostream>
+#include "common_utils.h"
+#include "logger.h"
 #include <signal.h>
 
 using namespace std;
@@ -7,7 +8,7 @@ using namespace std;
 Server* globalServer = nullptr;
 
 void signalHandler(int signum) {
-    cout << "\nПолучен сигнал прерывания (" << signum << "). Остановка сервера..." << endl;
+    logInfo("Получен сигнал прерывания, остановка сервера", {{"signal", signum}});
     if (globalServer) {
         globalServer->stop();
     }
@@ -16,22 +17,34 @@ void signalHandler(int signum) {
 
 int main(int argc, char* argv[]) {
     int port = 8080;
+    bool requireTls = false;
     
-    if (argc > 1) {
-        port = atoi(argv[1]);
+    if (!initCryptoRuntime()) {
+        logError("Ошибка инициализации libsodium");
+        return 1;
+    }
+    
+    // password_server [порт] [--require-tls]
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--require-tls") {
+            requireTls = true;
+        } else {
+            port = atoi(argv[i]);
+        }
     }
     
-    cout << "Запуск сервера на порту " << port << "..." << endl;
+    logInfo("Запуск сервера", {{"port", port}});
     
     // Настраиваем обработчик сигналов
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
     
     Server server(port);
+    server.setRequireTls(requireTls);
     globalServer = &server;
     
     if (!server.initialize()) {
-        cerr << "Не удалось инициализировать сервер" << endl;
+        logError("Не удалось инициализировать сервер");
         return 1;
     }
     
@@ -0,0 +1,101 @@
+#include "usernameIndex.h"
+
+#include <functional>
+#include <mutex>
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace {
+
+// Второй хеш для двойного хеширования (Kirsch-Mitzenmacher) из первого
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+UsernameIndex::UsernameIndex() : plannedNames(0), lookups(0), filterRejects(0), falsePositives(0) {
+    resizeFilter(MIN_PLANNED_NAMES);
+}
+
+void UsernameIndex::resizeFilter(size_t planned) {
+    plannedNames = planned;
+    bloom.assign((planned * BITS_PER_NAME + 63) / 64, 0);
+    for (const auto& name : names) {
+        addToFilter(name);
+    }
+}
+
+void UsernameIndex::addToFilter(string_view username) {
+    const uint64_t bits = bloom.size() * 64;
+    const uint64_t h1 = hash<string_view>()(username);
+    const uint64_t h2 = mix(h1) | 1;
+    for (int i = 0; i < HASH_COUNT; i++) {
+        const uint64_t bit = (h1 + i * h2) % bits;
+        bloom[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+bool UsernameIndex::mayContain(string_view username) const {
+    const uint64_t bits = bloom.size() * 64;
+    const uint64_t h1 = hash<string_view>()(username);
+    const uint64_t h2 = mix(h1) | 1;
+    for (int i = 0; i < HASH_COUNT; i++) {
+        const uint64_t bit = (h1 + i * h2) % bits;
+        if (!(bloom[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void UsernameIndex::insert(const string& username) {
+    unique_lock<shared_mutex> lock(indexMutex);
+    if (!names.insert(username).second) {
+        return;
+    }
+    if (names.size() > plannedNames) {
+        resizeFilter(plannedNames * 2);
+    } else {
+        addToFilter(username);
+    }
+}
+
+bool UsernameIndex::contains(string_view username) const {
+    lookups.fetch_add(1, memory_order_relaxed);
+    shared_lock<shared_mutex> lock(indexMutex);
+    if (!mayContain(username)) {
+        filterRejects.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    // Строка создаётся только для имён, прошедших фильтр
+    if (names.count(string(username)) == 0) {
+        falsePositives.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+size_t UsernameIndex::size() const {
+    shared_lock<shared_mutex> lock(indexMutex);
+    return names.size();
+}
+
+json UsernameIndex::snapshot() const {
+    json result;
+    {
+        shared_lock<shared_mutex> lock(indexMutex);
+        result["names"] = names.size();
+        result["filter_bits"] = bloom.size() * 64;
+    }
+    result["lookups"] = lookups.load(memory_order_relaxed);
+    result["filter_rejects"] = filterRejects.load(memory_order_relaxed);
+    result["false_positives"] = falsePositives.load(memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,48 @@
+#ifndef COURSEWORK_USERNAME_INDEX_H
+#define COURSEWORK_USERNAME_INDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "json.hpp"
+
+// Имена зарегистрированных пользователей в памяти для действия checkUser:
+// ответ без чтения users.json и без KDF. Перед множеством стоит фильтр Блума -
+// большинство проверяемых при регистрации имён свободны, и для них хватает
+// нескольких битов без хеширования строки в множестве.
+// Заполняется при старте из users.json, пополняется при регистрации.
+class UsernameIndex {
+public:
+    UsernameIndex();
+
+    void insert(const std::string& username);
+    bool contains(std::string_view username) const;
+    size_t size() const;
+
+    nlohmann::json snapshot() const;
+
+private:
+    static constexpr size_t BITS_PER_NAME = 10;  // ~1% ложных срабатываний при 7 хешах
+    static constexpr int HASH_COUNT = 7;
+    static constexpr size_t MIN_PLANNED_NAMES = 1 << 16;
+
+    mutable std::shared_mutex indexMutex;
+    std::unordered_set<std::string> names;
+    std::vector<uint64_t> bloom;
+    size_t plannedNames;  // при превышении фильтр перестраивается вдвое больше
+
+    mutable std::atomic<uint64_t> lookups;
+    mutable std::atomic<uint64_t> filterRejects;
+    mutable std::atomic<uint64_t> falsePositives;
+
+    void resizeFilter(size_t planned);
+    void addToFilter(std::string_view username);
+    bool mayContain(std::string_view username) const;
+};
+
+#endif // COURSEWORK_USERNAME_INDEX_H